@@ -0,0 +1,142 @@
+/*
+ * FledgePower HNZ <-> pivot filter chatter filter.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_CHATTER_FILTER_H
+#define _HNZ_PIVOT_CHATTER_FILTER_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Detection of the TS points changing state too often (chatter, e.g. a faulty contact).
+ *
+ * The transitions (TS CE) of each point are counted over a sliding window of their timestamp (do_ts), estimated
+ * from the count of the current and of the previous window as the window slides. When a point exceeds the maximum
+ * number of transitions, its next transition is forwarded flagged as oscillatory and the following ones are
+ * suppressed, the last one being kept, until its transition count falls back to half of the maximum: the point is
+ * then released, either by its next transition or by the periodic check of the chattering points, which returns
+ * the last transition suppressed so that the final state of the point is not lost.
+ * The state of the points is kept in a flat array indexed by the point index of the configuration.
+ */
+class HnzPivotChatterFilter
+{
+public:
+    enum class Decision {
+        FORWARD,             // Point not chattering
+        FORWARD_OSCILLATORY, // Point starting to chatter, forwarded with the oscillatory flag
+        SUPPRESS             // Point chattering
+    };
+
+    /**
+     * Content of a TS transition, kept for the last transition suppressed of each point
+     */
+    struct Transition {
+        bool hasValue = false;
+        bool value = false;
+        unsigned int valid = 0;
+        bool outdated = false;
+        bool hasTs = false;
+        uint64_t ts = 0;
+        bool tsIv = false;
+        bool tsC = false;
+        bool tsS = false;
+        // Received later than the data age threshold
+        bool late = false;
+    };
+
+    /**
+     * Last transition suppressed of a point released
+     */
+    struct Released {
+        size_t pointIndex;
+        Transition transition;
+    };
+
+    /**
+     * @param maxTransitions : Maximum number of transitions of a point within the window, 0 to disable the filter
+     * @param windowMs : Duration of the window in milliseconds
+    */
+    void setLimits(unsigned int maxTransitions, uint64_t windowMs);
+    unsigned int getMaxTransitions() const {return m_maxTransitions;}
+    uint64_t getWindowMs() const {return m_windowMs;}
+    bool isEnabled() const {return m_maxTransitions > 0;}
+
+    /**
+     * Forget the state of all points
+     * @param pointCount : Number of points of the configuration
+    */
+    void reset(size_t pointCount);
+
+    /**
+     * Move the state of the points to their index in a new configuration
+     * @param pointIndexes : Index of each point in the new configuration, as filled by HNZPivotConfig::mapPointIndexes,
+     * the state of the points without index is forgotten
+     * @param pointCount : Number of points of the new configuration
+    */
+    void remap(const std::vector<size_t>& pointIndexes, size_t pointCount);
+
+    /**
+     * Forget the state of a point, on a quality change: its last transition suppressed is not forwarded
+     * @param pointIndex : Index of the point in [0, pointCount)
+    */
+    void discard(size_t pointIndex);
+
+    /**
+     * Count a transition of a point
+     * @param pointIndex : Index of the point in [0, pointCount)
+     * @param tsMs : Timestamp of the transition in milliseconds
+     * @param arrivalMs : Time the transition was received in milliseconds
+     * @param transition : Content of the transition, kept if it is suppressed
+     * @return What to do with the transition
+    */
+    Decision onTransition(size_t pointIndex, uint64_t tsMs, uint64_t arrivalMs, const Transition& transition);
+
+    /**
+     * Release the chattering points whose transition count fell back to half of the maximum
+     * @param nowMs : Current time in milliseconds, on the clock of the arrival times
+     * @param released : Filled with the last transition suppressed of the points released, if any
+    */
+    void release(uint64_t nowMs, std::vector<Released>& released);
+
+    bool isChattering(size_t pointIndex) const {return pointIndex < m_points.size() && m_points[pointIndex].chattering;}
+    /**
+     * @return Number of points currently chattering
+    */
+    size_t getChatteringCount() const {return m_chatteringPoints.size();}
+
+private:
+    struct PointState {
+        uint64_t windowStartMs = 0;
+        uint32_t currentCount = 0;
+        uint32_t previousCount = 0;
+        bool chattering = false;
+        // Timestamp and arrival time of the last transition, to estimate the timestamp of the current time
+        uint64_t lastTsMs = 0;
+        uint64_t lastArrivalMs = 0;
+        bool suppressed = false;
+        Transition lastSuppressed;
+    };
+
+    /**
+     * Slide the window of a point to a timestamp
+     * @return Transitions within the sliding window ending at this timestamp
+    */
+    uint64_t m_slide(PointState& point, uint64_t tsMs) const;
+    void m_leave(size_t pointIndex);
+
+    unsigned int m_maxTransitions = 0;
+    uint64_t m_windowMs = 1000;
+    std::vector<PointState> m_points;
+    // Indexes of the chattering points
+    std::vector<size_t> m_chatteringPoints;
+};
+
+#endif /* _HNZ_PIVOT_CHATTER_FILTER_H */
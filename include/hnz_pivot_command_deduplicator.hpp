@@ -0,0 +1,73 @@
+/*
+ * FledgePower HNZ <-> pivot filter command deduplicator.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_COMMAND_DEDUPLICATOR_H
+#define _HNZ_PIVOT_COMMAND_DEDUPLICATOR_H
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+/**
+ * Detection of the pivot commands sent twice in a row (e.g. double click on an HMI): a command with the same
+ * point and value as a command accepted less than the window ago is a duplicate.
+ * The last accepted commands are kept in a small direct-mapped table indexed by the point index of the
+ * configuration, two points sharing an entry only make the detection miss duplicates.
+ */
+class HnzPivotCommandDeduplicator
+{
+public:
+    static constexpr size_t TABLE_SIZE = 64;
+
+    HnzPivotCommandDeduplicator() {reset();}
+
+    /**
+     * @param windowMs : Duration of the window in milliseconds, 0 to disable the detection
+    */
+    void setWindowMs(uint64_t windowMs) {m_windowMs = windowMs;}
+    uint64_t getWindowMs() const {return m_windowMs;}
+    bool isEnabled() const {return m_windowMs > 0;}
+
+    /**
+     * Check if a command is a duplicate, the command is recorded if it is not
+     * @param pointIndex : Index of the point targeted by the command
+     * @param value : Value of the command
+     * @param nowMs : Time of the command in milliseconds
+     * @return True if the command is a duplicate and has to be dropped
+    */
+    bool isDuplicate(size_t pointIndex, long value, uint64_t nowMs);
+
+    /**
+     * Forget all commands, point indexes are only valid for the configuration they come from
+    */
+    void reset();
+
+    /**
+     * Move the commands recorded to the index of their point in a new configuration
+     * @param pointIndexes : Index of each point in the new configuration, as filled by HNZPivotConfig::mapPointIndexes,
+     * the commands of the points without index are forgotten
+     * @param pointCount : Number of points of the new configuration
+    */
+    void remap(const std::vector<size_t>& pointIndexes, size_t pointCount);
+
+private:
+    struct Entry {
+        size_t pointIndex;
+        long value;
+        uint64_t timeMs;
+    };
+
+    uint64_t m_windowMs = 0;
+    std::array<Entry, TABLE_SIZE> m_entries;
+};
+
+#endif /* _HNZ_PIVOT_COMMAND_DEDUPLICATOR_H */
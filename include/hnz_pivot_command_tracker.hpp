@@ -0,0 +1,122 @@
+/*
+ * FledgePower HNZ <-> pivot filter command tracker.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_COMMAND_TRACKER_H
+#define _HNZ_PIVOT_COMMAND_TRACKER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "hnz_pivot_histogram.hpp"
+
+class Datapoint;
+
+/**
+ * Round-trip time of the commands going through the filter.
+ *
+ * Each command sent (PivotCommand converted to an HNZ command) is kept as pending with the time it was sent,
+ * until the ACK of the same point comes back (TC/TVC ACK converted to pivot): the time elapsed is then recorded
+ * in a histogram, in microseconds. A command not acknowledged within the timeout is counted as timed out and
+ * forgotten.
+ * Several commands sent to the same point are matched with their ACKs in the order they were sent.
+ * The pending commands are kept in a flat array indexed by the point index of the configuration, each point
+ * expiring its own commands when it is used again. Commands and ACKs are tracked from one thread at a time
+ * (the conversion of the filter), the counters can be read from any thread.
+ */
+class HnzPivotCommandTracker
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Counter {
+        SENT,
+        ACKNOWLEDGED,
+        TIMED_OUT,     // Commands not acknowledged within the timeout
+        UNEXPECTED_ACK // ACKs received for no pending command
+    };
+    static constexpr int COUNTER_COUNT = 4;
+
+    HnzPivotCommandTracker();
+    HnzPivotCommandTracker(const HnzPivotCommandTracker& other) = delete;
+    HnzPivotCommandTracker& operator=(const HnzPivotCommandTracker& other) = delete;
+
+    /**
+     * Move the pending commands to the index of their point in a new configuration
+     * @param pointIndexes : Index of each point in the new configuration, as filled by HNZPivotConfig::mapPointIndexes,
+     * the pending commands of the points without index are forgotten
+     * @param pointCount : Number of points of the new configuration
+    */
+    void remap(const std::vector<size_t>& pointIndexes, size_t pointCount);
+
+    /**
+     * Start tracking a command
+     * @param pointIndex : Index of the point of the command in [0, pointCount)
+     * @param now : Time the command is sent
+    */
+    void commandSent(size_t pointIndex, Clock::time_point now);
+
+    /**
+     * Match an ACK with the oldest pending command of the same point
+     * @param pointIndex : Index of the point of the ACK in [0, pointCount)
+     * @param now : Time the ACK is received
+     * @return True if the round-trip time of a command was recorded
+    */
+    bool ackReceived(size_t pointIndex, Clock::time_point now);
+
+    /**
+     * Forget the pending commands sent more than the timeout ago, counting them as timed out
+     * @param now : Current time
+    */
+    void expire(Clock::time_point now);
+
+    void setTimeout(std::chrono::milliseconds timeout) {m_timeout = timeout;}
+    std::chrono::milliseconds getTimeout() const {return m_timeout;}
+    size_t getPendingCount() const {return m_pendingCount.load(std::memory_order_relaxed);}
+    uint64_t get(Counter counter) const {return m_counters[static_cast<int>(counter)].load(std::memory_order_relaxed);}
+    HnzPivotHistogram::Snapshot getRoundTripSnapshot() const {return m_roundTrip.snapshot();}
+    void reset();
+
+    /**
+     * Build a datapoint holding the counters, the number of pending commands and a summary of the round-trip times
+     * @param name : Name of the datapoint to create
+     * @return Newly allocated datapoint
+    */
+    Datapoint* toDatapoint(const std::string& name) const;
+
+    static std::string CounterStr(Counter counter);
+
+private:
+    struct PointState {
+        /* Time each pending command was sent, in the order they were sent */
+        std::vector<Clock::time_point> pending;
+        /* Listed in m_pendingPoints */
+        bool listed = false;
+    };
+
+    void m_increment(Counter counter) {m_counters[static_cast<int>(counter)].fetch_add(1, std::memory_order_relaxed);}
+    /* Forget the pending commands of a point sent more than the timeout ago */
+    void m_expire(PointState& point, Clock::time_point now);
+
+    std::vector<PointState> m_points;
+    /* Indexes of the points which had pending commands when last checked */
+    std::vector<size_t> m_pendingPoints;
+    std::atomic<size_t> m_pendingCount{0};
+    std::atomic<std::chrono::milliseconds> m_timeout;
+
+    HnzPivotHistogram m_roundTrip;
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> m_counters;
+};
+
+#endif /* _HNZ_PIVOT_COMMAND_TRACKER_H */
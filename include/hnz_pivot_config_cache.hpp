@@ -0,0 +1,97 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef PIVOT_HNZ_CONFIG_CACHE_H
+#define PIVOT_HNZ_CONFIG_CACHE_H
+
+#include <cstdint>
+#include <string>
+
+class HNZPivotConfig;
+
+/**
+ * Binary image of the lookup tables of an HNZPivotConfig, stored in a file of the Fledge data directory.
+ * The image is keyed by the size and two independent hashes of the exchanged_data JSON it was compiled from:
+ * as long as the JSON does not change, the tables are rebuilt from the memory mapped image and the JSON is not
+ * parsed at all.
+ */
+class HnzPivotConfigCache
+{
+public:
+    /**
+     * Identification of an exchanged_data JSON
+     */
+    struct ConfigKey {
+        uint64_t size = 0;
+        uint64_t hash = 0;      // FNV-1a
+        uint64_t checkHash = 0; // Multiplicative hash, so that a collision of the FNV-1a hash is not enough to match
+
+        bool operator==(const ConfigKey& other) const {
+            return size == other.size && hash == other.hash && checkHash == other.checkHash;
+        }
+        bool operator!=(const ConfigKey& other) const {return !(*this == other);}
+    };
+
+    /**
+     * @param path : Path of the cache file, its parent directory is created if needed
+    */
+    explicit HnzPivotConfigCache(const std::string& path): m_path(path) {}
+
+    /**
+     * Load the lookup tables from the cache file if it was compiled from the same JSON, otherwise import
+     * the JSON and write the cache file. Incomplete configurations are never cached, so that their errors
+     * are logged on each import.
+     * @param config : Configuration to fill
+     * @param exchangeConfig : exchanged_data JSON
+     * @param configKey : Key of the JSON, see keyConfig()
+     * @return True if the lookup tables were loaded from the cache file
+    */
+    bool importExchangeConfig(HNZPivotConfig& config, const std::string& exchangeConfig, const ConfigKey& configKey) const;
+
+    bool importExchangeConfig(HNZPivotConfig& config, const std::string& exchangeConfig) const {
+        return importExchangeConfig(config, exchangeConfig, keyConfig(exchangeConfig));
+    }
+
+    /**
+     * Replace the lookup tables of the configuration with the ones of the cache file
+     * @param config : Configuration to fill, left unchanged if the file cannot be loaded
+     * @param configKey : Key of the exchanged_data JSON the file must have been compiled from
+     * @return True if the file exists, is valid and matches the key
+    */
+    bool load(HNZPivotConfig& config, const ConfigKey& configKey) const;
+
+    /**
+     * Write the lookup tables of the configuration to the cache file
+     * @param config : Configuration to save
+     * @param configKey : Key of the exchanged_data JSON the configuration was compiled from
+     * @return True if the file was written
+    */
+    bool save(const HNZPivotConfig& config, const ConfigKey& configKey) const;
+
+    const std::string& getPath() const {return m_path;}
+
+    /**
+     * @param exchangeConfig : exchanged_data JSON
+     * @return Size and hashes of the JSON
+    */
+    static ConfigKey keyConfig(const std::string& exchangeConfig);
+
+    /**
+     * @param filterName : Name of the filter instance
+     * @return Path of the cache file of the filter instance in the Fledge data directory
+    */
+    static std::string defaultPath(const std::string& filterName);
+
+private:
+    std::string m_path;
+};
+
+#endif /* PIVOT_HNZ_CONFIG_CACHE_H */
@@ -0,0 +1,51 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef PIVOT_HNZ_CONFIG_REGISTRY_H
+#define PIVOT_HNZ_CONFIG_REGISTRY_H
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+class HNZPivotConfig;
+
+/**
+ * Process-wide registry of the compiled exchanged_data configurations, found by the hash and the size of their
+ * JSON then checked against the JSON itself. Filter instances configured with the same JSON share one immutable
+ * HNZPivotConfig, which is released (with the copy of its JSON kept by the registry) when the last instance using
+ * it is reconfigured or shut down.
+ */
+namespace HnzPivotConfigRegistry {
+    /**
+     * Function filling a new configuration from the JSON
+     */
+    using Builder = std::function<void(HNZPivotConfig& config)>;
+
+    /**
+     * Get the configuration compiled from a JSON, building it if no filter instance uses it yet.
+     * Builds of the same JSON are serialized, so a JSON imported by several instances at the same time is only
+     * parsed once, builds of different JSONs run concurrently.
+     * @param exchangedData : exchanged_data JSON
+     * @param configHash : Hash of the JSON, see HnzPivotConfigCache::keyConfig()
+     * @param builder : Called to fill the configuration if it is not in the registry
+     * @return Shared configuration
+    */
+    std::shared_ptr<const HNZPivotConfig> get(const std::string& exchangedData, uint64_t configHash, const Builder& builder);
+
+    /**
+     * @return Number of configurations currently used by at least one filter instance
+    */
+    size_t getConfigCount();
+};
+
+#endif /* PIVOT_HNZ_CONFIG_REGISTRY_H */
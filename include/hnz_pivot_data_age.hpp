@@ -0,0 +1,113 @@
+/*
+ * FledgePower HNZ <-> pivot filter data age.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_DATA_AGE_H
+#define _HNZ_PIVOT_DATA_AGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "hnz_pivot_histogram.hpp"
+
+class Datapoint;
+class HNZPivotConfig;
+
+/**
+ * Age of the data received by the filter, by station: time elapsed (in milliseconds) between the event time
+ * given by the RTU (do_ts) and the arrival of the data in the filter.
+ * Data older than the threshold are counted separately, data with an event time in the future (RTU clock
+ * ahead of the filter clock) are counted but not recorded in the histogram.
+ * The stations of the configuration are found in a vector indexed by station address, so that recording an age
+ * only takes a lock the first time a station sends a data.
+ */
+class HnzPivotDataAge
+{
+public:
+    /*
+     * Content of a station at a given time
+    */
+    struct StationSnapshot {
+        HnzPivotHistogram::Snapshot age;
+        uint64_t overThreshold = 0;
+        uint64_t inFuture = 0;
+    };
+
+    /* Stations indexed in the vector at most, HNZ station addresses fit in a byte */
+    static constexpr unsigned int MAX_INDEXED_STATIONS = 256;
+
+    HnzPivotDataAge() = default;
+    HnzPivotDataAge(const HnzPivotDataAge& other) = delete;
+    HnzPivotDataAge& operator=(const HnzPivotDataAge& other) = delete;
+
+    /**
+     * Size the vector of stations from the stations of the configuration. Not to be called concurrently with record.
+     * @param config : Configuration of the exchanged data
+    */
+    void setConfig(const HNZPivotConfig& config);
+
+    /**
+     * Record the age of a data, from one thread at a time (the conversion of the filter)
+     * @param station : Station the data comes from
+     * @param eventTimeMs : Event time of the data given by the RTU, in milliseconds since epoch
+     * @param arrivalTimeMs : Arrival time of the data in the filter, in milliseconds since epoch
+     * @return True if the data is older than the threshold
+    */
+    bool record(unsigned int station, uint64_t eventTimeMs, uint64_t arrivalTimeMs);
+
+    void setThresholdMs(uint64_t thresholdMs);
+    uint64_t getThresholdMs() const;
+
+    /**
+     * @param station : Station to look for
+     * @param snapshot : Content of the station
+     * @return False if no data was recorded for the station
+    */
+    bool getStationSnapshot(unsigned int station, StationSnapshot& snapshot) const;
+    size_t getStationCount() const;
+    /**
+     * Forget all stations. Not to be called concurrently with record.
+    */
+    void reset();
+
+    /**
+     * Build a datapoint holding the threshold and, for each station, a summary of the data age and the counters
+     * @param name : Name of the datapoint to create
+     * @return Newly allocated datapoint
+    */
+    Datapoint* toDatapoint(const std::string& name) const;
+
+private:
+    struct Station {
+        HnzPivotHistogram age;
+        std::atomic<uint64_t> overThreshold{0};
+        std::atomic<uint64_t> inFuture{0};
+    };
+
+    /**
+     * Find or allocate a station not found in the vector
+    */
+    Station* m_addStation(unsigned int station);
+
+    mutable std::mutex m_stationsMutex;
+    /* Histograms are large, stations are only allocated once they sent a data */
+    std::map<unsigned int, std::unique_ptr<Station>> m_stations;
+    /* Stations of m_stations by address, up to the highest station of the configuration (or all the addresses
+       below MAX_INDEXED_STATIONS if some points accept any station), null until the station sends a data */
+    std::vector<Station*> m_stationSlots;
+    std::atomic<uint64_t> m_thresholdMs{5000};
+};
+
+#endif /* _HNZ_PIVOT_DATA_AGE_H */
@@ -12,11 +12,26 @@
 #ifndef _HNZ_PIVOT_FILTER_H
 #define _HNZ_PIVOT_FILTER_H
 
+#include <array>
+#include <memory>
 #include <string>
 #include <mutex>
+#include <thread>
 #include <filter.h>
 #include <config_category.h>
 
+#include "hnz_pivot_chatter_filter.hpp"
+#include "hnz_pivot_command_deduplicator.hpp"
+#include "hnz_pivot_command_tracker.hpp"
+#include "hnz_pivot_outdated_storm.hpp"
+#include "hnz_pivot_tm_aggregator.hpp"
+#include "hnz_pivot_config_cache.hpp"
+#include "hnz_pivot_data_age.hpp"
+#include "hnz_pivot_histogram.hpp"
+#include "hnz_pivot_ingest_queue.hpp"
+#include "hnz_pivot_object.hpp"
+#include "hnz_pivot_statistics.hpp"
+
 class Datapoint;
 class HNZPivotConfig;
 class HNZPivotDataPoint;
@@ -42,6 +57,19 @@ public:
         bool doTsS = false;
     };
 
+    /*
+     * Processing stages of the filter for which latency can be measured
+    */
+    enum class LatencyStage {
+        DECODE,      // Scan of the attributes of a data_object
+        LOOKUP,      // Search of the exchanged_data entry matching a data_object
+        PIVOT_BUILD, // Construction of the pivot object from a data_object
+        HNZ_DECODE,  // Conversion of a pivot command into an HNZ command
+        FORWARD,     // Call to the next filter in the chain
+        COMMAND      // From the conversion of a reading set to the forward of the commands it holds
+    };
+    static constexpr int LATENCY_STAGE_COUNT = 6;
+
     /**
      * Constructor for the HNZPivotFilter.
      *
@@ -58,9 +86,17 @@ public:
         OUTPUT_HANDLE* outHandle,
         OUTPUT_STREAM output);
 
+    /**
+     * Destructor, waits for the conversion thread to convert and forward the queued readings
+     */
+    ~HNZPivotFilter();
+
     /**
      * The actual filtering code
      *
+     * In asynchronous mode, the reading set is only queued and the conversion thread of the filter
+     * converts and forwards the queued reading sets in order.
+     *
      * @param readingSet The reading data to filter
      */
     void ingest(READINGSET* readingSet);
@@ -80,9 +116,99 @@ public:
      */
     void reconfigure(const std::string& newConfig);
 
+    /**
+     * Get a copy of the latency histogram of a processing stage (values in nanoseconds).
+     * Latencies are only measured if the plugin was built with the HNZ_PIVOT_LATENCY_STATS flag,
+     * otherwise the histograms stay empty.
+     *
+     * @param stage The processing stage
+     * @return Snapshot of the latency histogram of the stage
+     */
+    HnzPivotHistogram::Snapshot getLatencySnapshot(LatencyStage stage) const;
+
+    /**
+     * Clear the latency histograms of all processing stages
+     */
+    void resetLatencyStats();
+
+    static std::string latencyStageStr(LatencyStage stage);
+
+    /**
+     * Get the conversion counters of the filter
+     *
+     * @return Conversion counters
+     */
+    const HnzPivotStatistics& getStatistics() const {return m_statistics;}
+    const HnzPivotCommandTracker& getCommandTracker() const {return m_commandTracker;}
+    const HnzPivotDataAge& getDataAge() const {return m_dataAge;}
+    const HnzPivotChatterFilter& getChatterFilter() const {return m_chatterFilter;}
+    const HnzPivotTmAggregator& getTmAggregator() const {return m_tmAggregator;}
+    const HnzPivotOutdatedStorm& getOutdatedStorm() const {return m_outdatedStorm;}
+    const HnzPivotCommandDeduplicator& getCommandDeduplicator() const {return m_commandDeduplicator;}
+    bool isCompactOutput() const {return m_compactOutput;}
+    bool isJsonOutput() const {return m_jsonOutput;}
+
+    /**
+     * Get the exchanged_data configuration of the filter, shared with the other filter instances
+     * configured with the same exchanged_data
+     *
+     * @return Current exchanged_data configuration
+     */
+    std::shared_ptr<const HNZPivotConfig> getExchangeConfig() const {return m_filterConfig;}
+
+    /**
+     * Get the queue of the asynchronous mode
+     *
+     * @return Queue between ingest and the conversion thread, nullptr if the filter converts readings synchronously
+     */
+    std::shared_ptr<const HnzPivotIngestQueue> getIngestQueue() const;
+
 private:
     void readConfig(const ConfigCategory& config);
 
+    /**
+     * Convert a reading set and forward it to the next filter
+     *
+     * @param readingSet The reading data to convert
+     * @param ingestQueue Queue the reading set comes from, nullptr if it is converted synchronously
+     */
+    void convertReadingSet(READINGSET* readingSet, const HnzPivotIngestQueue* ingestQueue);
+
+    /**
+     * Convert the datapoints of a reading in place
+     *
+     * @param reading The reading to convert
+     * @return False if no datapoint is left in the reading
+     */
+    bool convertReading(Reading* reading);
+
+    /**
+     * Convert the PivotCommand readings of a reading set into m_commandReadings
+     *
+     * @param readings The readings of the reading set, the commands are removed from it
+     */
+    void takeCommandReadings(std::vector<Reading*>& readings);
+
+    /**
+     * Asynchronous mode: convert and forward the commands of a reading set before it is queued, so that they
+     * neither wait behind the reading sets already queued nor are dropped with them
+     *
+     * @param readingSet The reading set to queue, the commands are removed from it
+     * @return True if the reading set only held commands, it was then forwarded and must not be queued
+     */
+    bool forwardCommands(READINGSET* readingSet);
+
+    /**
+     * Send a converted reading set to the next filter
+     *
+     * @param readingSet The converted reading set
+     */
+    void forwardReadingSet(READINGSET* readingSet);
+
+    void updateIngestThread();
+    void startIngestThread();
+    void stopIngestThread();
+
     Datapoint* addElement(Datapoint* dp, const std::string& elementPath);
 
     template <class T>
@@ -102,20 +228,115 @@ private:
                               const std::string& targetName, Datapoint*& out);
     void static readAttribute(std::map<std::string, bool>& attributeFound, Datapoint* dp,
                               const std::string& targetName, std::string& out);
-    Datapoint* convertDatapointToPivot(const std::string& assetName, Datapoint* sourceDp);
+    Datapoint* convertDatapointToPivot(const std::string& assetName, Datapoint* sourceDp, bool& suppressed);
     Datapoint* convertTSToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig);
+                                const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                size_t pointIndex, bool& suppressed);
+    Datapoint* createTSPivot(const HNZPivotDataPoint& exchangeConfig, size_t pointIndex, bool doCg,
+                             const HnzPivotChatterFilter::Transition& transition, bool oscillatory);
     Datapoint* convertTMToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig);
+                                const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                size_t pointIndex, bool& suppressed);
+    Datapoint* createTMPivot(const HNZPivotDataPoint& exchangeConfig, size_t pointIndex, bool hasValue, long value,
+                             unsigned int doValid, bool doOutdated);
     Datapoint* convertTCACKToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                   const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig);
+                                   const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                   size_t pointIndex);
     Datapoint* convertTVCACKToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                    const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig);
+                                    const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                    size_t pointIndex);
 
-    std::vector<Datapoint*> convertDatapointToHNZ(const std::string& assetName, Datapoint* sourceDp) const;
+    /**
+     * Get the JSON fragments of a point for the JSON output format, built on first use
+     * @param pointIndex : Index of the point in m_filterConfig
+     * @param pivotLN : Logical node of the pivot objects of the point
+     * @param exchangeConfig : Configuration of the point
+     * @return The fragments of the point, or nullptr if the output format is not JSON
+    */
+    const HnzPivotJsonFragments* jsonFragments(size_t pointIndex, const char* pivotLN, const HNZPivotDataPoint& exchangeConfig);
+
+    bool convertDatapointToHNZ(const std::string& assetName, Datapoint* sourceDp, std::vector<Datapoint*>& convertedDatapoints,
+                               bool& suppressed);
+
+    /**
+     * Replace the outdated data_objects of the stations that lost their link by station quality events
+     * @param readings : Readings to convert, where the station quality events take the place of the first data_object
+     * of their storm, the readings left empty are removed
+     * @param stationReadings : Readings of the station quality events, also inserted in readings
+    */
+    void compressOutdatedStorms(std::vector<Reading*>& readings, std::vector<Reading*>& stationReadings);
+
+    /**
+     * Build the readings of the TM aggregates of the windows which are over, for the points quiet since then
+     * @param aggregateReadings : Readings of the aggregates, one per point, named after the label of the point
+    */
+    void flushTmAggregates(std::vector<Reading*>& aggregateReadings);
+
+    /**
+     * Build the readings of the last transition suppressed of the TS points which are no longer chattering
+     * @param releasedReadings : Readings of the transitions, one per point, named after the label of the point
+    */
+    void releaseChatteringPoints(std::vector<Reading*>& releasedReadings);
 
-    std::shared_ptr<HNZPivotConfig> m_filterConfig;
+    void appendStatisticsReading(std::vector<Reading*>& readings, const HnzPivotIngestQueue* ingestQueue);
+
+    HnzPivotHistogram& latencyHistogram(LatencyStage stage) const {return m_latencyStats[static_cast<int>(stage)];}
+
+    std::shared_ptr<const HNZPivotConfig> m_filterConfig;
     std::recursive_mutex            m_configMutex;
+    /* Compiled exchanged_data saved in the Fledge data directory */
+    HnzPivotConfigCache             m_configCache;
+    bool                            m_configCacheEnabled = false;
+    /* Datapoints converted from the reading being ingested, reused for all readings to keep its capacity */
+    std::vector<Datapoint*>         m_convertedDatapoints;
+    /* Converted commands of the reading set being ingested, forwarded ahead of the other readings */
+    std::vector<Reading*>           m_commandReadings;
+    /* Asynchronous mode: queue filled by ingest and emptied by the conversion thread, both null in synchronous mode.
+       m_ingestQueueMutex guards them and is held while the thread is stopped: a reading set refused by the closed
+       queue is converted by ingest once the mutex is released, after the reading sets queued before */
+    std::shared_ptr<HnzPivotIngestQueue> m_ingestQueue;
+    std::thread                     m_ingestThread;
+    mutable std::mutex              m_ingestQueueMutex;
+    /* Asynchronous mode settings read from the configuration */
+    bool                            m_asyncIngest = false;
+    size_t                          m_asyncQueueDepth = 64;
+    HnzPivotIngestQueue::Policy     m_asyncPolicy = HnzPivotIngestQueue::Policy::BLOCK;
+    /* Key of the last exchanged_data imported, a reconfigure with the same JSON does not import it again */
+    HnzPivotConfigCache::ConfigKey  m_exchangedDataKey;
+    bool                            m_exchangedDataImported = false;
+
+    mutable std::array<HnzPivotHistogram, LATENCY_STAGE_COUNT> m_latencyStats;
+
+    HnzPivotStatistics m_statistics;
+    /* Round-trip time between the commands converted and their ACKs */
+    HnzPivotCommandTracker m_commandTracker;
+    /* Age of the TS CE received, by station */
+    HnzPivotDataAge m_dataAge;
+    /* TS older than the data age threshold flagged as old data */
+    bool m_dataAgeFlag = false;
+    /* Arrival time of the reading set being converted, read once for all its readings */
+    uint64_t m_batchTimeMs = 0;
+    /* Detection of the TS points changing state too often, indexed by the point index of m_filterConfig */
+    HnzPivotChatterFilter m_chatterFilter;
+    /* Transitions of the points released by the reading set being converted, only the capacity is kept between calls */
+    std::vector<HnzPivotChatterFilter::Released> m_chatterReleased;
+    /* Aggregation of the TM samples, indexed by the point index of m_filterConfig */
+    HnzPivotTmAggregator m_tmAggregator;
+    /* Aggregates of the windows ended by the reading set being converted, only the capacity is kept between calls */
+    std::vector<HnzPivotTmAggregator::Aggregate> m_tmAggregates;
+    HnzPivotOutdatedStorm m_outdatedStorm;
+    /* Pivot commands recently converted, to drop the duplicates */
+    HnzPivotCommandDeduplicator m_commandDeduplicator;
+    /* Pivot objects built without the fields equal to their default value */
+    bool m_compactOutput = false;
+    /* Pivot objects rendered directly as a JSON string, with the fragments of each point indexed by its point index */
+    bool m_jsonOutput = false;
+    std::vector<HnzPivotJsonFragments> m_jsonFragments;
+    /* Storms of the reading set being converted, only the capacity is kept between calls */
+    std::vector<HnzPivotOutdatedStorm::Storm> m_storms;
+    /* Period at which the statistics reading is sent, 0 if disabled */
+    long m_statisticsPeriodMs = 0;
+    uint64_t m_lastStatisticsTs = 0;
 };
 
 
@@ -15,9 +15,14 @@
 #include <string>
 #include <map>
 #include <memory>
-#include <rapidjson/document.h>
+#include <unordered_map>
+#include <vector>
+
+#include "hnz_pivot_perfect_hash.hpp"
 
 #define FILTER_NAME "hnz_pivot_filter"
+#define STATISTICS_ASSET_NAME "HNZPivotStatistics"
+#define STATION_QUALITY_ASSET_NAME "HNZStationQuality"
 
 constexpr char JSON_NAME[] = "name";
 constexpr char JSON_VERSION[] = "version";
@@ -30,17 +35,25 @@ constexpr char PROTOCOLS[] = "protocols";
 constexpr char HNZ_NAME[] = "hnzip";
 constexpr char MESSAGE_CODE[] = "typeid";
 constexpr char MESSAGE_ADDRESS[] = "address";
+constexpr char MESSAGE_STATION[] = "station";
 
 class HNZPivotDataPoint
 {
 public:
-    HNZPivotDataPoint(const std::string& label, const std::string& pivotId, const std::string& pivotType, const std::string& typeIdStr, unsigned int address);
+    HNZPivotDataPoint(const std::string& label, const std::string& pivotId, const std::string& pivotType, const std::string& typeIdStr, unsigned int address,
+                      bool hasStation = false, unsigned int station = 0);
 
     const std::string& getLabel() const {return m_label;}
     const std::string& getPivotId() const {return m_pivotId;}
     const std::string& getPivotType() const {return m_pivotType;}
     const std::string& getTypeId() const {return m_typeIdStr;}
     unsigned int getAddress() const {return m_address;}
+    /* A datapoint without station matches the data objects of all stations */
+    bool hasStation() const {return m_hasStation;}
+    unsigned int getStation() const {return m_station;}
+
+    bool operator==(const HNZPivotDataPoint& other) const;
+    bool operator!=(const HNZPivotDataPoint& other) const {return !(*this == other);}
 
 private:
     std::string  m_label;
@@ -49,40 +62,163 @@ private:
 
     std::string  m_typeIdStr;
     unsigned int m_address;
+    bool         m_hasStation;
+    unsigned int m_station;
 };
 
+class HNZPivotConfigHandler;
+class HnzPivotConfigCache;
+
 class HNZPivotConfig
 {
 public:
+    /*
+     * Number of exchange definitions affected by applyExchangeConfig or mapPointIndexes
+     */
+    struct ExchangeChanges {
+        size_t added = 0;
+        size_t removed = 0;
+        size_t changed = 0;
+        size_t unchanged = 0;
+    };
+
     HNZPivotConfig() = default;
 
+    /**
+     * Import the exchanged_data configuration. The JSON is streamed through a SAX parser that
+     * only keeps the hnzip protocol entries, so no DOM of the whole configuration is built.
+     * @param exchangeConfig : exchanged_data JSON
+    */
     void importExchangeConfig(const std::string& exchangeConfig);
 
+    /**
+     * Import the exchanged_data configuration replacing another one: the definitions left unchanged share the
+     * datapoints of the previous configuration, and its pivotId index is reused if no definition is added or removed
+     * @param exchangeConfig : exchanged_data JSON
+     * @param previousConfig : Configuration replaced by this one
+    */
+    void importExchangeConfig(const std::string& exchangeConfig, const HNZPivotConfig& previousConfig);
+
+    /**
+     * Update the lookup tables to match the ones of another configuration, only the entries that differ are
+     * added, removed or replaced. The datapoints of unchanged definitions are kept as is, so any state keyed
+     * on them survives the update. The pivotId index is only rebuilt if definitions are added or removed.
+     * @param newConfig : Imported configuration, its entries are moved into this configuration
+     * @return Number of definitions added, removed, changed and left unchanged
+    */
+    ExchangeChanges applyExchangeConfig(HNZPivotConfig&& newConfig);
+
+    /**
+     * Use the datapoints of a previous configuration for the definitions that did not change, so that both
+     * configurations share them instead of holding equal copies
+     * @param previousConfig : Configuration replaced by this one
+    */
+    void shareDataPoints(const HNZPivotConfig& previousConfig);
+
+    /**
+     * Find the index in this configuration of each datapoint of the configuration it replaces, so that
+     * per-point state can be moved to the new indexes instead of being reset
+     * @param previousConfig : Configuration replaced by this one
+     * @param pointIndexes : Filled with the index of each point of previousConfig in this configuration,
+     * HnzPivotPerfectHash::NOT_FOUND if its definition was removed or changed
+     * @return Number of definitions added, removed, changed and left unchanged
+    */
+    ExchangeChanges mapPointIndexes(const HNZPivotConfig& previousConfig, std::vector<size_t>& pointIndexes) const;
+
     const std::map<std::string, std::shared_ptr<HNZPivotDataPoint>>& getExchangeDefinitions() const {return m_exchangeDefinitions;}
-    std::string findPivotId(const std::string& typeIdStr, unsigned int address) const;
+    /**
+     * Find the pivotId of a data object, the datapoints configured for its station are searched first,
+     * then the ones configured without station
+     * @param station : Station of the data object (do_station)
+     * @param typeIdStr : Type of the data object (do_type)
+     * @param address : Address of the data object (do_addr)
+     * @return pivotId of the data object, empty if not found
+    */
+    const std::string& findPivotId(unsigned int station, const std::string& typeIdStr, unsigned int address) const;
+    /**
+     * Find the index of a datapoint, indexes are in [0, getPointCount()) and can be used to store
+     * per-point state in a vector. They are only valid for this configuration.
+     * @param pivotId : pivotId of the datapoint
+     * @return Index of the datapoint, HnzPivotPerfectHash::NOT_FOUND if the pivotId is not configured
+    */
+    size_t findPointIndex(const std::string& pivotId) const;
+    size_t getPointCount() const {return m_dataPointsBySlot.size();}
+    /**
+     * @param pointIndex : Index of a datapoint, as returned by findPointIndex
+     * @return Datapoint of the index
+     */
+    const HNZPivotDataPoint* getDataPoint(size_t pointIndex) const {return m_dataPointsBySlot[pointIndex];}
+    /**
+     * Find the datapoint targeted by a pivot command
+     * @param pivotId : Identifier of the pivot command
+     * @return Datapoint of the pivot id if it is a TC or TVC, nullptr otherwise
+    */
+    const HNZPivotDataPoint* findCommand(const std::string& pivotId) const;
+    /**
+     * Find the datapoint targeted by a pivot command and its index
+     * @param pivotId : Identifier of the pivot command
+     * @param pointIndex : Index of the datapoint, only set if the pivotId is a TC or TVC
+     * @return Datapoint of the pivot id if it is a TC or TVC, nullptr otherwise
+    */
+    const HNZPivotDataPoint* findCommand(const std::string& pivotId, size_t& pointIndex) const;
+    size_t getCommandCount() const {return m_commandCount;}
     static const std::string& getPluginName();
     bool isComplete() const {return m_exchange_data_is_complete;};
 
 private:
-    static bool m_check_string(const rapidjson::Value &json, const char *key);
-    static bool m_check_array(const rapidjson::Value &json, const char *key);
-    static bool m_check_object(const rapidjson::Value &json, const char *key);
-
-    static bool m_retrieve(const rapidjson::Value &json, const char *key, unsigned int *target);
-    static bool m_retrieve(const rapidjson::Value &json, const char *key, unsigned int *target, unsigned int def);
-    static bool m_retrieve(const rapidjson::Value &json, const char *key, std::string *target);
-    static bool m_retrieve(const rapidjson::Value &json, const char *key, std::string *target, const std::string& def);
-    static bool m_retrieve(const rapidjson::Value &json, const char *key, long long int *target, long long int def);
-    
-    std::string m_getLookupHash(const std::string& typeIdStr, unsigned int address) const;
-    
+    friend class HNZPivotConfigHandler;
+    friend class HnzPivotConfigCache;
+
+    /*
+     * Entry of the lookup table used to find the pivotId of a data object
+     */
+    struct LookupEntry {
+        bool hasStation = false;
+        unsigned int station = 0;
+        std::string typeIdStr;
+        unsigned int address = 0;
+        std::string pivotId;
+    };
+
+    /*
+     * Range of the entries of a station in the lookup table
+     */
+    struct LookupRange {
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    void m_addDataPoint(const std::string& label, const std::string& pivotId, const std::string& pivotType,
+                        const std::string& typeIdStr, unsigned int address, bool hasStation = false, unsigned int station = 0);
+
+    /* Fill the definitions and the sorted lookup table, without building the indexes */
+    void m_parseExchangeConfig(const std::string& exchangeConfig);
+    void m_sortLookup();
+    void m_buildIndexes();
+    void m_buildPointIndexes();
+    void m_buildStationRanges();
+    void m_setSlot(size_t slot, const HNZPivotDataPoint* dataPoint);
+    void m_clearIndexes();
+    const std::string* m_findInRange(const LookupRange& range, const std::string& typeIdStr, unsigned int address) const;
+
     bool m_exchange_data_is_complete = false;
 
     /* list of exchange data points -> the pivotId is the key */
     std::map<std::string, std::shared_ptr<HNZPivotDataPoint>> m_exchangeDefinitions;
-    /* Map used to find the pivotId from the combination of typeid and address
-       -> "typeid-address" is the key */
-    std::map<std::string, std::string> m_pivotIdLookup;
+    /* Table used to find the pivotId from the combination of station, typeid and address, sorted by
+       (hasStation, station, typeid, address) so that the entries of each station are contiguous */
+    std::vector<LookupEntry> m_pivotIdLookup;
+    /* Range of the entries of each station in m_pivotIdLookup */
+    std::unordered_map<unsigned int, LookupRange> m_stationRanges;
+    /* Range of the entries without station in m_pivotIdLookup */
+    LookupRange m_anyStationRange;
+    /* Minimal perfect hash of the pivotIds of m_exchangeDefinitions, used for all lookups by pivotId */
+    HnzPivotPerfectHash m_pivotIdHash;
+    /* Datapoint of each slot of m_pivotIdHash, its pivotId is the key of the slot */
+    std::vector<const HNZPivotDataPoint*> m_dataPointsBySlot;
+    /* Datapoint of each slot of m_pivotIdHash if it can be the target of a pivot command (TC and TVC), nullptr otherwise */
+    std::vector<const HNZPivotDataPoint*> m_commandsBySlot;
+    size_t m_commandCount = 0;
 };
 
 #endif /* PIVOT_HNZ_CONFIG_H */
\ No newline at end of file
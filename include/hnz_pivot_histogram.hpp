@@ -0,0 +1,183 @@
+/*
+ * FledgePower HNZ <-> pivot filter latency histogram.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_HISTOGRAM_H
+#define _HNZ_PIVOT_HISTOGRAM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+/**
+ * Lock-free log-bucketed histogram (HDR style).
+ *
+ * Values are sorted in buckets by power of two, each power of two being split in SUB_BUCKET_COUNT
+ * linear sub-buckets, which gives a relative precision of 1/SUB_BUCKET_COUNT over the whole uint64_t range.
+ * Recording a value is a few relaxed atomic increments, so it can be done from the hot path.
+ */
+class HnzPivotHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;
+    static constexpr unsigned SUB_BUCKET_COUNT = 1u << SUB_BUCKET_BITS;
+    static constexpr unsigned BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    /**
+     * Copy of the histogram content at a given time
+     */
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sum = 0;
+        uint64_t min = 0;
+        uint64_t max = 0;
+        std::vector<uint64_t> buckets;
+
+        /**
+         * Get the average of all recorded values
+         * @return Mean value, or 0 if no value was recorded
+        */
+        double mean() const;
+        /**
+         * Get an upper bound of the value below which the given percentage of recorded values fall
+         * @param percent : Percentage in range [0..100]
+         * @return Upper bound of the bucket containing the percentile, or 0 if no value was recorded
+        */
+        uint64_t percentile(double percent) const;
+    };
+
+    HnzPivotHistogram();
+    HnzPivotHistogram(const HnzPivotHistogram& other) = delete;
+    HnzPivotHistogram& operator=(const HnzPivotHistogram& other) = delete;
+
+    /**
+     * Record a value in the histogram
+     * @param value : Value to record
+    */
+    void record(uint64_t value) {
+        m_buckets[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        uint64_t prevMin = m_min.load(std::memory_order_relaxed);
+        while (value < prevMin && !m_min.compare_exchange_weak(prevMin, value, std::memory_order_relaxed)) {}
+        uint64_t prevMax = m_max.load(std::memory_order_relaxed);
+        while (value > prevMax && !m_max.compare_exchange_weak(prevMax, value, std::memory_order_relaxed)) {}
+    }
+
+    /**
+     * Get a copy of the histogram content. As recording may happen concurrently,
+     * the different fields of the snapshot are only loosely consistent with each other.
+     * @return Snapshot of the histogram
+    */
+    Snapshot snapshot() const;
+
+    /**
+     * Clear all recorded values
+    */
+    void reset();
+
+    /**
+     * Get the index of the bucket holding the given value
+     * @param value : Value to locate
+     * @return Bucket index in range [0..BUCKET_COUNT[
+    */
+    static unsigned bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKET_COUNT) {
+            return static_cast<unsigned>(value);
+        }
+        unsigned msb = 63 - static_cast<unsigned>(__builtin_clzll(value));
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        return ((shift + 1) << SUB_BUCKET_BITS) + static_cast<unsigned>((value >> shift) & (SUB_BUCKET_COUNT - 1));
+    }
+
+    /**
+     * Get the lowest value stored in the given bucket
+     * @param index : Bucket index
+     * @return Lowest value of the bucket
+    */
+    static uint64_t bucketLowerBound(unsigned index);
+
+    /**
+     * Get the highest value stored in the given bucket
+     * @param index : Bucket index
+     * @return Highest value of the bucket
+    */
+    static uint64_t bucketUpperBound(unsigned index);
+
+private:
+    std::array<std::atomic<uint64_t>, BUCKET_COUNT> m_buckets;
+    std::atomic<uint64_t> m_count;
+    std::atomic<uint64_t> m_sum;
+    std::atomic<uint64_t> m_min;
+    std::atomic<uint64_t> m_max;
+};
+
+/**
+ * Scope timer recording its lifetime (in nanoseconds) into a histogram when destroyed,
+ * or the time elapsed until stop is called, nothing if cancel is called first
+ */
+class HnzPivotScopeTimer
+{
+public:
+    explicit HnzPivotScopeTimer(HnzPivotHistogram& histogram):
+        m_histogram(histogram), m_start(std::chrono::steady_clock::now()) {}
+    ~HnzPivotScopeTimer() {
+        stop();
+    }
+    void stop() {
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_histogram.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+    }
+    void cancel() {
+        m_running = false;
+    }
+    HnzPivotScopeTimer(const HnzPivotScopeTimer& other) = delete;
+    HnzPivotScopeTimer& operator=(const HnzPivotScopeTimer& other) = delete;
+
+private:
+    HnzPivotHistogram& m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+    bool m_running = true;
+};
+
+/*
+ * Time the rest of the current scope into the given histogram.
+ * Only compiled in when the HNZ_PIVOT_LATENCY_STATS flag is defined, expands to nothing otherwise.
+ */
+#define HNZ_PIVOT_CONCAT_(a, b) a##b
+#define HNZ_PIVOT_CONCAT(a, b) HNZ_PIVOT_CONCAT_(a, b)
+#ifdef HNZ_PIVOT_LATENCY_STATS
+#define HNZ_PIVOT_TIME_SCOPE(histogram) HnzPivotScopeTimer HNZ_PIVOT_CONCAT(hnzPivotScopeTimer, __LINE__)(histogram)
+#else
+#define HNZ_PIVOT_TIME_SCOPE(histogram)
+#endif
+
+/*
+ * Named timer for a measure that does not end with the scope: started by HNZ_PIVOT_TIMER_START, recorded by
+ * HNZ_PIVOT_TIMER_STOP (or at the end of the scope) and discarded by HNZ_PIVOT_TIMER_CANCEL.
+ * Expand to nothing when the HNZ_PIVOT_LATENCY_STATS flag is not defined.
+ */
+#ifdef HNZ_PIVOT_LATENCY_STATS
+#define HNZ_PIVOT_TIMER_START(timer, histogram) HnzPivotScopeTimer timer(histogram)
+#define HNZ_PIVOT_TIMER_STOP(timer) timer.stop()
+#define HNZ_PIVOT_TIMER_CANCEL(timer) timer.cancel()
+#else
+#define HNZ_PIVOT_TIMER_START(timer, histogram)
+#define HNZ_PIVOT_TIMER_STOP(timer)
+#define HNZ_PIVOT_TIMER_CANCEL(timer)
+#endif
+
+#endif /* _HNZ_PIVOT_HISTOGRAM_H */
@@ -0,0 +1,138 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_INGEST_QUEUE_H
+#define _HNZ_PIVOT_INGEST_QUEUE_H
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+
+class Datapoint;
+class ReadingSet;
+
+/**
+ * Bounded queue of reading sets between the thread calling plugin_ingest and the conversion thread of the filter.
+ *
+ * Push and pop are lock-free (bounded multi-producer multi-consumer ring in which each cell carries a sequence
+ * number): the mutex and condition variables are only used to put a thread to sleep when the queue is empty
+ * (consumer) or full (producer with the BLOCK policy), and to wake it up.
+ * The queue owns the reading sets it holds: the ones dropped or still queued when it is destroyed are deleted.
+ */
+class HnzPivotIngestQueue
+{
+public:
+    /*
+     * Behavior of push when the queue is full
+    */
+    enum class Policy {
+        BLOCK,       // Wait for the conversion thread to free a cell
+        DROP_OLDEST, // Delete the oldest queued reading set to make room for the new one
+        DROP_NEWEST  // Delete the new reading set
+    };
+
+    enum class Counter {
+        ENQUEUED,
+        DROPPED_OLDEST,
+        DROPPED_NEWEST,
+        BLOCKED // Pushes that had to wait for a free cell
+    };
+    static constexpr int COUNTER_COUNT = 4;
+
+    /**
+     * @param depth : Maximum number of queued reading sets (at least 1)
+     * @param policy : Behavior of push when the queue is full
+    */
+    HnzPivotIngestQueue(size_t depth, Policy policy);
+    ~HnzPivotIngestQueue();
+    HnzPivotIngestQueue(const HnzPivotIngestQueue& other) = delete;
+    HnzPivotIngestQueue& operator=(const HnzPivotIngestQueue& other) = delete;
+
+    /**
+     * Queue a reading set, applying the policy of the queue if it is full
+     * @param readingSet : Reading set to queue, owned by the queue if this function returns true
+     * @return True if the reading set was taken by the queue (queued or dropped), false if the queue is closed
+     * (including while waiting for a free cell with the BLOCK policy)
+    */
+    bool push(ReadingSet* readingSet);
+
+    /**
+     * Get the oldest queued reading set, waiting for one if the queue is empty
+     * @return Reading set now owned by the caller, nullptr once the queue is closed and empty
+    */
+    ReadingSet* pop();
+
+    /**
+     * Get the oldest queued reading set without waiting
+     * @return Reading set now owned by the caller, nullptr if the queue is empty
+    */
+    ReadingSet* tryPop();
+
+    /**
+     * Reject the next pushes and wake up the consumer, which gets the reading sets still queued then nullptr
+    */
+    void close();
+
+    size_t getDepth() const {return m_depth;}
+    Policy getPolicy() const {return m_policy;}
+    uint64_t get(Counter counter) const {return m_counters[static_cast<int>(counter)].load(std::memory_order_relaxed);}
+
+    /**
+     * Build a datapoint holding the value of all counters
+     * @param name : Name of the datapoint to create
+     * @return Newly allocated datapoint
+    */
+    Datapoint* toDatapoint(const std::string& name) const;
+
+    static std::string CounterStr(Counter counter);
+    static std::string PolicyStr(Policy policy);
+    /**
+     * @param policyStr : Name of a policy ("block", "drop_oldest", "drop_newest")
+     * @param policy : Matching policy
+     * @return False if the name is not a policy
+    */
+    static bool policyFromStr(const std::string& policyStr, Policy& policy);
+
+private:
+    struct Cell {
+        std::atomic<size_t> sequence;
+        ReadingSet* readingSet;
+    };
+
+    bool m_tryPush(ReadingSet* readingSet);
+    /* Pop without waking up the waiting producers, which needs m_waitMutex */
+    ReadingSet* m_tryPop();
+    void m_increment(Counter counter) {m_counters[static_cast<int>(counter)].fetch_add(1, std::memory_order_relaxed);}
+    void m_wakeUp(std::atomic<int>& waiting, std::condition_variable& condition);
+
+    const size_t m_depth;
+    const Policy m_policy;
+    std::unique_ptr<Cell[]> m_cells;
+    /* Producer and consumer positions are kept on separate cache lines */
+    std::atomic<size_t> m_pushPosition;
+    char m_padding[64];
+    std::atomic<size_t> m_popPosition;
+
+    std::atomic<bool> m_closed;
+    std::mutex m_waitMutex;
+    std::condition_variable m_notEmpty;
+    std::condition_variable m_notFull;
+    std::atomic<int> m_waitingConsumers;
+    std::atomic<int> m_waitingProducers;
+
+    std::array<std::atomic<uint64_t>, COUNTER_COUNT> m_counters;
+};
+
+#endif /* _HNZ_PIVOT_INGEST_QUEUE_H */
@@ -30,6 +30,18 @@ class HnzPivotObjectException : public std::exception //NOSONAR
     const std::string m_context;
 };
 
+/*
+ * Static parts of the JSON of the pivot objects of a point, computed once per point for the JSON output format
+ */
+struct HnzPivotJsonFragments
+{
+    std::string lnOpen;  // Logical node and identifier: {"GTIS":{"Identifier":"ID1"
+    std::string cdcOpen; // Common data class: "SpsTyp":{
+
+    bool empty() const {return lnOpen.empty();}
+    static HnzPivotJsonFragments build(const std::string& pivotLN, const std::string& pivotId, const std::string& pivotType);
+};
+
 class HnzPivotTimestamp
 {
 public:
@@ -115,7 +127,17 @@ public:
     };
 
     explicit HnzPivotObject(Datapoint* pivotData);
-    HnzPivotObject(const std::string& pivotLN, const std::string& valueType);
+    /**
+     * Create an empty pivot object
+     * @param pivotLN : Logical node of the object (GTIS, GTIM, GTIC)
+     * @param valueType : Common data class of the object (SpsTyp, MvTyp...)
+     * @param compact : If true the fields equal to their pivot model default (ComingFrom "hnzip", good quality,
+     * genuine and good timestamp) are omitted
+     * @param jsonFragments : If not null the object is rendered directly as a JSON string from these fragments,
+     * without datapoint tree. Identifier, logical node and common data class are then taken from the fragments.
+    */
+    HnzPivotObject(const std::string& pivotLN, const std::string& valueType, bool compact = false,
+                   const HnzPivotJsonFragments* jsonFragments = nullptr);
 
     void setIdentifier(const std::string& identifier);
     void setCause(int cause);
@@ -130,18 +152,23 @@ public:
 
     void addTimestamp(unsigned long doTs, bool doTsS);
 
-    void addQuality(unsigned int doValid, bool doOutdated, bool doTsC, bool doTsS);
+    void addQuality(unsigned int doValid, bool doOutdated, bool doTsC, bool doTsS, bool oscillatory = false);
     void addTmOrg(bool substituted);
     void addTmValidity(bool invalid);
 
-    Datapoint* toDatapoint() {return m_dp;}
+    /**
+     * @return The PIVOT datapoint, or in JSON mode a PIVOT_JSON datapoint holding the JSON of the object as a string
+    */
+    Datapoint* toDatapoint();
 
-    std::vector<Datapoint*> toHnzCommandObject(std::shared_ptr<HNZPivotDataPoint> exchangeConfig) const;
+    void toHnzCommandObject(const HNZPivotDataPoint& exchangeConfig, std::vector<Datapoint*>& commandObject) const;
 
     const std::string& getIdentifier() const {return m_identifier;}
     const std::string& getComingFrom() const {return m_comingFrom;}
     int getCause() const {return m_cause;}
     bool isConfirmation() const {return m_isConfirmation;}
+    /* Value of a command (ctlVal), as sent in the HNZ command */
+    long getCommandValue() const {return intVal;}
 
     HnzValidity getValidity() const {return m_validity;}
     HnzSource getSource() const {return m_source;}
@@ -173,9 +200,14 @@ private:
     void handleDetailQuality(Datapoint* detailQuality);
     void handleQuality(Datapoint* q);
 
-    Datapoint* m_dp;
-    Datapoint* m_ln;
-    Datapoint* m_cdc;
+    Datapoint* m_dp = nullptr;
+    Datapoint* m_ln = nullptr;
+    Datapoint* m_cdc = nullptr;
+    bool m_compact = false;
+    /* JSON mode only: fragments of the point and fields written so far in the logical node and the CDC */
+    const HnzPivotJsonFragments* m_jsonFragments = nullptr;
+    std::string m_lnJson;
+    std::string m_cdcJson;
     HnzPivotClass m_pivotClass;
     HnzPivotCdc m_pivotCdc;
 
@@ -0,0 +1,103 @@
+/*
+ * FledgePower HNZ <-> pivot filter outdated storm.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_OUTDATED_STORM_H
+#define _HNZ_PIVOT_OUTDATED_STORM_H
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class Datapoint;
+class Reading;
+class HNZPivotConfig;
+class HNZPivotDataPoint;
+
+/**
+ * Detection of the storms of quality readings sent by the HNZ south plugin when the link with a station is lost:
+ * a data_object marked outdated, without value, for every TS and TM of the station at once.
+ * When the outdated data_objects of a station in a reading set reach a ratio of the TS and TM configured for this
+ * station, they are replaced by a single station quality event listing the pivot ids of the points.
+ */
+class HnzPivotOutdatedStorm
+{
+public:
+    /*
+     * Outdated data_object of a point, in the reading it belongs to
+    */
+    struct Point {
+        Reading* reading;
+        Datapoint* dataObject;
+        const HNZPivotDataPoint* exchangeConfig;
+        size_t pointIndex;
+    };
+
+    /*
+     * Outdated data_objects of a station forming a storm
+    */
+    struct Storm {
+        unsigned int station = 0;
+        bool invalid = false;
+        std::vector<Point> points;
+    };
+
+    /**
+     * @param ratio : Percentage of the TS and TM of a station that have to be outdated in the same reading set,
+     * 0 to disable the detection
+    */
+    void setRatio(unsigned int ratio) {m_ratio = ratio;}
+    unsigned int getRatio() const {return m_ratio;}
+    bool isEnabled() const {return m_ratio > 0;}
+
+    /**
+     * Count the TS and TM configured for each station
+     * @param config : Configuration of the exchanged data
+    */
+    void setConfig(const HNZPivotConfig& config);
+    /**
+     * @param station : Station to look for
+     * @return Number of TS and TM of the configuration matching the station
+    */
+    size_t getMonitoringPointCount(unsigned int station) const;
+
+    /**
+     * Add an outdated data_object of the current reading set
+     * @param station : Station of the data_object
+     * @param invalid : True if the data_object is also invalid
+     * @param point : Point of the data_object
+    */
+    void addPoint(unsigned int station, bool invalid, const Point& point);
+
+    /**
+     * Move the groups of points forming a storm to storms and forget the other ones
+     * @param storms : Storms found among the points added since the last call
+    */
+    void takeStorms(std::vector<Storm>& storms);
+
+    /**
+     * Build the station quality event replacing the data_objects of a storm
+     * @param storm : Storm to convert
+     * @param timestampMs : Time of the event in milliseconds since epoch
+     * @return Newly allocated datapoint
+    */
+    static Datapoint* toDatapoint(const Storm& storm, uint64_t timestampMs);
+
+private:
+    unsigned int m_ratio = 0;
+    size_t m_anyStationCount = 0;
+    std::unordered_map<unsigned int, size_t> m_stationCounts;
+    /* Outdated points of the current reading set by station and validity */
+    std::map<std::pair<unsigned int, bool>, std::vector<Point>> m_groups;
+};
+
+#endif /* _HNZ_PIVOT_OUTDATED_STORM_H */
@@ -0,0 +1,59 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_PERFECT_HASH_H
+#define _HNZ_PIVOT_PERFECT_HASH_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Minimal perfect hash function over a fixed set of strings (hash and displace): each key is
+ * assigned to a bucket, and each bucket gets a displacement (pilot) chosen at build time so that
+ * all keys land in distinct slots of a table holding exactly one slot per key.
+ * Keys are not stored: the owner of the keys keeps the key of each slot and compares it with the key
+ * looked up, so a lookup costs a hash of the key, one probe in the table and one string comparison.
+ */
+class HnzPivotPerfectHash
+{
+public:
+    static constexpr size_t NOT_FOUND = static_cast<size_t>(-1);
+
+    /**
+     * Build the hash function
+     * @param keys : Distinct keys, only read during the build
+     * @return True if the function was built, false if no function was found (e.g. duplicated keys)
+     */
+    bool build(const std::vector<const std::string*>& keys);
+
+    /**
+     * @param key : Key to find
+     * @return Slot of the key in [0, size()) if it is one of the keys of the function. Any other key also
+     * gets a slot, the caller must compare the key with the one of the slot. NOT_FOUND if the function is empty.
+     */
+    size_t getSlot(const std::string& key) const;
+
+    size_t size() const {return m_size;}
+
+    void clear();
+
+private:
+    uint64_t m_hash(const std::string& key) const;
+    size_t m_bucket(uint64_t hash) const;
+    size_t m_slot(uint64_t hash, uint32_t pilot) const;
+
+    uint64_t m_seed = 0;
+    size_t m_size = 0;
+    std::vector<uint32_t> m_pilots;
+};
+
+#endif /* _HNZ_PIVOT_PERFECT_HASH_H */
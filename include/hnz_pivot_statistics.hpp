@@ -0,0 +1,92 @@
+/*
+ * FledgePower HNZ <-> pivot filter statistics.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_STATISTICS_H
+#define _HNZ_PIVOT_STATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+class Datapoint;
+
+/**
+ * Conversion counters of the filter, maintained with relaxed atomics so that they
+ * can be incremented from the ingest path and read from any thread.
+ */
+class HnzPivotStatistics
+{
+public:
+    /*
+     * Type of the converted datapoints
+    */
+    enum class DataType {
+        TS,
+        TM,
+        TC,
+        TVC,
+        PIVOT, // Pivot commands
+        OTHER  // Datapoints with an unknown or missing type
+    };
+    static constexpr int DATA_TYPE_COUNT = 6;
+
+    /*
+     * Outcome of the conversion of a datapoint
+    */
+    enum class Counter {
+        CONVERTED,
+        UNKNOWN_ADDRESS,
+        TYPE_MISMATCH,
+        OUT_OF_RANGE,
+        MISSING_ATTRIBUTE,
+        PASSTHROUGH,
+        SUPPRESSED // Not forwarded: chattering (TS), aggregated with the next samples (TM) or duplicate (PIVOT)
+    };
+    static constexpr int COUNTER_COUNT = 7;
+
+    HnzPivotStatistics();
+    HnzPivotStatistics(const HnzPivotStatistics& other) = delete;
+    HnzPivotStatistics& operator=(const HnzPivotStatistics& other) = delete;
+
+    void increment(DataType type, Counter counter) {
+        m_counters[index(type, counter)].fetch_add(1, std::memory_order_relaxed);
+    }
+    uint64_t get(DataType type, Counter counter) const {
+        return m_counters[index(type, counter)].load(std::memory_order_relaxed);
+    }
+    void reset();
+
+    /**
+     * Build a datapoint holding the value of all counters, grouped by data type
+     * @param name : Name of the datapoint to create
+     * @return Newly allocated datapoint
+    */
+    Datapoint* toDatapoint(const std::string& name) const;
+
+    /**
+     * Get the data type matching an HNZ typeid ("TS", "TM", "TC", "TVC")
+     * @param typeIdStr : HNZ typeid
+     * @return Matching data type, DataType::OTHER if the typeid is unknown
+    */
+    static DataType dataTypeFromTypeId(const std::string& typeIdStr);
+    static std::string DataTypeStr(DataType type);
+    static std::string CounterStr(Counter counter);
+
+private:
+    static int index(DataType type, Counter counter) {
+        return static_cast<int>(type) * COUNTER_COUNT + static_cast<int>(counter);
+    }
+
+    std::array<std::atomic<uint64_t>, DATA_TYPE_COUNT * COUNTER_COUNT> m_counters;
+};
+
+#endif /* _HNZ_PIVOT_STATISTICS_H */
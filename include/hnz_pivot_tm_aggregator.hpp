@@ -0,0 +1,123 @@
+/*
+ * FledgePower HNZ <-> pivot filter TM aggregator.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#ifndef _HNZ_PIVOT_TM_AGGREGATOR_H
+#define _HNZ_PIVOT_TM_AGGREGATOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Aggregation of the TM samples of each point over a time window: only one value per window (the last, mean,
+ * minimum or maximum of its samples) is forwarded.
+ * The sample of an idle point is forwarded immediately and opens a window. The samples received during the window
+ * are aggregated, and their aggregate is forwarded when the window ends: by the first sample received after it, or
+ * by flush() if the point is quiet. The window of a point which had no sample ends and the point becomes idle.
+ * The accumulators of the points are kept in a flat array indexed by the point index of the configuration.
+ */
+class HnzPivotTmAggregator
+{
+public:
+    enum class Mode {
+        NONE, // Every sample is forwarded
+        LAST,
+        MEAN,
+        MIN,
+        MAX
+    };
+
+    /**
+     * @param mode : Value forwarded for each window, NONE to disable the aggregation
+     * @param windowMs : Duration of the window in milliseconds
+    */
+    void setWindow(Mode mode, uint64_t windowMs);
+    Mode getMode() const {return m_mode;}
+    uint64_t getWindowMs() const {return m_windowMs;}
+    bool isEnabled() const {return m_mode != Mode::NONE;}
+
+    /**
+     * Forget the samples of all points
+     * @param pointCount : Number of points of the configuration
+    */
+    void reset(size_t pointCount);
+
+    /**
+     * Move the state of the points to their index in a new configuration
+     * @param pointIndexes : Index of each point in the new configuration, as filled by HNZPivotConfig::mapPointIndexes,
+     * the state of the points without index is forgotten
+     * @param pointCount : Number of points of the new configuration
+    */
+    void remap(const std::vector<size_t>& pointIndexes, size_t pointCount);
+
+    /**
+     * Add a sample to the window of a point
+     * @param pointIndex : Index of the point in [0, pointCount)
+     * @param value : Value of the sample
+     * @param nowMs : Time of the sample in milliseconds
+     * @param aggregate : Value to forward, only set if this function returns true
+     * @return True if a value has to be forwarded: the sample opened a window, or closed the window of the point
+     * (the aggregate then includes the sample)
+    */
+    bool addSample(size_t pointIndex, long value, uint64_t nowMs, long& aggregate);
+
+    struct Aggregate {
+        size_t pointIndex;
+        long value;
+    };
+
+    /**
+     * End the windows which are over: the aggregate of their samples is returned, or the point becomes idle if
+     * there was none. To be called before the samples received at the same time are added.
+     * @param nowMs : Current time in milliseconds
+     * @param aggregates : Aggregates to forward, appended to the vector
+    */
+    void flush(uint64_t nowMs, std::vector<Aggregate>& aggregates);
+
+    /**
+     * Drop the samples of the current window of a point, e.g. when a quality change is forwarded: the point
+     * becomes idle and its next sample is forwarded immediately
+     * @param pointIndex : Index of the point in [0, pointCount)
+    */
+    void discard(size_t pointIndex);
+
+    static std::string ModeStr(Mode mode);
+    /**
+     * @param modeStr : Name of a mode ("none", "last", "mean", "min", "max")
+     * @param mode : Matching mode
+     * @return False if the name is not a mode
+    */
+    static bool modeFromStr(const std::string& modeStr, Mode& mode);
+
+private:
+    struct Accumulator {
+        bool open = false;
+        // Point listed in m_openPoints
+        bool listed = false;
+        uint64_t windowStartMs = 0;
+        uint32_t count = 0;
+        int64_t sum = 0;
+        long min = 0;
+        long max = 0;
+        long last = 0;
+    };
+
+    long m_aggregate(const Accumulator& point) const;
+    void m_open(size_t pointIndex, uint64_t nowMs);
+
+    Mode m_mode = Mode::NONE;
+    uint64_t m_windowMs = 60000;
+    std::vector<Accumulator> m_points;
+    /* Points which may have an open window, checked by flush() */
+    std::vector<size_t> m_openPoints;
+};
+
+#endif /* _HNZ_PIVOT_TM_AGGREGATOR_H */
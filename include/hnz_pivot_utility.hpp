@@ -15,6 +15,7 @@
 #include <string>
 #include <vector>
 #include <logger.h>
+#include <datapoint.h>
 
 namespace HnzPivotUtility {
     /**
@@ -32,6 +33,59 @@ namespace HnzPivotUtility {
     */
     std::vector<std::string> split(const std::string& str, char sep);
 
+    /**
+     * Move the state of each point of a previous configuration to its index in a new configuration
+     * @param points : State of each point, indexed by the previous configuration then by the new one
+     * @param pointIndexes : Index of each point of the previous configuration in the new one, as filled by
+     * HNZPivotConfig::mapPointIndexes. The state of the points without index in [0, pointCount) is dropped.
+     * @param pointCount : Number of points of the new configuration
+    */
+    template <class T>
+    void remapPoints(std::vector<T>& points, const std::vector<size_t>& pointIndexes, size_t pointCount) {
+        std::vector<T> remapped(pointCount);
+        for (size_t i = 0; (i < points.size()) && (i < pointIndexes.size()); i++) {
+            if (pointIndexes[i] < pointCount) {
+                remapped[pointIndexes[i]] = std::move(points[i]);
+            }
+        }
+        points.swap(remapped);
+    }
+    /**
+     * Replace a list of point indexes of a previous configuration by their index in a new configuration,
+     * the points without index in [0, pointCount) are removed from the list
+    */
+    void remapPointList(std::vector<size_t>& pointList, const std::vector<size_t>& pointIndexes, size_t pointCount);
+
+    /**
+     * Create a datapoint holding an empty dictionary of datapoints
+     * @param name : Name of the datapoint
+     * @return The new datapoint, owned by the caller
+    */
+    Datapoint* createDp(const std::string& name);
+    /**
+     * Create a dictionary datapoint and append it to the children of a dictionary datapoint
+     * @param dp : Parent datapoint, holding a dictionary
+     * @param name : Name of the new datapoint
+     * @return The new datapoint, owned by its parent
+    */
+    Datapoint* addElement(Datapoint* dp, const std::string& name);
+
+    template <class T>
+    Datapoint* createDpWithValue(const std::string& name, const T value) {
+        DatapointValue dpv(value);
+        return new Datapoint(name, dpv);
+    }
+
+    /*
+     * Create a datapoint holding a value and append it to the children of a dictionary datapoint
+     */
+    template <class T>
+    Datapoint* addElementWithValue(Datapoint* dp, const std::string& name, const T value) {
+        Datapoint* element = createDpWithValue(name, value);
+        dp->getData().getDpVec()->push_back(element);
+        return element;
+    }
+
     /*
      * Log helper function that will log both in the Fledge syslog file and in stdout for unit tests
      */
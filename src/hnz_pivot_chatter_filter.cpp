@@ -0,0 +1,128 @@
+/*
+ * FledgePower HNZ <-> pivot filter chatter filter.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <algorithm>
+
+#include "hnz_pivot_chatter_filter.hpp"
+#include "hnz_pivot_utility.hpp"
+
+void HnzPivotChatterFilter::setLimits(unsigned int maxTransitions, uint64_t windowMs)
+{
+    m_maxTransitions = maxTransitions;
+    m_windowMs = std::max<uint64_t>(windowMs, 1);
+}
+
+void HnzPivotChatterFilter::reset(size_t pointCount)
+{
+    m_points.assign(pointCount, PointState());
+    m_chatteringPoints.clear();
+}
+
+void HnzPivotChatterFilter::remap(const std::vector<size_t>& pointIndexes, size_t pointCount)
+{
+    HnzPivotUtility::remapPoints(m_points, pointIndexes, pointCount);
+    HnzPivotUtility::remapPointList(m_chatteringPoints, pointIndexes, pointCount);
+}
+
+void HnzPivotChatterFilter::discard(size_t pointIndex)
+{
+    if (pointIndex >= m_points.size()) {
+        return;
+    }
+    if (m_points[pointIndex].chattering) {
+        m_leave(pointIndex);
+    }
+    m_points[pointIndex] = PointState();
+}
+
+uint64_t HnzPivotChatterFilter::m_slide(PointState& point, uint64_t tsMs) const
+{
+    // Transitions older than the window start (out of order) are counted in the current window
+    uint64_t elapsed = tsMs > point.windowStartMs ? tsMs - point.windowStartMs : 0;
+    if (elapsed >= 2 * m_windowMs) {
+        point.previousCount = 0;
+        point.currentCount = 0;
+        point.windowStartMs = tsMs;
+        elapsed = 0;
+    }
+    else if (elapsed >= m_windowMs) {
+        point.previousCount = point.currentCount;
+        point.currentCount = 0;
+        point.windowStartMs += m_windowMs;
+        elapsed -= m_windowMs;
+    }
+    // Transitions of the previous window still inside the sliding window, assuming they were evenly spread
+    return point.currentCount + point.previousCount * (m_windowMs - elapsed) / m_windowMs;
+}
+
+void HnzPivotChatterFilter::m_leave(size_t pointIndex)
+{
+    PointState& point = m_points[pointIndex];
+    point.chattering = false;
+    point.suppressed = false;
+    auto it = std::find(m_chatteringPoints.begin(), m_chatteringPoints.end(), pointIndex);
+    if (it != m_chatteringPoints.end()) {
+        *it = m_chatteringPoints.back();
+        m_chatteringPoints.pop_back();
+    }
+}
+
+HnzPivotChatterFilter::Decision HnzPivotChatterFilter::onTransition(size_t pointIndex, uint64_t tsMs, uint64_t arrivalMs,
+                                                                    const Transition& transition)
+{
+    if (!isEnabled() || pointIndex >= m_points.size()) {
+        return Decision::FORWARD;
+    }
+    PointState& point = m_points[pointIndex];
+    point.lastTsMs = std::max(point.lastTsMs, tsMs);
+    point.lastArrivalMs = arrivalMs;
+
+    uint64_t transitions = m_slide(point, tsMs) + 1;
+    point.currentCount++;
+
+    if (!point.chattering) {
+        if (transitions > m_maxTransitions) {
+            point.chattering = true;
+            m_chatteringPoints.push_back(pointIndex);
+            return Decision::FORWARD_OSCILLATORY;
+        }
+        return Decision::FORWARD;
+    }
+    // Released once the transitions before this one fall to half of the maximum, this one supersedes the last
+    // transition suppressed
+    if (2 * (transitions - 1) <= m_maxTransitions) {
+        m_leave(pointIndex);
+        return Decision::FORWARD;
+    }
+    point.suppressed = true;
+    point.lastSuppressed = transition;
+    return Decision::SUPPRESS;
+}
+
+void HnzPivotChatterFilter::release(uint64_t nowMs, std::vector<Released>& released)
+{
+    size_t i = 0;
+    while (i < m_chatteringPoints.size()) {
+        size_t pointIndex = m_chatteringPoints[i];
+        PointState& point = m_points[pointIndex];
+        // Timestamp matching the current time, from the time elapsed since the arrival of the last transition
+        uint64_t tsMs = point.lastTsMs + (nowMs > point.lastArrivalMs ? nowMs - point.lastArrivalMs : 0);
+        if (2 * m_slide(point, tsMs) > m_maxTransitions) {
+            i++;
+            continue;
+        }
+        if (point.suppressed) {
+            released.push_back({pointIndex, point.lastSuppressed});
+        }
+        // The point at i is replaced by the last one
+        m_leave(pointIndex);
+    }
+}
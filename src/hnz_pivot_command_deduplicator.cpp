@@ -0,0 +1,53 @@
+/*
+ * FledgePower HNZ <-> pivot filter command deduplicator.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include "hnz_pivot_command_deduplicator.hpp"
+
+constexpr size_t HnzPivotCommandDeduplicator::TABLE_SIZE;
+
+static constexpr size_t NO_POINT = static_cast<size_t>(-1);
+
+bool HnzPivotCommandDeduplicator::isDuplicate(size_t pointIndex, long value, uint64_t nowMs)
+{
+    if (!isEnabled()) {
+        return false;
+    }
+    Entry& entry = m_entries[pointIndex % TABLE_SIZE];
+    if ((entry.pointIndex == pointIndex) && (entry.value == value) && (nowMs >= entry.timeMs) &&
+        (nowMs - entry.timeMs < m_windowMs)) {
+        // The window is not extended by the duplicates, a command repeated continuously is accepted once per window
+        return true;
+    }
+    entry.pointIndex = pointIndex;
+    entry.value = value;
+    entry.timeMs = nowMs;
+    return false;
+}
+
+void HnzPivotCommandDeduplicator::reset()
+{
+    m_entries.fill(Entry{NO_POINT, 0, 0});
+}
+
+void HnzPivotCommandDeduplicator::remap(const std::vector<size_t>& pointIndexes, size_t pointCount)
+{
+    std::array<Entry, TABLE_SIZE> entries = m_entries;
+    reset();
+    for (const Entry& entry : entries) {
+        if ((entry.pointIndex >= pointIndexes.size()) || (pointIndexes[entry.pointIndex] >= pointCount)) {
+            continue;
+        }
+        // A point may move to an entry already taken by another one, one of them is then forgotten
+        Entry& remapped = m_entries[pointIndexes[entry.pointIndex] % TABLE_SIZE];
+        remapped = entry;
+        remapped.pointIndex = pointIndexes[entry.pointIndex];
+    }
+}
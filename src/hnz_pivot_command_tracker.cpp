@@ -0,0 +1,157 @@
+/*
+ * FledgePower HNZ <-> pivot filter command tracker.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <vector>
+#include <datapoint.h>
+
+#include "hnz_pivot_command_tracker.hpp"
+#include "hnz_pivot_utility.hpp"
+
+constexpr int HnzPivotCommandTracker::COUNTER_COUNT;
+
+HnzPivotCommandTracker::HnzPivotCommandTracker():
+    m_timeout(std::chrono::seconds(10))
+{
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+void HnzPivotCommandTracker::remap(const std::vector<size_t>& pointIndexes, size_t pointCount)
+{
+    HnzPivotUtility::remapPoints(m_points, pointIndexes, pointCount);
+    HnzPivotUtility::remapPointList(m_pendingPoints, pointIndexes, pointCount);
+    size_t pendingCount = 0;
+    for (size_t pointIndex : m_pendingPoints) {
+        pendingCount += m_points[pointIndex].pending.size();
+    }
+    m_pendingCount = pendingCount;
+}
+
+void HnzPivotCommandTracker::commandSent(size_t pointIndex, Clock::time_point now)
+{
+    m_increment(Counter::SENT);
+    if (pointIndex >= m_points.size()) {
+        return; //LCOV_EXCL_LINE
+    }
+    PointState& point = m_points[pointIndex];
+    // Commands are rare, expiring the point here keeps its pending commands bounded even if the statistics are disabled
+    m_expire(point, now);
+    point.pending.push_back(now);
+    m_pendingCount.fetch_add(1, std::memory_order_relaxed);
+    if (!point.listed) {
+        point.listed = true;
+        m_pendingPoints.push_back(pointIndex);
+    }
+}
+
+bool HnzPivotCommandTracker::ackReceived(size_t pointIndex, Clock::time_point now)
+{
+    if ((pointIndex >= m_points.size()) || m_points[pointIndex].pending.empty()) {
+        m_increment(Counter::UNEXPECTED_ACK);
+        return false;
+    }
+    std::vector<Clock::time_point>& pending = m_points[pointIndex].pending;
+    Clock::duration roundTrip = now - pending.front();
+    pending.erase(pending.begin());
+    m_pendingCount.fetch_sub(1, std::memory_order_relaxed);
+    if (roundTrip > getTimeout()) {
+        // ACK received before the command expired, but too late
+        m_increment(Counter::TIMED_OUT);
+        return false;
+    }
+    m_roundTrip.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(roundTrip).count()));
+    m_increment(Counter::ACKNOWLEDGED);
+    return true;
+}
+
+void HnzPivotCommandTracker::expire(Clock::time_point now)
+{
+    size_t i = 0;
+    while (i < m_pendingPoints.size()) {
+        PointState& point = m_points[m_pendingPoints[i]];
+        m_expire(point, now);
+        if (point.pending.empty()) {
+            point.listed = false;
+            m_pendingPoints[i] = m_pendingPoints.back();
+            m_pendingPoints.pop_back();
+        }
+        else {
+            i++;
+        }
+    }
+}
+
+void HnzPivotCommandTracker::m_expire(PointState& point, Clock::time_point now)
+{
+    // Commands of a point are sorted by time sent
+    auto pendingEnd = point.pending.begin();
+    while ((pendingEnd != point.pending.end()) && (now - *pendingEnd > getTimeout())) {
+        pendingEnd++;
+    }
+    size_t expired = static_cast<size_t>(pendingEnd - point.pending.begin());
+    if (expired == 0) {
+        return;
+    }
+    point.pending.erase(point.pending.begin(), pendingEnd);
+    m_pendingCount.fetch_sub(expired, std::memory_order_relaxed);
+    m_counters[static_cast<int>(Counter::TIMED_OUT)].fetch_add(expired, std::memory_order_relaxed);
+}
+
+void HnzPivotCommandTracker::reset()
+{
+    for (size_t pointIndex : m_pendingPoints) {
+        m_points[pointIndex] = PointState();
+    }
+    m_pendingPoints.clear();
+    m_pendingCount = 0;
+    m_roundTrip.reset();
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+Datapoint* HnzPivotCommandTracker::toDatapoint(const std::string& name) const
+{
+    Datapoint* commands = HnzPivotUtility::createDp(name);
+
+    for (int counterIndex = 0; counterIndex < COUNTER_COUNT; counterIndex++) {
+        auto counter = static_cast<Counter>(counterIndex);
+        HnzPivotUtility::addElementWithValue(commands, CounterStr(counter), static_cast<long>(get(counter)));
+    }
+    HnzPivotUtility::addElementWithValue(commands, "pending", static_cast<long>(getPendingCount()));
+
+    // Round-trip times in microseconds
+    HnzPivotHistogram::Snapshot roundTrip = getRoundTripSnapshot();
+    Datapoint* roundTripDp = HnzPivotUtility::addElement(commands, "round_trip_us");
+    HnzPivotUtility::addElementWithValue(roundTripDp, "min", static_cast<long>(roundTrip.min));
+    HnzPivotUtility::addElementWithValue(roundTripDp, "mean", static_cast<long>(roundTrip.mean()));
+    HnzPivotUtility::addElementWithValue(roundTripDp, "p50", static_cast<long>(roundTrip.percentile(50)));
+    HnzPivotUtility::addElementWithValue(roundTripDp, "p99", static_cast<long>(roundTrip.percentile(99)));
+    HnzPivotUtility::addElementWithValue(roundTripDp, "max", static_cast<long>(roundTrip.max));
+
+    return commands;
+}
+
+std::string HnzPivotCommandTracker::CounterStr(Counter counter)
+{
+    switch (counter) {
+        case Counter::SENT:
+            return "sent";
+        case Counter::ACKNOWLEDGED:
+            return "acknowledged";
+        case Counter::TIMED_OUT:
+            return "timed_out";
+        case Counter::UNEXPECTED_ACK:
+            return "unexpected_ack";
+    }
+    return "";
+}
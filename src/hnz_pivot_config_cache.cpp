@@ -0,0 +1,336 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <utils.h>
+
+#include "hnz_pivot_utility.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_config_cache.hpp"
+
+/*
+ * Layout of the cache file, in the byte order of the host:
+ * - FileHeader
+ * - definitionCount DefinitionRecord, one per entry of the exchange definitions
+ * - lookupCount LookupRecord, one per entry of the pivot id lookup table, in the order of the table
+ * - stringsSize bytes of strings referenced by the records (offset and length in this block)
+ * The checksum covers everything after the header. The version must be increased whenever the layout or
+ * the way the JSON is compiled into the lookup tables changes, so that older files are ignored.
+ */
+static constexpr char CACHE_MAGIC[8] = {'H', 'N', 'Z', 'P', 'C', 'F', 'G', '\0'};
+static constexpr uint32_t CACHE_VERSION = 3;
+
+namespace {
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t definitionCount;
+    uint32_t lookupCount;
+    uint32_t reserved;
+    uint64_t configSize;
+    uint64_t configHash;
+    uint64_t configCheckHash;
+    uint64_t stringsSize;
+    uint64_t checksum;
+};
+
+struct StringRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+struct DefinitionRecord {
+    StringRef label;
+    StringRef pivotId;
+    StringRef pivotType;
+    StringRef typeId;
+    uint32_t address;
+    uint32_t hasStation;
+    uint32_t station;
+};
+
+struct LookupRecord {
+    StringRef typeId;
+    StringRef pivotId;
+    uint32_t address;
+    uint32_t hasStation;
+    uint32_t station;
+};
+
+} // namespace
+
+static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+static constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+static uint64_t fnv1a(const char* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS)
+{
+    for (size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static constexpr uint64_t CHECK_MULTIPLIER = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t checkHash(const char* data, size_t size)
+{
+    uint64_t hash = 0;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash + static_cast<unsigned char>(data[i]) + 1) * CHECK_MULTIPLIER;
+        hash ^= hash >> 29;
+    }
+    return hash;
+}
+
+HnzPivotConfigCache::ConfigKey HnzPivotConfigCache::keyConfig(const std::string& exchangeConfig)
+{
+    ConfigKey key;
+    key.size = exchangeConfig.size();
+    key.hash = fnv1a(exchangeConfig.data(), exchangeConfig.size());
+    key.checkHash = checkHash(exchangeConfig.data(), exchangeConfig.size());
+    return key;
+}
+
+std::string HnzPivotConfigCache::defaultPath(const std::string& filterName)
+{
+    // The filter name is used as file name, keep only the characters that are safe in a path
+    std::string fileName = filterName;
+    for (char& c : fileName) {
+        if (!isalnum(static_cast<unsigned char>(c)) && c != '-' && c != '_') {
+            c = '_';
+        }
+    }
+    return getDataDir() + "/" + FILTER_NAME + "/" + fileName + ".cache";
+}
+
+bool HnzPivotConfigCache::importExchangeConfig(HNZPivotConfig& config, const std::string& exchangeConfig,
+                                               const ConfigKey& configKey) const
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HnzPivotConfigCache::importExchangeConfig -"; //LCOV_EXCL_LINE
+    if (load(config, configKey)) {
+        HnzPivotUtility::log_info("%s Loaded %lu exchanged data definitions from %s", beforeLog.c_str(), //LCOV_EXCL_LINE
+                                  static_cast<unsigned long>(config.getExchangeDefinitions().size()), m_path.c_str()); //LCOV_EXCL_LINE
+        return true;
+    }
+    config.importExchangeConfig(exchangeConfig);
+    if (config.isComplete()) {
+        save(config, configKey);
+    }
+    return false;
+}
+
+namespace {
+
+/*
+ * Read-only view on the records and strings of a memory mapped cache file
+ */
+class CacheImage
+{
+public:
+    CacheImage(const char* data, size_t size): m_data(data), m_size(size) {}
+
+    const FileHeader& header() const {return *reinterpret_cast<const FileHeader*>(m_data);}
+
+    bool isValid(const HnzPivotConfigCache::ConfigKey& configKey) const {
+        if (m_size < sizeof(FileHeader)) return false;
+        const FileHeader& h = header();
+        if (memcmp(h.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0) return false;
+        if (h.version != CACHE_VERSION) return false;
+        if (h.configSize != configKey.size || h.configHash != configKey.hash || h.configCheckHash != configKey.checkHash) {
+            return false;
+        }
+        uint64_t expectedSize = sizeof(FileHeader) + h.definitionCount * sizeof(DefinitionRecord) +
+                                h.lookupCount * sizeof(LookupRecord) + h.stringsSize;
+        if (expectedSize != m_size) return false;
+        return fnv1a(m_data + sizeof(FileHeader), m_size - sizeof(FileHeader)) == h.checksum;
+    }
+
+    const DefinitionRecord* definitions() const {
+        return reinterpret_cast<const DefinitionRecord*>(m_data + sizeof(FileHeader));
+    }
+
+    const LookupRecord* lookups() const {
+        return reinterpret_cast<const LookupRecord*>(definitions() + header().definitionCount);
+    }
+
+    bool getString(const StringRef& ref, std::string& out) const {
+        if (static_cast<uint64_t>(ref.offset) + ref.length > header().stringsSize) return false;
+        const char* strings = reinterpret_cast<const char*>(lookups() + header().lookupCount);
+        out.assign(strings + ref.offset, ref.length);
+        return true;
+    }
+
+private:
+    const char* m_data;
+    size_t m_size;
+};
+
+} // namespace
+
+bool HnzPivotConfigCache::load(HNZPivotConfig& config, const ConfigKey& configKey) const
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HnzPivotConfigCache::load -"; //LCOV_EXCL_LINE
+    int fd = open(m_path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        HnzPivotUtility::log_debug("%s No cache file %s", beforeLog.c_str(), m_path.c_str()); //LCOV_EXCL_LINE
+        return false;
+    }
+    struct stat fileStat;
+    if ((fstat(fd, &fileStat) != 0) || (fileStat.st_size < static_cast<off_t>(sizeof(FileHeader)))) {
+        close(fd);
+        HnzPivotUtility::log_warn("%s Invalid cache file %s", beforeLog.c_str(), m_path.c_str()); //LCOV_EXCL_LINE
+        return false;
+    }
+    auto size = static_cast<size_t>(fileStat.st_size);
+    void* mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        HnzPivotUtility::log_warn("%s Could not map cache file %s: %s", beforeLog.c_str(), m_path.c_str(), strerror(errno)); //LCOV_EXCL_LINE
+        return false;
+    }
+
+    CacheImage image(static_cast<const char*>(mapping), size);
+    bool loaded = image.isValid(configKey);
+    // The filter looks datapoints up through std::map, so the tables are rebuilt from the image
+    // before the mapping is released. Records were saved in key order, they are appended at the end of the maps.
+    std::map<std::string, std::shared_ptr<HNZPivotDataPoint>> exchangeDefinitions;
+    std::vector<HNZPivotConfig::LookupEntry> pivotIdLookup;
+    if (loaded) {
+        std::string label;
+        std::string pivotId;
+        std::string pivotType;
+        std::string typeId;
+        const DefinitionRecord* definitions = image.definitions();
+        for (uint32_t i = 0; loaded && i < image.header().definitionCount; i++) {
+            const DefinitionRecord& record = definitions[i];
+            loaded = image.getString(record.label, label) && image.getString(record.pivotId, pivotId) &&
+                     image.getString(record.pivotType, pivotType) && image.getString(record.typeId, typeId);
+            if (loaded) {
+                exchangeDefinitions.emplace_hint(exchangeDefinitions.end(), pivotId,
+                                                std::make_shared<HNZPivotDataPoint>(label, pivotId, pivotType, typeId, record.address,
+                                                                                    record.hasStation != 0, record.station));
+            }
+        }
+        const LookupRecord* lookups = image.lookups();
+        pivotIdLookup.resize(image.header().lookupCount);
+        for (uint32_t i = 0; loaded && i < image.header().lookupCount; i++) {
+            const LookupRecord& record = lookups[i];
+            HNZPivotConfig::LookupEntry& entry = pivotIdLookup[i];
+            loaded = image.getString(record.typeId, entry.typeIdStr) && image.getString(record.pivotId, entry.pivotId);
+            entry.address = record.address;
+            entry.hasStation = record.hasStation != 0;
+            entry.station = record.station;
+        }
+    }
+    munmap(mapping, size);
+
+    if (!loaded) {
+        HnzPivotUtility::log_debug("%s Cache file %s is outdated or invalid", beforeLog.c_str(), m_path.c_str()); //LCOV_EXCL_LINE
+        return false;
+    }
+    config.m_exchangeDefinitions.swap(exchangeDefinitions);
+    config.m_pivotIdLookup.swap(pivotIdLookup);
+    config.m_buildIndexes();
+    // Only complete configurations are saved
+    config.m_exchange_data_is_complete = true;
+    return true;
+}
+
+static StringRef appendString(std::string& strings, const std::string& str)
+{
+    StringRef ref = {static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(str.size())};
+    strings += str;
+    return ref;
+}
+
+static void appendRecord(std::string& buffer, const void* record, size_t size)
+{
+    buffer.append(static_cast<const char*>(record), size);
+}
+
+bool HnzPivotConfigCache::save(const HNZPivotConfig& config, const ConfigKey& configKey) const
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HnzPivotConfigCache::save -"; //LCOV_EXCL_LINE
+    std::string records;
+    std::string strings;
+    for (const auto& entry : config.m_exchangeDefinitions) {
+        const HNZPivotDataPoint& dataPoint = *entry.second;
+        DefinitionRecord record;
+        record.label = appendString(strings, dataPoint.getLabel());
+        record.pivotId = appendString(strings, dataPoint.getPivotId());
+        record.pivotType = appendString(strings, dataPoint.getPivotType());
+        record.typeId = appendString(strings, dataPoint.getTypeId());
+        record.address = dataPoint.getAddress();
+        record.hasStation = dataPoint.hasStation() ? 1 : 0;
+        record.station = dataPoint.getStation();
+        appendRecord(records, &record, sizeof(record));
+    }
+    for (const HNZPivotConfig::LookupEntry& entry : config.m_pivotIdLookup) {
+        LookupRecord record;
+        record.typeId = appendString(strings, entry.typeIdStr);
+        record.pivotId = appendString(strings, entry.pivotId);
+        record.address = entry.address;
+        record.hasStation = entry.hasStation ? 1 : 0;
+        record.station = entry.station;
+        appendRecord(records, &record, sizeof(record));
+    }
+    records += strings;
+
+    FileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+    header.version = CACHE_VERSION;
+    header.definitionCount = static_cast<uint32_t>(config.m_exchangeDefinitions.size());
+    header.lookupCount = static_cast<uint32_t>(config.m_pivotIdLookup.size());
+    header.configSize = configKey.size;
+    header.configHash = configKey.hash;
+    header.configCheckHash = configKey.checkHash;
+    header.stringsSize = strings.size();
+    header.checksum = fnv1a(records.data(), records.size());
+
+    // Create the directory of the cache file, its parent (the Fledge data directory) must exist
+    size_t separator = m_path.rfind('/');
+    if (separator != std::string::npos && separator > 0) {
+        std::string directory = m_path.substr(0, separator);
+        if ((mkdir(directory.c_str(), 0755) != 0) && (errno != EEXIST)) {
+            HnzPivotUtility::log_warn("%s Could not create directory %s: %s", beforeLog.c_str(), directory.c_str(), strerror(errno)); //LCOV_EXCL_LINE
+            return false;
+        }
+    }
+
+    // Write a temporary file then rename it, so that a filter starting meanwhile never maps a partial file
+    std::string tmpPath = m_path + ".tmp";
+    FILE* file = fopen(tmpPath.c_str(), "wb");
+    if (file == nullptr) {
+        HnzPivotUtility::log_warn("%s Could not create cache file %s: %s", beforeLog.c_str(), tmpPath.c_str(), strerror(errno)); //LCOV_EXCL_LINE
+        return false;
+    }
+    bool written = (fwrite(&header, sizeof(header), 1, file) == 1) &&
+                   (records.empty() || fwrite(records.data(), records.size(), 1, file) == 1);
+    written = (fclose(file) == 0) && written;
+    if (!written || (rename(tmpPath.c_str(), m_path.c_str()) != 0)) {
+        HnzPivotUtility::log_warn("%s Could not write cache file %s: %s", beforeLog.c_str(), m_path.c_str(), strerror(errno)); //LCOV_EXCL_LINE
+        remove(tmpPath.c_str());
+        return false;
+    }
+    HnzPivotUtility::log_debug("%s Saved %lu exchanged data definitions to %s", beforeLog.c_str(), //LCOV_EXCL_LINE
+                               static_cast<unsigned long>(header.definitionCount), m_path.c_str()); //LCOV_EXCL_LINE
+    return true;
+}
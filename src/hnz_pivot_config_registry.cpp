@@ -0,0 +1,118 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <map>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_config_registry.hpp"
+
+using ConfigKey = std::pair<uint64_t, size_t>;
+
+namespace {
+
+/*
+ * Configuration of a JSON. The registry only holds a weak reference: the configurations are owned by the filter
+ * instances
+ */
+struct Entry {
+    explicit Entry(const std::string& json): exchangedData(json) {}
+
+    const std::string exchangedData;
+    /* Held while the configuration is built */
+    std::mutex buildMutex;
+    std::weak_ptr<const HNZPivotConfig> config;
+};
+
+} // namespace
+
+static std::mutex& registryMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+/*
+ * Entries by hash and size of their JSON, several different JSONs may share a key
+ */
+static std::map<ConfigKey, std::vector<std::shared_ptr<Entry>>>& registryEntries()
+{
+    static std::map<ConfigKey, std::vector<std::shared_ptr<Entry>>> entries;
+    return entries;
+}
+
+static void removeExpiredEntries()
+{
+    auto& entries = registryEntries();
+    for (auto it = entries.begin(); it != entries.end();) {
+        std::vector<std::shared_ptr<Entry>>& sameKey = it->second;
+        // Entries being built are also referenced by the thread building them
+        for (auto entryIt = sameKey.begin(); entryIt != sameKey.end();) {
+            if ((*entryIt)->config.expired() && (entryIt->use_count() == 1)) {
+                entryIt = sameKey.erase(entryIt);
+            }
+            else {
+                ++entryIt;
+            }
+        }
+        if (sameKey.empty()) {
+            it = entries.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+std::shared_ptr<const HNZPivotConfig> HnzPivotConfigRegistry::get(const std::string& exchangedData, uint64_t configHash,
+                                                                  const Builder& builder)
+{
+    std::shared_ptr<Entry> entry;
+    {
+        std::lock_guard<std::mutex> guard(registryMutex());
+        removeExpiredEntries();
+        std::vector<std::shared_ptr<Entry>>& sameKey = registryEntries()[ConfigKey(configHash, exchangedData.size())];
+        for (const std::shared_ptr<Entry>& candidate : sameKey) {
+            if (candidate->exchangedData == exchangedData) {
+                entry = candidate;
+                break;
+            }
+        }
+        if (entry == nullptr) {
+            entry = std::make_shared<Entry>(exchangedData);
+            sameKey.push_back(entry);
+        }
+    }
+
+    // Built outside of the registry lock, other JSONs can be looked up and built meanwhile
+    std::lock_guard<std::mutex> buildGuard(entry->buildMutex);
+    std::shared_ptr<const HNZPivotConfig> config = entry->config.lock();
+    if (config == nullptr) {
+        auto newConfig = std::make_shared<HNZPivotConfig>();
+        builder(*newConfig);
+        config = newConfig;
+        entry->config = config;
+    }
+    return config;
+}
+
+size_t HnzPivotConfigRegistry::getConfigCount()
+{
+    std::lock_guard<std::mutex> guard(registryMutex());
+    removeExpiredEntries();
+    size_t count = 0;
+    for (const auto& sameKey : registryEntries()) {
+        count += sameKey.second.size();
+    }
+    return count;
+}
@@ -0,0 +1,131 @@
+/*
+ * FledgePower HNZ <-> pivot filter data age.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <algorithm>
+#include <vector>
+#include <datapoint.h>
+
+#include "hnz_pivot_data_age.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_utility.hpp"
+
+constexpr unsigned int HnzPivotDataAge::MAX_INDEXED_STATIONS;
+
+void HnzPivotDataAge::setConfig(const HNZPivotConfig& config)
+{
+    size_t slotCount = 0;
+    for (size_t i = 0; i < config.getPointCount(); i++) {
+        const HNZPivotDataPoint* dataPoint = config.getDataPoint(i);
+        if (!dataPoint->hasStation()) {
+            slotCount = MAX_INDEXED_STATIONS;
+            break;
+        }
+        slotCount = std::max<size_t>(slotCount, dataPoint->getStation() + 1);
+    }
+    slotCount = std::min<size_t>(slotCount, MAX_INDEXED_STATIONS);
+
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    m_stationSlots.assign(slotCount, nullptr);
+    for (const auto& station : m_stations) {
+        if (station.first < slotCount) {
+            m_stationSlots[station.first] = station.second.get();
+        }
+    }
+}
+
+HnzPivotDataAge::Station* HnzPivotDataAge::m_addStation(unsigned int station)
+{
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    std::unique_ptr<Station>& stationData = m_stations[station];
+    if (!stationData) {
+        stationData.reset(new Station());
+    }
+    if (station < m_stationSlots.size()) {
+        m_stationSlots[station] = stationData.get();
+    }
+    return stationData.get();
+}
+
+bool HnzPivotDataAge::record(unsigned int station, uint64_t eventTimeMs, uint64_t arrivalTimeMs)
+{
+    Station* stationData = station < m_stationSlots.size() ? m_stationSlots[station] : nullptr;
+    if (stationData == nullptr) {
+        stationData = m_addStation(station);
+    }
+    if (eventTimeMs > arrivalTimeMs) {
+        stationData->inFuture.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    uint64_t ageMs = arrivalTimeMs - eventTimeMs;
+    stationData->age.record(ageMs);
+    if (ageMs > m_thresholdMs.load(std::memory_order_relaxed)) {
+        stationData->overThreshold.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    return false;
+}
+
+void HnzPivotDataAge::setThresholdMs(uint64_t thresholdMs)
+{
+    m_thresholdMs = thresholdMs;
+}
+
+uint64_t HnzPivotDataAge::getThresholdMs() const
+{
+    return m_thresholdMs;
+}
+
+bool HnzPivotDataAge::getStationSnapshot(unsigned int station, StationSnapshot& snapshot) const
+{
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    auto stationIt = m_stations.find(station);
+    if (stationIt == m_stations.end()) {
+        return false;
+    }
+    snapshot.age = stationIt->second->age.snapshot();
+    snapshot.overThreshold = stationIt->second->overThreshold;
+    snapshot.inFuture = stationIt->second->inFuture;
+    return true;
+}
+
+size_t HnzPivotDataAge::getStationCount() const
+{
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    return m_stations.size();
+}
+
+void HnzPivotDataAge::reset()
+{
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    m_stations.clear();
+    std::fill(m_stationSlots.begin(), m_stationSlots.end(), nullptr);
+}
+
+Datapoint* HnzPivotDataAge::toDatapoint(const std::string& name) const
+{
+    std::lock_guard<std::mutex> guard(m_stationsMutex);
+    Datapoint* dataAge = HnzPivotUtility::createDp(name);
+
+    HnzPivotUtility::addElementWithValue(dataAge, "threshold_ms", static_cast<long>(m_thresholdMs.load()));
+    Datapoint* stations = HnzPivotUtility::addElement(dataAge, "stations");
+    for (const auto& station : m_stations) {
+        HnzPivotHistogram::Snapshot age = station.second->age.snapshot();
+        Datapoint* stationDp = HnzPivotUtility::addElement(stations, std::to_string(station.first));
+        HnzPivotUtility::addElementWithValue(stationDp, "count", static_cast<long>(age.count));
+        HnzPivotUtility::addElementWithValue(stationDp, "p50_ms", static_cast<long>(age.percentile(50)));
+        HnzPivotUtility::addElementWithValue(stationDp, "p99_ms", static_cast<long>(age.percentile(99)));
+        HnzPivotUtility::addElementWithValue(stationDp, "max_ms", static_cast<long>(age.max));
+        HnzPivotUtility::addElementWithValue(stationDp, "over_threshold", static_cast<long>(station.second->overThreshold.load()));
+        HnzPivotUtility::addElementWithValue(stationDp, "in_future", static_cast<long>(station.second->inFuture.load()));
+    }
+
+    return dataAge;
+}
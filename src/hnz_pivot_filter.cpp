@@ -9,31 +9,43 @@
  * 
  */
 
+#include <algorithm>
 #include <plugin_api.h>
 
 #include "hnz_pivot_filter.hpp"
 #include "hnz_pivot_object.hpp"
 #include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_config_registry.hpp"
 #include "hnz_pivot_utility.hpp"
 
+using DataType = HnzPivotStatistics::DataType;
+using Counter = HnzPivotStatistics::Counter;
 
 HNZPivotFilter::HNZPivotFilter(const std::string& filterName, ConfigCategory& filterConfig,
                                 OUTPUT_HANDLE *outHandle, OUTPUT_STREAM output):
         FledgeFilter(filterName, filterConfig, outHandle, output),
-        m_filterConfig(std::make_shared<HNZPivotConfig>())
+        m_filterConfig(std::make_shared<HNZPivotConfig>()),
+        // The configuration category is named after the filter instance
+        m_configCache(HnzPivotConfigCache::defaultPath(filterConfig.getName()))
 {
     (void)filterName; /* ignore parameter */
     readConfig(filterConfig);
+    updateIngestThread();
 }
 
-static bool checkLabelMatch(const std::string& incomingLabel, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+HNZPivotFilter::~HNZPivotFilter()
 {
-    return incomingLabel == exchangeConfig->getLabel();
+    stopIngestThread();
 }
 
-static bool checkPivotTypeMatch(const std::string& incomingType, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+static bool checkLabelMatch(const std::string& incomingLabel, const HNZPivotDataPoint& exchangeConfig)
 {
-    const std::string& pivotType = exchangeConfig->getPivotType();
+    return incomingLabel == exchangeConfig.getLabel();
+}
+
+static bool checkPivotTypeMatch(const std::string& incomingType, const HNZPivotDataPoint& exchangeConfig)
+{
+    const std::string& pivotType = exchangeConfig.getPivotType();
     if (incomingType == "TS") {
         return (pivotType == "SpsTyp") || (pivotType == "DpsTyp");
     }
@@ -117,8 +129,9 @@ void HNZPivotFilter::readAttribute(std::map<std::string, bool>& attributeFound,
     }
 }
 
-Datapoint* HNZPivotFilter::convertDatapointToPivot(const std::string& assetName, Datapoint* sourceDp)
+Datapoint* HNZPivotFilter::convertDatapointToPivot(const std::string& assetName, Datapoint* sourceDp, bool& suppressed)
 {
+    suppressed = false;
     Datapoint* convertedDatapoint = nullptr;
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertDatapointToPivot -"; //LCOV_EXCL_LINE
 
@@ -145,214 +158,359 @@ Datapoint* HNZPivotFilter::convertDatapointToPivot(const std::string& assetName,
 
     GenericDataObject dataObject;
 
-    for (Datapoint* dp : *datapoints)
     {
-        readAttribute(attributeFound, dp, "do_type", dataObject.doType);
-        readAttribute(attributeFound, dp, "do_station", dataObject.doStation);
-        readAttribute(attributeFound, dp, "do_addr", dataObject.doAddress);
-        readAttribute(attributeFound, dp, "do_value", dataObject.doValue);
-        readAttribute(attributeFound, dp, "do_valid", dataObject.doValid);
-        readAttribute(attributeFound, dp, "do_an", dataObject.doAn);
-        readAttribute(attributeFound, dp, "do_cg", dataObject.doCg);
-        readAttribute(attributeFound, dp, "do_outdated", dataObject.doOutdated);
-        readAttribute(attributeFound, dp, "do_ts", dataObject.doTs);
-        readAttribute(attributeFound, dp, "do_ts_iv", dataObject.doTsIv);
-        readAttribute(attributeFound, dp, "do_ts_c", dataObject.doTsC);
-        readAttribute(attributeFound, dp, "do_ts_s", dataObject.doTsS);
+        HNZ_PIVOT_TIME_SCOPE(latencyHistogram(LatencyStage::DECODE));
+        for (Datapoint* dp : *datapoints)
+        {
+            readAttribute(attributeFound, dp, "do_type", dataObject.doType);
+            readAttribute(attributeFound, dp, "do_station", dataObject.doStation);
+            readAttribute(attributeFound, dp, "do_addr", dataObject.doAddress);
+            readAttribute(attributeFound, dp, "do_value", dataObject.doValue);
+            readAttribute(attributeFound, dp, "do_valid", dataObject.doValid);
+            readAttribute(attributeFound, dp, "do_an", dataObject.doAn);
+            readAttribute(attributeFound, dp, "do_cg", dataObject.doCg);
+            readAttribute(attributeFound, dp, "do_outdated", dataObject.doOutdated);
+            readAttribute(attributeFound, dp, "do_ts", dataObject.doTs);
+            readAttribute(attributeFound, dp, "do_ts_iv", dataObject.doTsIv);
+            readAttribute(attributeFound, dp, "do_ts_c", dataObject.doTsC);
+            readAttribute(attributeFound, dp, "do_ts_s", dataObject.doTsS);
+        }
     }
 
     // Get exchangeConfig from message type and address
     if (!attributeFound["do_type"]) {
         HnzPivotUtility::log_error("%s Missing do_type", beforeLog.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(DataType::OTHER, Counter::MISSING_ATTRIBUTE);
         return nullptr;
     }
+    DataType dataType = HnzPivotStatistics::dataTypeFromTypeId(dataObject.doType);
     if (!attributeFound["do_addr"]) {
         HnzPivotUtility::log_error("%s Missing do_addr", beforeLog.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(dataType, Counter::MISSING_ATTRIBUTE);
         return nullptr;
     }
-    const std::string& pivotId = m_filterConfig->findPivotId(dataObject.doType, dataObject.doAddress);
-    if (pivotId.empty()) {
-        HnzPivotUtility::log_error("%s No pivot ID configured for typeid %s and address %u", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), dataObject.doType.c_str(), dataObject.doAddress); //LCOV_EXCL_LINE
-        return nullptr;
-    }
-    auto exchangeData = m_filterConfig->getExchangeDefinitions();
-    if (exchangeData.count(pivotId) == 0) {
-        HnzPivotUtility::log_error("%s Unknown pivot ID: %s", beforeLog.c_str(), pivotId.c_str()); //LCOV_EXCL_LINE
-        return nullptr;
-    }
-    auto exchangeConfig = exchangeData[pivotId];
-    if (!checkLabelMatch(assetName, exchangeConfig)) {
-        HnzPivotUtility::log_warn("%s Input label (%s) does not match configured label (%s) for pivot ID: %s", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), assetName.c_str(), exchangeConfig->getLabel().c_str(), pivotId.c_str());    //LCOV_EXCL_LINE
+    const HNZPivotDataPoint* exchangeConfig = nullptr;
+    size_t pointIndex = HnzPivotPerfectHash::NOT_FOUND;
+    {
+        HNZ_PIVOT_TIME_SCOPE(latencyHistogram(LatencyStage::LOOKUP));
+        const std::string& pivotId = m_filterConfig->findPivotId(dataObject.doStation, dataObject.doType, dataObject.doAddress);
+        if (pivotId.empty()) {
+            HnzPivotUtility::log_error("%s No pivot ID configured for station %u, typeid %s and address %u", //LCOV_EXCL_LINE
+                                        beforeLog.c_str(), dataObject.doStation, dataObject.doType.c_str(), dataObject.doAddress); //LCOV_EXCL_LINE
+            m_statistics.increment(dataType, Counter::UNKNOWN_ADDRESS);
+            return nullptr;
+        }
+        pointIndex = m_filterConfig->findPointIndex(pivotId);
+        if (pointIndex != HnzPivotPerfectHash::NOT_FOUND) {
+            exchangeConfig = m_filterConfig->getDataPoint(pointIndex);
+        }
+        if (exchangeConfig == nullptr) {
+            HnzPivotUtility::log_error("%s Unknown pivot ID: %s", beforeLog.c_str(), pivotId.c_str()); //LCOV_EXCL_LINE
+            m_statistics.increment(dataType, Counter::UNKNOWN_ADDRESS);
+            return nullptr;
+        }
+        if (!checkLabelMatch(assetName, *exchangeConfig)) {
+            HnzPivotUtility::log_warn("%s Input label (%s) does not match configured label (%s) for pivot ID: %s", //LCOV_EXCL_LINE
+                                        beforeLog.c_str(), assetName.c_str(), exchangeConfig->getLabel().c_str(), pivotId.c_str());    //LCOV_EXCL_LINE
+        }
     }
 
     //NOTE: when doValue is missing for a TS or TM, we are converting a quality reading
     
+    HNZ_PIVOT_TIME_SCOPE(latencyHistogram(LatencyStage::PIVOT_BUILD));
     if (dataObject.doType == "TS") {
-        convertedDatapoint = convertTSToPivot(assetName, attributeFound, dataObject, exchangeConfig);
+        convertedDatapoint = convertTSToPivot(assetName, attributeFound, dataObject, *exchangeConfig, pointIndex, suppressed);
     }
     else if (dataObject.doType  == "TM") {
-        convertedDatapoint = convertTMToPivot(assetName, attributeFound, dataObject, exchangeConfig); 
+        convertedDatapoint = convertTMToPivot(assetName, attributeFound, dataObject, *exchangeConfig, pointIndex, suppressed);
     }
     else if (dataObject.doType == "TC") // Acknowledgment of a TC
     {
-        convertedDatapoint = convertTCACKToPivot(assetName, attributeFound, dataObject, exchangeConfig); 
+        convertedDatapoint = convertTCACKToPivot(assetName, attributeFound, dataObject, *exchangeConfig, pointIndex);
     }
     else if (dataObject.doType == "TVC") // Acknowledgment of a TVC
     {
-        convertedDatapoint = convertTVCACKToPivot(assetName, attributeFound, dataObject, exchangeConfig);
+        convertedDatapoint = convertTVCACKToPivot(assetName, attributeFound, dataObject, *exchangeConfig, pointIndex);
     }
     else {
         HnzPivotUtility::log_error("%s Unknown do_type: %s", beforeLog.c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(DataType::OTHER, Counter::TYPE_MISMATCH);
         return nullptr;
     }
 
+    if (convertedDatapoint) {
+        m_statistics.increment(dataType, Counter::CONVERTED);
+    }
     return convertedDatapoint;
 }
 
 Datapoint* HNZPivotFilter::convertTSToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                            const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+                                            const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                            size_t pointIndex, bool& suppressed)
 {
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertTSToPivot -"; //LCOV_EXCL_LINE
 
     // Message structure checks
     if (!checkPivotTypeMatch(dataObject.doType, exchangeConfig)) {
         HnzPivotUtility::log_error("%s Invalid pivot type (%s) for data object type (%s)", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), exchangeConfig->getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+                                    beforeLog.c_str(), exchangeConfig.getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(HnzPivotStatistics::dataTypeFromTypeId(dataObject.doType), Counter::TYPE_MISMATCH);
         return nullptr;
     }
+    bool missingAttribute = false;
     if (!attributeFound["do_valid"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_valid in TS", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     if (!attributeFound["do_cg"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_cg in TS", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     else if (!dataObject.doCg) {
         if (!attributeFound["do_ts"]) {
             HnzPivotUtility::log_warn("%s Missing attribute do_ts in TS CE", beforeLog.c_str()); //LCOV_EXCL_LINE
+            missingAttribute = true;
         }
         if (!attributeFound["do_ts_iv"]) {
             HnzPivotUtility::log_warn("%s Missing attribute do_ts_iv in TS CE", beforeLog.c_str()); //LCOV_EXCL_LINE
+            missingAttribute = true;
         }
         if (!attributeFound["do_ts_c"]) {
             HnzPivotUtility::log_warn("%s Missing attribute do_ts_c in TS CE", beforeLog.c_str()); //LCOV_EXCL_LINE
+            missingAttribute = true;
         }
         if (!attributeFound["do_ts_s"]) {
             HnzPivotUtility::log_warn("%s Missing attribute do_ts_s in TS CE", beforeLog.c_str()); //LCOV_EXCL_LINE
+            missingAttribute = true;
         }
     }
     if (!attributeFound["do_outdated"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_outdated in TS", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     else if (!dataObject.doOutdated && !attributeFound["do_value"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_value in TS", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
+    }
+    if (missingAttribute) {
+        m_statistics.increment(DataType::TS, Counter::MISSING_ATTRIBUTE);
+    }
+    HnzPivotChatterFilter::Transition transition;
+    transition.hasValue = attributeFound["do_value"];
+    if (transition.hasValue && (dataObject.doValue->getData().getType() == DatapointValue::T_INTEGER)) {
+        // Value range check
+        long value = dataObject.doValue->getData().toInt();
+        if (!checkValueRange(beforeLog, value, 0, 1, "TS")) {
+            m_statistics.increment(DataType::TS, Counter::OUT_OF_RANGE);
+        }
+        transition.value = static_cast<bool>(value);
+    }
+    transition.valid = dataObject.doValid;
+    transition.outdated = dataObject.doOutdated;
+    transition.hasTs = attributeFound["do_ts"];
+    transition.ts = dataObject.doTs;
+    transition.tsIv = dataObject.doTsIv;
+    transition.tsC = dataObject.doTsC;
+    transition.tsS = dataObject.doTsS;
+
+    if (!dataObject.doCg && transition.hasTs && !transition.tsIv) {
+        // Transitions older than the data age threshold are flagged as old data if configured
+        transition.late = m_dataAge.record(dataObject.doStation, dataObject.doTs, m_batchTimeMs) && m_dataAgeFlag;
+    }
+
+    bool oscillatory = false;
+    if (m_chatterFilter.isEnabled()) {
+        // Only TS CE with a value are transitions, TS CG of a chattering point are forwarded with the oscillatory
+        // flag and quality changes are forwarded immediately and forget the transitions of the point
+        if (!transition.hasValue) {
+            m_chatterFilter.discard(pointIndex);
+        }
+        else if (!dataObject.doCg) {
+            // Transitions are counted at their timestamp, or at their arrival time if they have no valid one
+            uint64_t transitionMs = (transition.hasTs && !transition.tsIv) ? transition.ts : m_batchTimeMs;
+            HnzPivotChatterFilter::Decision decision = m_chatterFilter.onTransition(pointIndex, transitionMs, m_batchTimeMs,
+                                                                                    transition);
+            if (decision == HnzPivotChatterFilter::Decision::SUPPRESS) {
+                m_statistics.increment(DataType::TS, Counter::SUPPRESSED);
+                suppressed = true;
+                return nullptr;
+            }
+            if (decision == HnzPivotChatterFilter::Decision::FORWARD_OSCILLATORY) {
+                HnzPivotUtility::log_warn("%s TS %s is chattering, its next transitions are suppressed", //LCOV_EXCL_LINE
+                                          beforeLog.c_str(), exchangeConfig.getPivotId().c_str()); //LCOV_EXCL_LINE
+            }
+        }
+        oscillatory = m_chatterFilter.isChattering(pointIndex);
     }
+
+    return createTSPivot(exchangeConfig, pointIndex, dataObject.doCg, transition, oscillatory);
+}
+
+Datapoint* HNZPivotFilter::createTSPivot(const HNZPivotDataPoint& exchangeConfig, size_t pointIndex, bool doCg,
+                                         const HnzPivotChatterFilter::Transition& transition, bool oscillatory)
+{
     // Pivot conversion
-    const std::string& pivotType = exchangeConfig->getPivotType();
-    HnzPivotObject pivot("GTIS", pivotType);
-    pivot.setIdentifier(exchangeConfig->getPivotId());
-    pivot.setCause(dataObject.doCg ? 20 : 3);
+    const std::string& pivotType = exchangeConfig.getPivotType();
+    HnzPivotObject pivot("GTIS", pivotType, m_compactOutput, jsonFragments(pointIndex, "GTIS", exchangeConfig));
+    pivot.setIdentifier(exchangeConfig.getPivotId());
+    pivot.setCause(doCg ? 20 : 3);
     
-    if (attributeFound["do_value"]) {
-        bool spsValue = false;
-        if (dataObject.doValue->getData().getType() == DatapointValue::T_INTEGER) {
-            // Value range check
-            long value = dataObject.doValue->getData().toInt();
-            checkValueRange(beforeLog, value, 0, 1, "TS");
-            spsValue = static_cast<bool>(value);
-        }
+    if (transition.hasValue) {
         // Fill TS Double field from TS Simple infos
         if (pivotType == "DpsTyp") {
-                pivot.setStValStr(spsValue?"on":"off");
+                pivot.setStValStr(transition.value?"on":"off");
         }
         else {
-            pivot.setStVal(spsValue);
+            pivot.setStVal(transition.value);
         }
     }
 
-    pivot.addQuality(dataObject.doValid, dataObject.doOutdated, dataObject.doTsC, dataObject.doTsS);
+    pivot.addQuality(transition.valid, transition.outdated, transition.tsC || transition.late, transition.tsS, oscillatory);
 
-    appendTimestamp(pivot, attributeFound["do_ts"], dataObject.doTs, dataObject.doTsIv, dataObject.doTsS);
+    appendTimestamp(pivot, transition.hasTs, transition.ts, transition.tsIv, transition.tsS);
     
     return pivot.toDatapoint();
 }
 
 
 Datapoint* HNZPivotFilter::convertTMToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                            const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+                                            const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                            size_t pointIndex, bool& suppressed)
 {
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertTMToPivot -"; //LCOV_EXCL_LINE
 
     // Message structure checks
     if (!checkPivotTypeMatch(dataObject.doType, exchangeConfig)) {
         HnzPivotUtility::log_error("%s Invalid pivot type (%s) for data object type (%s)", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), exchangeConfig->getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+                                    beforeLog.c_str(), exchangeConfig.getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(HnzPivotStatistics::dataTypeFromTypeId(dataObject.doType), Counter::TYPE_MISMATCH);
         return nullptr;
     }
+    bool missingAttribute = false;
     if (!attributeFound["do_valid"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_valid in TM", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     if (!attributeFound["do_an"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_an in TM", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     if (!attributeFound["do_outdated"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_outdated in TM", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
     else if (!dataObject.doOutdated && !attributeFound["do_value"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_value in TM", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
-    // Pivot conversion
-    HnzPivotObject pivot("GTIM", exchangeConfig->getPivotType());
-    pivot.setIdentifier(exchangeConfig->getPivotId());
-    pivot.setCause(1);
-    
-    if (attributeFound["do_value"] && (dataObject.doValue->getData().getType() == DatapointValue::T_INTEGER)) {
+    if (missingAttribute) {
+        m_statistics.increment(DataType::TM, Counter::MISSING_ATTRIBUTE);
+    }
+    bool hasValue = attributeFound["do_value"] && (dataObject.doValue->getData().getType() == DatapointValue::T_INTEGER);
+    long value = 0;
+    if (hasValue) {
         // Value range check
-        long value = dataObject.doValue->getData().toInt();
+        value = dataObject.doValue->getData().toInt();
         if (attributeFound["do_an"]) {
+            bool inRange = true;
             if (dataObject.doAn == "TMA") {
-                checkValueRange(beforeLog, value, -127, 127, dataObject.doAn);
+                inRange = checkValueRange(beforeLog, value, -127, 127, dataObject.doAn);
             }
             else if (dataObject.doAn == "TM8") {
-                checkValueRange(beforeLog, value, 0, 255, dataObject.doAn);
+                inRange = checkValueRange(beforeLog, value, 0, 255, dataObject.doAn);
             }
             else if (dataObject.doAn == "TM16") {
-                checkValueRange(beforeLog, value, -32768, 32767, dataObject.doAn);
+                inRange = checkValueRange(beforeLog, value, -32768, 32767, dataObject.doAn);
             }
             else {
                 HnzPivotUtility::log_warn("%s Unknown do_an: %s", beforeLog.c_str(), dataObject.doAn.c_str()); //LCOV_EXCL_LINE
             }
+            if (!inRange) {
+                m_statistics.increment(DataType::TM, Counter::OUT_OF_RANGE);
+            }
         }
+    }
+
+    if (m_tmAggregator.isEnabled()) {
+        // Only valid samples are aggregated, quality changes are forwarded immediately and start a new window
+        if (hasValue && !dataObject.doValid && !dataObject.doOutdated) {
+            if (!m_tmAggregator.addSample(pointIndex, value, m_batchTimeMs, value)) {
+                m_statistics.increment(DataType::TM, Counter::SUPPRESSED);
+                suppressed = true;
+                return nullptr;
+            }
+        }
+        else {
+            m_tmAggregator.discard(pointIndex);
+        }
+    }
+
+    return createTMPivot(exchangeConfig, pointIndex, hasValue, value, dataObject.doValid, dataObject.doOutdated);
+}
+
+Datapoint* HNZPivotFilter::createTMPivot(const HNZPivotDataPoint& exchangeConfig, size_t pointIndex, bool hasValue, long value,
+                                         unsigned int doValid, bool doOutdated)
+{
+    // Pivot conversion
+    HnzPivotObject pivot("GTIM", exchangeConfig.getPivotType(), m_compactOutput,
+                         jsonFragments(pointIndex, "GTIM", exchangeConfig));
+    pivot.setIdentifier(exchangeConfig.getPivotId());
+    pivot.setCause(1);
+
+    if (hasValue) {
         pivot.setMagI(static_cast<int>(value));
     }
 
-    pivot.addQuality(dataObject.doValid, dataObject.doOutdated, false, false);
+    pivot.addQuality(doValid, doOutdated, false, false);
 
     appendTimestamp(pivot, false, 0, false, false);
         
     return pivot.toDatapoint();
 }
 
+const HnzPivotJsonFragments* HNZPivotFilter::jsonFragments(size_t pointIndex, const char* pivotLN,
+                                                           const HNZPivotDataPoint& exchangeConfig)
+{
+    if (!m_jsonOutput) {
+        return nullptr;
+    }
+    if (pointIndex >= m_jsonFragments.size()) {
+        m_jsonFragments.resize(pointIndex + 1); //LCOV_EXCL_LINE
+    }
+    HnzPivotJsonFragments& fragments = m_jsonFragments[pointIndex];
+    if (fragments.empty()) {
+        fragments = HnzPivotJsonFragments::build(pivotLN, exchangeConfig.getPivotId(), exchangeConfig.getPivotType());
+    }
+    return &fragments;
+}
+
 Datapoint* HNZPivotFilter::convertTCACKToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                               const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+                                               const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                               size_t pointIndex)
 {
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertTCACKToPivot -"; //LCOV_EXCL_LINE
 
     // Message structure checks
-    const std::string& pivotType = exchangeConfig->getPivotType();
+    const std::string& pivotType = exchangeConfig.getPivotType();
     if (!checkPivotTypeMatch(dataObject.doType, exchangeConfig)) {
         HnzPivotUtility::log_error("%s Invalid pivot type (%s) for data object type (%s)", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), exchangeConfig->getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+                                    beforeLog.c_str(), exchangeConfig.getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(HnzPivotStatistics::dataTypeFromTypeId(dataObject.doType), Counter::TYPE_MISMATCH);
         return nullptr;
     }
+    bool missingAttribute = false;
     if (!attributeFound["do_valid"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_valid in TC ACK", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
     }
+    if (missingAttribute) {
+        m_statistics.increment(DataType::TC, Counter::MISSING_ATTRIBUTE);
+    }
+    m_commandTracker.ackReceived(pointIndex, HnzPivotCommandTracker::Clock::now());
     // Pivot conversion
     
-    HnzPivotObject pivot("GTIC", pivotType);
-    pivot.setIdentifier(exchangeConfig->getPivotId());
+    HnzPivotObject pivot("GTIC", pivotType, m_compactOutput, jsonFragments(pointIndex, "GTIC", exchangeConfig));
+    pivot.setIdentifier(exchangeConfig.getPivotId());
     pivot.setCause(7);
     
     pivot.addQuality(false, false, false, false);
@@ -364,22 +522,31 @@ Datapoint* HNZPivotFilter::convertTCACKToPivot(const std::string& assetName, std
 }
 
 Datapoint* HNZPivotFilter::convertTVCACKToPivot(const std::string& assetName, std::map<std::string, bool>& attributeFound,
-                                                const GenericDataObject& dataObject, std::shared_ptr<HNZPivotDataPoint> exchangeConfig)
+                                                const GenericDataObject& dataObject, const HNZPivotDataPoint& exchangeConfig,
+                                                size_t pointIndex)
 {
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertTVCACKToPivot -"; //LCOV_EXCL_LINE
 
     // Message structure checks
     if (!checkPivotTypeMatch(dataObject.doType, exchangeConfig)) {
         HnzPivotUtility::log_error("%s Invalid pivot type (%s) for data object type (%s)", //LCOV_EXCL_LINE
-                                    beforeLog.c_str(), exchangeConfig->getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+                                    beforeLog.c_str(), exchangeConfig.getPivotType().c_str(), dataObject.doType.c_str()); //LCOV_EXCL_LINE
+        m_statistics.increment(HnzPivotStatistics::dataTypeFromTypeId(dataObject.doType), Counter::TYPE_MISMATCH);
         return nullptr;
     }
+    bool missingAttribute = false;
     if (!attributeFound["do_valid"]) {
         HnzPivotUtility::log_warn("%s Missing attribute do_valid in TVC ACK", beforeLog.c_str()); //LCOV_EXCL_LINE
+        missingAttribute = true;
+    }
+    if (missingAttribute) {
+        m_statistics.increment(DataType::TVC, Counter::MISSING_ATTRIBUTE);
     }
+    m_commandTracker.ackReceived(pointIndex, HnzPivotCommandTracker::Clock::now());
     // Pivot conversion
-    HnzPivotObject pivot("GTIC", exchangeConfig->getPivotType());
-    pivot.setIdentifier(exchangeConfig->getPivotId());
+    HnzPivotObject pivot("GTIC", exchangeConfig.getPivotType(), m_compactOutput,
+                         jsonFragments(pointIndex, "GTIC", exchangeConfig));
+    pivot.setIdentifier(exchangeConfig.getPivotId());
     pivot.setCause(7);
     
     pivot.addQuality(false, false, false, false);
@@ -390,55 +557,77 @@ Datapoint* HNZPivotFilter::convertTVCACKToPivot(const std::string& assetName, st
     return pivot.toDatapoint();
 }
 
-std::vector<Datapoint*> HNZPivotFilter::convertDatapointToHNZ(const std::string& assetName, Datapoint* sourceDp) const
+bool HNZPivotFilter::convertDatapointToHNZ(const std::string& assetName, Datapoint* sourceDp,
+                                           std::vector<Datapoint*>& convertedDatapoints, bool& suppressed)
 {
-    std::vector<Datapoint*> convertedDatapoints;
+    suppressed = false;
+    HNZ_PIVOT_TIME_SCOPE(latencyHistogram(LatencyStage::HNZ_DECODE));
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertDatapointToHNZ -"; //LCOV_EXCL_LINE
 
     try {
         HnzPivotObject pivotObject(sourceDp);
-        auto exchangeData = m_filterConfig->getExchangeDefinitions();
         const std::string& pivotId = pivotObject.getIdentifier();
-        if (exchangeData.count(pivotId) == 0) {
-            std::vector<std::string> pivotIds;
-            for(auto const& kvp: exchangeData) {
-                pivotIds.push_back(kvp.first);
+        size_t pointIndex = 0;
+        const HNZPivotDataPoint* exchangeConfig = m_filterConfig->findCommand(pivotId, pointIndex);
+        if (exchangeConfig == nullptr) {
+            // The identifier comes from the message, only its beginning is logged
+            if (m_filterConfig->getExchangeDefinitions().count(pivotId) > 0) {
+                HnzPivotUtility::log_error("%s Pivot ID %.64s is not a TC or TVC", beforeLog.c_str(), pivotId.c_str()); //LCOV_EXCL_LINE
+                m_statistics.increment(DataType::PIVOT, Counter::TYPE_MISMATCH);
+            }
+            else {
+                HnzPivotUtility::log_error("%s Unknown pivot ID: %.64s (%lu TC/TVC configured)", beforeLog.c_str(), pivotId.c_str(), //LCOV_EXCL_LINE
+                                            static_cast<unsigned long>(m_filterConfig->getCommandCount())); //LCOV_EXCL_LINE
+                m_statistics.increment(DataType::PIVOT, Counter::UNKNOWN_ADDRESS);
             }
-            HnzPivotUtility::log_error("%s Unknown pivot ID: %s (available: %s)", //LCOV_EXCL_LINE
-                                        beforeLog.c_str(), pivotId.c_str(), HnzPivotUtility::join(pivotIds).c_str()); //LCOV_EXCL_LINE
-            return convertedDatapoints;
+            return false;
+        }
+        if (m_commandDeduplicator.isDuplicate(pointIndex, pivotObject.getCommandValue(), m_batchTimeMs)) {
+            HnzPivotUtility::log_warn("%s Duplicate command for pivot ID %s dropped", beforeLog.c_str(), pivotId.c_str()); //LCOV_EXCL_LINE
+            m_statistics.increment(DataType::PIVOT, Counter::SUPPRESSED);
+            suppressed = true;
+            return false;
         }
-        auto exchangeConfig = exchangeData[pivotId];
-        convertedDatapoints = pivotObject.toHnzCommandObject(exchangeConfig);
+        pivotObject.toHnzCommandObject(*exchangeConfig, convertedDatapoints);
+        m_statistics.increment(DataType::PIVOT, Counter::CONVERTED);
+        m_commandTracker.commandSent(pointIndex, HnzPivotCommandTracker::Clock::now());
+        return true;
     }
     catch (HnzPivotObjectException& e)
     {
         HnzPivotUtility::log_error("%s Failed to convert pivot object: %s", beforeLog.c_str(), e.getContext().c_str()); //LCOV_EXCL_LINE
+        // Pivot object not matching the structure expected for a command
+        m_statistics.increment(DataType::PIVOT, Counter::TYPE_MISMATCH);
     }
 
-    return convertedDatapoints;
+    return false;
 }
 
 bool HNZPivotFilter::convertDatapoint(const std::string& assetName, Datapoint* dp, std::vector<Datapoint*>& convertedDatapoints) {
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::processDatapoint -"; //LCOV_EXCL_LINE
     if (dp->getName() == "data_object") {
-        Datapoint* convertedDp = convertDatapointToPivot(assetName, dp);
+        bool suppressed = false;
+        Datapoint* convertedDp = convertDatapointToPivot(assetName, dp, suppressed);
 
         if (convertedDp) {
             convertedDatapoints.push_back(convertedDp);
         }
+        else if (suppressed) {
+            HnzPivotUtility::log_debug("%s data_object suppressed", beforeLog.c_str()); //LCOV_EXCL_LINE
+        }
         else {
             HnzPivotUtility::log_error("%s Failed to convert data_object", beforeLog.c_str()); //LCOV_EXCL_LINE
             return false;
         }
     }
     else if (dp->getName() == "PIVOT") {
-        std::vector<Datapoint*> convertedDps = convertDatapointToHNZ(assetName, dp);
+        bool suppressed = false;
+        bool converted = convertDatapointToHNZ(assetName, dp, convertedDatapoints, suppressed);
 
-        if (!convertedDps.empty()) {
-            convertedDatapoints.insert(convertedDatapoints.end(), convertedDps.begin(), convertedDps.end());
+        if (suppressed) {
+            HnzPivotUtility::log_debug("%s PIVOT object suppressed", beforeLog.c_str()); //LCOV_EXCL_LINE
         }
-        else {
+        else if (!converted) {
             HnzPivotUtility::log_error("%s Failed to convert PIVOT object", beforeLog.c_str()); //LCOV_EXCL_LINE
             return false;
         }
@@ -446,7 +635,9 @@ bool HNZPivotFilter::convertDatapoint(const std::string& assetName, Datapoint* d
     else {
         HnzPivotUtility::log_debug("%s Unhandled datapoint type '%s', forwarding reading unchanged", //LCOV_EXCL_LINE
                                         beforeLog.c_str(), dp->getName().c_str()); //LCOV_EXCL_LINE
-        convertedDatapoints.push_back(new Datapoint(dp->getName(), dp->getData()));
+        // Forwarded as is, without copying the datapoint
+        convertedDatapoints.push_back(dp);
+        m_statistics.increment(DataType::OTHER, Counter::PASSTHROUGH);
         return false;
     }
     return true;
@@ -454,93 +645,700 @@ bool HNZPivotFilter::convertDatapoint(const std::string& assetName, Datapoint* d
 
 void HNZPivotFilter::ingest(READINGSET* readingSet)
 {
-    std::lock_guard<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::ingest -"; //LCOV_EXCL_LINE
-    if (!isEnabled()) {
-        return;
-    }
     if (!readingSet) {
         HnzPivotUtility::log_error("%s No reading set provided", beforeLog.c_str()); //LCOV_EXCL_LINE
         return;
     }
-    /* apply transformation */
-    std::vector<Reading*>* readings = readingSet->getAllReadingsPtr();
+    // The mutex is not held while forwarding the commands or queuing: both can wait for the conversion thread
+    std::shared_ptr<HnzPivotIngestQueue> ingestQueue;
+    {
+        std::lock_guard<std::mutex> guard(m_ingestQueueMutex); //LCOV_EXCL_LINE
+        ingestQueue = m_ingestQueue;
+    }
+    if (ingestQueue) {
+        if (forwardCommands(readingSet)) {
+            return;
+        }
+        if (ingestQueue->push(readingSet)) {
+            return;
+        }
+        // The queue was closed by a reconfigure, wait for the thread to convert the reading sets still queued
+        std::lock_guard<std::mutex> guard(m_ingestQueueMutex); //LCOV_EXCL_LINE
+    }
+    convertReadingSet(readingSet, nullptr);
+}
 
-    HnzPivotUtility::log_info("%s %d readings", beforeLog.c_str(), readings->size()); //LCOV_EXCL_LINE
+bool HNZPivotFilter::convertReading(Reading* reading)
+{
+    std::string assetName = reading->getAssetName();
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::convertReading -"; //LCOV_EXCL_LINE
 
-    auto readIt = readings->begin();
+    std::vector<Datapoint*>& datapoints = reading->getReadingData();
 
-    while(readIt != readings->end())
-    {
-        Reading* reading = *readIt;
+    HnzPivotUtility::log_debug("%s original Reading: %s", beforeLog.c_str(), reading->toJSON().c_str()); //LCOV_EXCL_LINE
+
+    bool success = true;
+    for (Datapoint* dp : datapoints) {
+        success &= convertDatapoint(assetName, dp, m_convertedDatapoints);
+    }
 
-        std::string assetName = reading->getAssetName();
-        beforeLog = HNZPivotConfig::getPluginName() + " - " + assetName + " - HNZPivotFilter::ingest -";
+    if (success) {
+        if (assetName == "PivotCommand") {
+            reading->setAssetName("HNZCommand");
+        }
+    }
 
-        const std::vector<Datapoint*>& datapoints = reading->getReadingData();
+    // Rewrite the datapoints of the reading in place: the datapoints forwarded unchanged are kept,
+    // the converted ones are deleted and the vector of the reading keeps its storage
+    for (Datapoint* dp : datapoints) {
+        if (std::find(m_convertedDatapoints.begin(), m_convertedDatapoints.end(), dp) == m_convertedDatapoints.end()) {
+            delete dp;
+        }
+    }
+    datapoints.assign(m_convertedDatapoints.begin(), m_convertedDatapoints.end());
+    // The datapoints now belong to the reading, only the capacity of the buffer is kept
+    m_convertedDatapoints.clear();
 
-        std::vector<Datapoint*> convertedDatapoints;
+    HnzPivotUtility::log_debug("%s converted Reading: %s", beforeLog.c_str(), reading->toJSON().c_str()); //LCOV_EXCL_LINE
 
-        HnzPivotUtility::log_debug("%s original Reading: %s", beforeLog.c_str(), reading->toJSON().c_str()); //LCOV_EXCL_LINE
+    return !datapoints.empty();
+}
 
-        bool success = true;
-        for (Datapoint* dp : datapoints) {
-            success &= convertDatapoint(assetName, dp, convertedDatapoints);
+void HNZPivotFilter::takeCommandReadings(std::vector<Reading*>& readings)
+{
+    m_commandReadings.reserve(readings.size());
+    auto readIt = readings.begin();
+    while (readIt != readings.end()) {
+        Reading* reading = *readIt;
+        if (reading->getAssetName() != "PivotCommand") {
+            readIt++;
+            continue;
+        }
+        if (convertReading(reading)) {
+            m_commandReadings.push_back(reading);
+        }
+        else {
+            delete reading;
         }
+        readIt = readings.erase(readIt);
+    }
+}
 
-        if (success) {
-            if (assetName == "PivotCommand") {
-                reading->setAssetName("HNZCommand");
-            }
+bool HNZPivotFilter::forwardCommands(READINGSET* readingSet)
+{
+    std::lock_guard<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
+    std::vector<Reading*>* readings = readingSet->getAllReadingsPtr();
+    bool hasCommand = std::any_of(readings->begin(), readings->end(), [](const Reading* reading) {
+        return reading->getAssetName() == "PivotCommand";
+    });
+    if (!isEnabled() || !hasCommand) {
+        return false;
+    }
+    HNZ_PIVOT_TIMER_START(commandTimer, latencyHistogram(LatencyStage::COMMAND));
+    m_batchTimeMs = HnzPivotTimestamp::getCurrentTimestampMs();
+    takeCommandReadings(*readings);
+    if (readings->empty()) {
+        // Only commands, forwarded in the reading set received
+        readings->assign(m_commandReadings.begin(), m_commandReadings.end());
+        m_commandReadings.clear();
+        if (readings->empty()) {
+            delete readingSet;
         }
+        else {
+            forwardReadingSet(readingSet);
+        }
+        return true;
+    }
+    if (!m_commandReadings.empty()) {
+        forwardReadingSet(new ReadingSet(&m_commandReadings));
+        m_commandReadings.clear();
+    }
+    return false;
+}
 
-        reading->removeAllDatapoints();
+void HNZPivotFilter::forwardReadingSet(READINGSET* readingSet)
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::forwardReadingSet -"; //LCOV_EXCL_LINE
+    if (m_func) {
+        HnzPivotUtility::log_debug("%s Send %lu converted readings", beforeLog.c_str(), readingSet->getCount()); //LCOV_EXCL_LINE
 
-        for (Datapoint* convertedDatapoint : convertedDatapoints) {
-            reading->addDatapoint(convertedDatapoint);
-        }
+        HNZ_PIVOT_TIME_SCOPE(latencyHistogram(LatencyStage::FORWARD));
+        m_func(m_data, readingSet);
+    }
+    else {
+        HnzPivotUtility::log_error("%s No function to call, discard %lu converted readings", beforeLog.c_str(), readingSet->getCount()); //LCOV_EXCL_LINE
+    }
+}
 
-        HnzPivotUtility::log_debug("%s converted Reading: %s", beforeLog.c_str(), reading->toJSON().c_str()); //LCOV_EXCL_LINE
+void HNZPivotFilter::convertReadingSet(READINGSET* readingSet, const HnzPivotIngestQueue* ingestQueue)
+{
+    std::unique_lock<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::convertReadingSet -"; //LCOV_EXCL_LINE
+    if (!isEnabled()) {
+        return;
+    }
+    HNZ_PIVOT_TIMER_START(commandTimer, latencyHistogram(LatencyStage::COMMAND));
+    m_batchTimeMs = HnzPivotTimestamp::getCurrentTimestampMs();
+    /* apply transformation */
+    std::vector<Reading*>* readings = readingSet->getAllReadingsPtr();
 
-        if (reading->getReadingData().empty()) {
-            readIt = readings->erase(readIt);
+    HnzPivotUtility::log_info("%s %d readings", beforeLog.c_str(), readings->size()); //LCOV_EXCL_LINE
+
+    // Commands are converted and forwarded first, in a reading set of their own if the reading set also holds
+    // monitoring data, so that a command sent during a GI does not wait for the conversion of the whole GI
+    takeCommandReadings(*readings);
+    if (m_commandReadings.empty()) {
+        HNZ_PIVOT_TIMER_CANCEL(commandTimer);
+    }
+    else if (!readings->empty() && m_func) {
+        forwardReadingSet(new ReadingSet(&m_commandReadings));
+        HNZ_PIVOT_TIMER_STOP(commandTimer);
+        m_commandReadings.clear();
+    }
+
+    // Aggregates of the quiet TM points and last transitions of the TS points no longer chattering, older than the
+    // data of the reading set
+    std::vector<Reading*> aggregateReadings;
+    if (m_tmAggregator.isEnabled()) {
+        flushTmAggregates(aggregateReadings);
+    }
+    if (m_chatterFilter.isEnabled()) {
+        releaseChatteringPoints(aggregateReadings);
+    }
+
+    std::vector<Reading*> stationReadings;
+    if (m_outdatedStorm.isEnabled()) {
+        compressOutdatedStorms(*readings, stationReadings);
+    }
+
+    auto readIt = readings->begin();
+    while (readIt != readings->end()) {
+        if (!stationReadings.empty() &&
+            (std::find(stationReadings.begin(), stationReadings.end(), *readIt) != stationReadings.end())) {
+            // Station quality event, already converted
+            readIt++;
         }
-        else {
+        else if (convertReading(*readIt)) {
             readIt++;
         }
+        else {
+            // No datapoint left (e.g. all suppressed), the reading is removed from the set
+            delete *readIt;
+            readIt = readings->erase(readIt);
+        }
     }
 
+    readings->insert(readings->begin(), aggregateReadings.begin(), aggregateReadings.end());
+    // Commands not forwarded on their own (only commands received, or no next filter) are put back in front
+    readings->insert(readings->begin(), m_commandReadings.begin(), m_commandReadings.end());
+    m_commandReadings.clear();
+
+    appendStatisticsReading(*readings, ingestQueue);
+
+    // The conversion thread is the only one forwarding converted reading sets, it does not need the mutex
+    // anymore: the commands forwarded by ingest meanwhile do not wait for the next filter
+    if (ingestQueue != nullptr) {
+        guard.unlock();
+    }
     if (!readings->empty())
     {
-        if (m_func) {
-            HnzPivotUtility::log_debug("%s Send %lu converted readings", beforeLog.c_str(), readings->size()); //LCOV_EXCL_LINE
+        forwardReadingSet(readingSet);
+    }
+    else {
+        // Nothing left to forward (all readings suppressed or failed)
+        delete readingSet;
+    }
+    // A command timer still running (commands forwarded with the reading set) is recorded at the end of the scope
+}
+
+void HNZPivotFilter::flushTmAggregates(std::vector<Reading*>& aggregateReadings)
+{
+    m_tmAggregator.flush(m_batchTimeMs, m_tmAggregates);
+    for (const HnzPivotTmAggregator::Aggregate& aggregate : m_tmAggregates) {
+        const HNZPivotDataPoint* exchangeConfig = m_filterConfig->getDataPoint(aggregate.pointIndex);
+        if (exchangeConfig == nullptr) {
+            continue; //LCOV_EXCL_LINE
+        }
+        Datapoint* pivot = createTMPivot(*exchangeConfig, aggregate.pointIndex, true, aggregate.value, 0, false);
+        aggregateReadings.push_back(new Reading(exchangeConfig->getLabel(), pivot));
+        m_statistics.increment(DataType::TM, Counter::CONVERTED);
+    }
+    m_tmAggregates.clear();
+}
+
+void HNZPivotFilter::releaseChatteringPoints(std::vector<Reading*>& releasedReadings)
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::releaseChatteringPoints -"; //LCOV_EXCL_LINE
+    m_chatterFilter.release(m_batchTimeMs, m_chatterReleased);
+    for (const HnzPivotChatterFilter::Released& released : m_chatterReleased) {
+        const HNZPivotDataPoint* exchangeConfig = m_filterConfig->getDataPoint(released.pointIndex);
+        if (exchangeConfig == nullptr) {
+            continue; //LCOV_EXCL_LINE
+        }
+        HnzPivotUtility::log_info("%s TS %s no longer chattering, last transition forwarded", //LCOV_EXCL_LINE
+                                  beforeLog.c_str(), exchangeConfig->getPivotId().c_str()); //LCOV_EXCL_LINE
+        Datapoint* pivot = createTSPivot(*exchangeConfig, released.pointIndex, false, released.transition, false);
+        releasedReadings.push_back(new Reading(exchangeConfig->getLabel(), pivot));
+        m_statistics.increment(DataType::TS, Counter::CONVERTED);
+    }
+    m_chatterReleased.clear();
+}
 
-            m_func(m_data, readingSet);
+void HNZPivotFilter::compressOutdatedStorms(std::vector<Reading*>& readings, std::vector<Reading*>& stationReadings)
+{
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::compressOutdatedStorms -"; //LCOV_EXCL_LINE
+    for (Reading* reading : readings) {
+        for (Datapoint* dp : reading->getReadingData()) {
+            DatapointValue& dpv = dp->getData();
+            if ((dp->getName() != "data_object") || (dpv.getType() != DatapointValue::T_DP_DICT)) {
+                continue;
+            }
+            // Only the attributes identifying an outdated data_object are decoded here
+            std::string doType;
+            long doStation = -1;
+            long doAddress = -1;
+            long doValid = 0;
+            long doOutdated = 0;
+            bool hasValue = false;
+            for (Datapoint* attribute : *dpv.getDpVec()) {
+                const std::string& name = attribute->getName();
+                const DatapointValue& value = attribute->getData();
+                if (name == "do_value") {
+                    hasValue = true;
+                }
+                else if ((name == "do_type") && (value.getType() == DatapointValue::T_STRING)) {
+                    doType = value.toStringValue();
+                }
+                else if (value.getType() != DatapointValue::T_INTEGER) {
+                    continue;
+                }
+                else if (name == "do_station") {
+                    doStation = value.toInt();
+                }
+                else if (name == "do_addr") {
+                    doAddress = value.toInt();
+                }
+                else if (name == "do_valid") {
+                    doValid = value.toInt();
+                }
+                else if (name == "do_outdated") {
+                    doOutdated = value.toInt();
+                }
+            }
+            if (hasValue || !doOutdated || (doStation < 0) || (doAddress < 0) || ((doType != "TS") && (doType != "TM"))) {
+                continue;
+            }
+            const std::string& pivotId = m_filterConfig->findPivotId(static_cast<unsigned int>(doStation), doType,
+                                                                     static_cast<unsigned int>(doAddress));
+            if (pivotId.empty()) {
+                continue;
+            }
+            size_t pointIndex = m_filterConfig->findPointIndex(pivotId);
+            if (pointIndex == HnzPivotPerfectHash::NOT_FOUND) {
+                continue; //LCOV_EXCL_LINE
+            }
+            m_outdatedStorm.addPoint(static_cast<unsigned int>(doStation), doValid == 1,
+                                     {reading, dp, m_filterConfig->getDataPoint(pointIndex), pointIndex});
+        }
+    }
+
+    m_outdatedStorm.takeStorms(m_storms);
+    if (m_storms.empty()) {
+        return;
+    }
+    for (const HnzPivotOutdatedStorm::Storm& storm : m_storms) {
+        HnzPivotUtility::log_warn("%s %lu outdated data objects of station %u replaced by a station quality event", //LCOV_EXCL_LINE
+                                  beforeLog.c_str(), static_cast<unsigned long>(storm.points.size()), storm.station); //LCOV_EXCL_LINE
+        for (const HnzPivotOutdatedStorm::Point& point : storm.points) {
+            std::vector<Datapoint*>& datapoints = point.reading->getReadingData();
+            datapoints.erase(std::find(datapoints.begin(), datapoints.end(), point.dataObject));
+            delete point.dataObject;
+            const std::string& typeId = point.exchangeConfig->getTypeId();
+            // Quality change, the samples aggregated and the transition suppressed before it are not forwarded
+            if (typeId == "TM") {
+                m_tmAggregator.discard(point.pointIndex);
+            }
+            else {
+                m_chatterFilter.discard(point.pointIndex);
+            }
+            m_statistics.increment(HnzPivotStatistics::dataTypeFromTypeId(typeId), Counter::CONVERTED);
+        }
+        stationReadings.push_back(new Reading(STATION_QUALITY_ASSET_NAME, HnzPivotOutdatedStorm::toDatapoint(storm, m_batchTimeMs)));
+    }
+
+    // Each station quality event takes the place of the first data_object of its storm, the readings which only
+    // held data_objects of storms are removed
+    std::vector<Reading*> compressed;
+    compressed.reserve(readings.size() + stationReadings.size());
+    for (Reading* reading : readings) {
+        for (size_t i = 0; i < m_storms.size(); i++) {
+            if (m_storms[i].points.front().reading == reading) {
+                compressed.push_back(stationReadings[i]);
+            }
+        }
+        if (reading->getReadingData().empty()) {
+            delete reading;
         }
         else {
-            HnzPivotUtility::log_error("%s No function to call, discard %lu converted readings", beforeLog.c_str(), readings->size()); //LCOV_EXCL_LINE
+            compressed.push_back(reading);
         }
     }
+    readings.swap(compressed);
+    m_storms.clear();
+}
+
+HnzPivotHistogram::Snapshot HNZPivotFilter::getLatencySnapshot(LatencyStage stage) const {
+    return latencyHistogram(stage).snapshot();
+}
+
+void HNZPivotFilter::resetLatencyStats() {
+    for (auto& histogram : m_latencyStats) {
+        histogram.reset();
+    }
+}
+
+std::string HNZPivotFilter::latencyStageStr(LatencyStage stage) {
+    switch (stage) {
+        case LatencyStage::DECODE:
+            return "decode";
+        case LatencyStage::LOOKUP:
+            return "lookup";
+        case LatencyStage::PIVOT_BUILD:
+            return "pivot_build";
+        case LatencyStage::HNZ_DECODE:
+            return "hnz_decode";
+        case LatencyStage::FORWARD:
+            return "forward";
+        case LatencyStage::COMMAND:
+            return "command";
+    }
+    return "";
+}
+
+void HNZPivotFilter::appendStatisticsReading(std::vector<Reading*>& readings, const HnzPivotIngestQueue* ingestQueue) {
+    if (m_statisticsPeriodMs <= 0) {
+        return;
+    }
+    uint64_t now = HnzPivotTimestamp::getCurrentTimestampMs();
+    if ((m_lastStatisticsTs != 0) && (now - m_lastStatisticsTs < static_cast<uint64_t>(m_statisticsPeriodMs))) {
+        return;
+    }
+    m_lastStatisticsTs = now;
+    Datapoint* statistics = m_statistics.toDatapoint("statistics");
+    if (ingestQueue) {
+        statistics->getData().getDpVec()->push_back(ingestQueue->toDatapoint("ingest_queue"));
+    }
+    m_commandTracker.expire(HnzPivotCommandTracker::Clock::now());
+    statistics->getData().getDpVec()->push_back(m_commandTracker.toDatapoint("commands"));
+    statistics->getData().getDpVec()->push_back(m_dataAge.toDatapoint("data_age"));
+    DatapointValue chatteringPoints(static_cast<long>(m_chatterFilter.getChatteringCount()));
+    statistics->getData().getDpVec()->push_back(new Datapoint("chattering_points", chatteringPoints));
+    readings.push_back(new Reading(STATISTICS_ASSET_NAME, statistics));
+}
+
+std::shared_ptr<const HnzPivotIngestQueue> HNZPivotFilter::getIngestQueue() const {
+    std::lock_guard<std::mutex> guard(m_ingestQueueMutex); //LCOV_EXCL_LINE
+    return m_ingestQueue;
+}
+
+void HNZPivotFilter::updateIngestThread() {
+    std::lock_guard<std::mutex> guard(m_ingestQueueMutex); //LCOV_EXCL_LINE
+    bool running = m_ingestQueue != nullptr;
+    if (running && m_asyncIngest && (m_ingestQueue->getDepth() == m_asyncQueueDepth)
+        && (m_ingestQueue->getPolicy() == m_asyncPolicy)) {
+        return;
+    }
+    if (running) {
+        stopIngestThread();
+    }
+    if (m_asyncIngest) {
+        startIngestThread();
+    }
+}
+
+void HNZPivotFilter::startIngestThread() {
+    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::startIngestThread -"; //LCOV_EXCL_LINE
+    HnzPivotUtility::log_info("%s Asynchronous ingest with a queue of %lu reading sets (%s when full)", beforeLog.c_str(), //LCOV_EXCL_LINE
+                              static_cast<unsigned long>(m_asyncQueueDepth), HnzPivotIngestQueue::PolicyStr(m_asyncPolicy).c_str()); //LCOV_EXCL_LINE
+    m_ingestQueue = std::make_shared<HnzPivotIngestQueue>(m_asyncQueueDepth, m_asyncPolicy);
+    std::shared_ptr<HnzPivotIngestQueue> ingestQueue = m_ingestQueue;
+    m_ingestThread = std::thread([this, ingestQueue]() {
+        ReadingSet* readingSet = nullptr;
+        while ((readingSet = ingestQueue->pop()) != nullptr) {
+            convertReadingSet(readingSet, ingestQueue.get());
+        }
+    });
+}
+
+void HNZPivotFilter::stopIngestThread() {
+    if (!m_ingestQueue) {
+        return;
+    }
+    // The thread converts the reading sets still queued before exiting
+    m_ingestQueue->close();
+    if (m_ingestThread.joinable()) {
+        m_ingestThread.join();
+    }
+    m_ingestQueue = nullptr;
 }
 
 void HNZPivotFilter::reconfigure(const std::string& newConfig) {
-    std::lock_guard<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
-    std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::reconfigure -"; //LCOV_EXCL_LINE
-    HnzPivotUtility::log_debug("%s reconfigure called", beforeLog.c_str()); //LCOV_EXCL_LINE
-    setConfig(newConfig);
+    {
+        std::lock_guard<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
+        std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::reconfigure -"; //LCOV_EXCL_LINE
+        HnzPivotUtility::log_debug("%s reconfigure called", beforeLog.c_str()); //LCOV_EXCL_LINE
+        setConfig(newConfig);
 
-    ConfigCategory config("hnzpivot", newConfig);
-    readConfig(config);
+        ConfigCategory config("hnzpivot", newConfig);
+        readConfig(config);
+    }
+    // The conversion thread takes m_configMutex, it can only be stopped once the mutex is released
+    updateIngestThread();
 }
 
 void HNZPivotFilter::readConfig(const ConfigCategory& config) {
     std::lock_guard<std::recursive_mutex> guard(m_configMutex); //LCOV_EXCL_LINE
     std::string beforeLog = HNZPivotConfig::getPluginName() + " - HNZPivotFilter::readConfig -"; //LCOV_EXCL_LINE
+    if (config.itemExists("config_cache")) {
+        m_configCacheEnabled = config.getValue("config_cache") == "true";
+    }
     if (config.itemExists("exchanged_data")) {
         const std::string exchangedData = config.getValue("exchanged_data");
-        m_filterConfig->importExchangeConfig(exchangedData);
+        HnzPivotConfigCache::ConfigKey exchangedDataKey = HnzPivotConfigCache::keyConfig(exchangedData);
+        if (m_exchangedDataImported && (exchangedDataKey == m_exchangedDataKey)) {
+            HnzPivotUtility::log_debug("%s exchanged_data unchanged", beforeLog.c_str()); //LCOV_EXCL_LINE
+        }
+        else {
+            // Configurations are shared by the filter instances of the process and immutable once built,
+            // a reconfigure builds a new configuration unless another instance already uses this JSON
+            std::shared_ptr<const HNZPivotConfig> currentConfig = m_filterConfig;
+            m_filterConfig = HnzPivotConfigRegistry::get(exchangedData, exchangedDataKey.hash,
+                                                         [&](HNZPivotConfig& newConfig) {
+                if (m_configCacheEnabled) {
+                    m_configCache.importExchangeConfig(newConfig, exchangedData, exchangedDataKey);
+                    newConfig.shareDataPoints(*currentConfig);
+                }
+                else {
+                    // Only the difference with the current configuration is applied
+                    newConfig.importExchangeConfig(exchangedData, *currentConfig);
+                }
+            });
+            m_exchangedDataKey = exchangedDataKey;
+            m_exchangedDataImported = true;
+            // Point indexes are only valid for the configuration they come from: the state of the points left
+            // unchanged moves to their new index, the one of the points added, removed or changed is forgotten
+            std::vector<size_t> pointIndexes;
+            HNZPivotConfig::ExchangeChanges changes = m_filterConfig->mapPointIndexes(*currentConfig, pointIndexes);
+            HnzPivotUtility::log_info("%s exchanged_data updated: %lu added, %lu removed, %lu changed, %lu unchanged", //LCOV_EXCL_LINE
+                                      beforeLog.c_str(), static_cast<unsigned long>(changes.added), //LCOV_EXCL_LINE
+                                      static_cast<unsigned long>(changes.removed), static_cast<unsigned long>(changes.changed), //LCOV_EXCL_LINE
+                                      static_cast<unsigned long>(changes.unchanged)); //LCOV_EXCL_LINE
+            size_t pointCount = m_filterConfig->getPointCount();
+            m_chatterFilter.remap(pointIndexes, pointCount);
+            m_tmAggregator.remap(pointIndexes, pointCount);
+            m_commandDeduplicator.remap(pointIndexes, pointCount);
+            m_commandTracker.remap(pointIndexes, pointCount);
+            HnzPivotUtility::remapPoints(m_jsonFragments, pointIndexes, pointCount);
+            if ((changes.added > 0) || (changes.removed > 0) || (changes.changed > 0)) {
+                // Both only depend on the types and stations of the points
+                m_outdatedStorm.setConfig(*m_filterConfig);
+                m_dataAge.setConfig(*m_filterConfig);
+            }
+        }
     }
     else {
         HnzPivotUtility::log_error("%s Missing exchanged_data configuation", beforeLog.c_str()); //LCOV_EXCL_LINE
     }
+    if (config.itemExists("statistics_period")) {
+        const std::string statisticsPeriod = config.getValue("statistics_period");
+        try {
+            m_statisticsPeriodMs = std::stol(statisticsPeriod) * 1000;
+        }
+        catch (const std::exception&) {
+            HnzPivotUtility::log_error("%s Invalid statistics_period: %s", beforeLog.c_str(), statisticsPeriod.c_str()); //LCOV_EXCL_LINE
+            m_statisticsPeriodMs = 0;
+        }
+        // Send a first statistics reading with the next readings received
+        m_lastStatisticsTs = 0;
+    }
+    if (config.itemExists("command_ack_timeout")) {
+        const std::string ackTimeout = config.getValue("command_ack_timeout");
+        long timeout = 0;
+        try {
+            timeout = std::stol(ackTimeout);
+        }
+        catch (const std::exception&) {
+            timeout = 0;
+        }
+        if (timeout > 0) {
+            m_commandTracker.setTimeout(std::chrono::seconds(timeout));
+        }
+        else {
+            HnzPivotUtility::log_error("%s Invalid command_ack_timeout: %s", beforeLog.c_str(), ackTimeout.c_str()); //LCOV_EXCL_LINE
+        }
+    }
+    if (config.itemExists("data_age_flag")) {
+        m_dataAgeFlag = config.getValue("data_age_flag") == "true";
+    }
+    if (config.itemExists("data_age_threshold")) {
+        const std::string ageThreshold = config.getValue("data_age_threshold");
+        long threshold = 0;
+        try {
+            threshold = std::stol(ageThreshold);
+        }
+        catch (const std::exception&) {
+            threshold = 0;
+        }
+        if (threshold > 0) {
+            if (static_cast<uint64_t>(threshold) != m_dataAge.getThresholdMs()) {
+                // The data over the previous threshold are not counted again, the stations start over
+                m_dataAge.setThresholdMs(static_cast<uint64_t>(threshold));
+                m_dataAge.reset();
+            }
+        }
+        else {
+            HnzPivotUtility::log_error("%s Invalid data_age_threshold: %s", beforeLog.c_str(), ageThreshold.c_str()); //LCOV_EXCL_LINE
+        }
+    }
+    if (config.itemExists("chatter_max_transitions") || config.itemExists("chatter_window")) {
+        long maxTransitions = m_chatterFilter.getMaxTransitions();
+        long windowMs = static_cast<long>(m_chatterFilter.getWindowMs());
+        if (config.itemExists("chatter_max_transitions")) {
+            const std::string maxTransitionsStr = config.getValue("chatter_max_transitions");
+            try {
+                maxTransitions = std::stol(maxTransitionsStr);
+            }
+            catch (const std::exception&) {
+                maxTransitions = -1;
+            }
+            if (maxTransitions < 0) {
+                HnzPivotUtility::log_error("%s Invalid chatter_max_transitions: %s", beforeLog.c_str(), maxTransitionsStr.c_str()); //LCOV_EXCL_LINE
+                maxTransitions = m_chatterFilter.getMaxTransitions();
+            }
+        }
+        if (config.itemExists("chatter_window")) {
+            const std::string windowStr = config.getValue("chatter_window");
+            try {
+                windowMs = std::stol(windowStr);
+            }
+            catch (const std::exception&) {
+                windowMs = 0;
+            }
+            if (windowMs <= 0) {
+                HnzPivotUtility::log_error("%s Invalid chatter_window: %s", beforeLog.c_str(), windowStr.c_str()); //LCOV_EXCL_LINE
+                windowMs = static_cast<long>(m_chatterFilter.getWindowMs());
+            }
+        }
+        m_chatterFilter.setLimits(static_cast<unsigned int>(maxTransitions), static_cast<uint64_t>(windowMs));
+        if (!m_chatterFilter.isEnabled()) {
+            // No longer updated: the points chattering are forgotten, their last transition suppressed is not forwarded
+            m_chatterFilter.reset(m_filterConfig->getPointCount());
+        }
+    }
+    if (config.itemExists("tm_aggregation") || config.itemExists("tm_aggregation_window")) {
+        HnzPivotTmAggregator::Mode mode = m_tmAggregator.getMode();
+        long windowMs = static_cast<long>(m_tmAggregator.getWindowMs());
+        if (config.itemExists("tm_aggregation")) {
+            const std::string modeStr = config.getValue("tm_aggregation");
+            if (!HnzPivotTmAggregator::modeFromStr(modeStr, mode)) {
+                HnzPivotUtility::log_error("%s Invalid tm_aggregation: %s", beforeLog.c_str(), modeStr.c_str()); //LCOV_EXCL_LINE
+            }
+        }
+        if (config.itemExists("tm_aggregation_window")) {
+            const std::string windowStr = config.getValue("tm_aggregation_window");
+            try {
+                windowMs = std::stol(windowStr);
+            }
+            catch (const std::exception&) {
+                windowMs = 0;
+            }
+            if (windowMs <= 0) {
+                HnzPivotUtility::log_error("%s Invalid tm_aggregation_window: %s", beforeLog.c_str(), windowStr.c_str()); //LCOV_EXCL_LINE
+                windowMs = static_cast<long>(m_tmAggregator.getWindowMs());
+            }
+        }
+        m_tmAggregator.setWindow(mode, static_cast<uint64_t>(windowMs));
+    }
+    if (config.itemExists("outdated_storm_ratio")) {
+        const std::string ratioStr = config.getValue("outdated_storm_ratio");
+        long ratio = -1;
+        try {
+            ratio = std::stol(ratioStr);
+        }
+        catch (const std::exception&) {
+            ratio = -1;
+        }
+        if ((ratio < 0) || (ratio > 100)) {
+            HnzPivotUtility::log_error("%s Invalid outdated_storm_ratio: %s", beforeLog.c_str(), ratioStr.c_str()); //LCOV_EXCL_LINE
+        }
+        else {
+            m_outdatedStorm.setRatio(static_cast<unsigned int>(ratio));
+        }
+    }
+    if (config.itemExists("command_dedup_window")) {
+        const std::string windowStr = config.getValue("command_dedup_window");
+        long windowMs = -1;
+        try {
+            windowMs = std::stol(windowStr);
+        }
+        catch (const std::exception&) {
+            windowMs = -1;
+        }
+        if (windowMs < 0) {
+            HnzPivotUtility::log_error("%s Invalid command_dedup_window: %s", beforeLog.c_str(), windowStr.c_str()); //LCOV_EXCL_LINE
+        }
+        else {
+            m_commandDeduplicator.setWindowMs(static_cast<uint64_t>(windowMs));
+        }
+    }
+    if (config.itemExists("output_profile")) {
+        const std::string outputProfile = config.getValue("output_profile");
+        if (outputProfile == "full") {
+            m_compactOutput = false;
+        }
+        else if (outputProfile == "compact") {
+            m_compactOutput = true;
+        }
+        else {
+            HnzPivotUtility::log_error("%s Invalid output_profile: %s", beforeLog.c_str(), outputProfile.c_str()); //LCOV_EXCL_LINE
+        }
+    }
+    if (config.itemExists("output_format")) {
+        const std::string outputFormat = config.getValue("output_format");
+        if (outputFormat == "datapoint") {
+            m_jsonOutput = false;
+        }
+        else if (outputFormat == "json") {
+            m_jsonOutput = true;
+        }
+        else {
+            HnzPivotUtility::log_error("%s Invalid output_format: %s", beforeLog.c_str(), outputFormat.c_str()); //LCOV_EXCL_LINE
+        }
+    }
+    if (config.itemExists("async_ingest")) {
+        m_asyncIngest = config.getValue("async_ingest") == "true";
+    }
+    if (config.itemExists("async_queue_depth")) {
+        const std::string queueDepth = config.getValue("async_queue_depth");
+        long depth = 0;
+        try {
+            depth = std::stol(queueDepth);
+        }
+        catch (const std::exception&) {
+            depth = 0;
+        }
+        if (depth > 0) {
+            m_asyncQueueDepth = static_cast<size_t>(depth);
+        }
+        else {
+            HnzPivotUtility::log_error("%s Invalid async_queue_depth: %s", beforeLog.c_str(), queueDepth.c_str()); //LCOV_EXCL_LINE
+        }
+    }
+    if (config.itemExists("async_backpressure")) {
+        const std::string policy = config.getValue("async_backpressure");
+        if (!HnzPivotIngestQueue::policyFromStr(policy, m_asyncPolicy)) {
+            HnzPivotUtility::log_error("%s Invalid async_backpressure: %s", beforeLog.c_str(), policy.c_str()); //LCOV_EXCL_LINE
+        }
+    }
 }
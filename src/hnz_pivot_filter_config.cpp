@@ -9,6 +9,11 @@
  * 
  */
 
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+#include <rapidjson/reader.h>
 #include <rapidjson/error/en.h>
 
 #include "hnz_pivot_utility.hpp"
@@ -16,200 +21,712 @@
 
 
 HNZPivotDataPoint::HNZPivotDataPoint(const std::string& label, const std::string& pivotId, const std::string& pivotType,
-                                    const std::string& typeIdStr, unsigned int address):
-    m_label(label), m_pivotId(pivotId), m_pivotType(pivotType), m_typeIdStr(typeIdStr), m_address(address)
+                                    const std::string& typeIdStr, unsigned int address, bool hasStation, unsigned int station):
+    m_label(label), m_pivotId(pivotId), m_pivotType(pivotType), m_typeIdStr(typeIdStr), m_address(address),
+    m_hasStation(hasStation), m_station(hasStation ? station : 0)
 {}
 
-void HNZPivotConfig::importExchangeConfig(const std::string& exchangeConfig)
+bool HNZPivotDataPoint::operator==(const HNZPivotDataPoint& other) const
 {
-  m_exchange_data_is_complete = false;
-  bool is_complete = true;
+    return m_address == other.m_address && m_hasStation == other.m_hasStation && m_station == other.m_station &&
+           m_label == other.m_label && m_pivotId == other.m_pivotId && m_pivotType == other.m_pivotType &&
+           m_typeIdStr == other.m_typeIdStr;
+}
 
-  m_exchangeDefinitions.clear();
-  m_pivotIdLookup.clear();
+/**
+ * SAX handler of the exchanged_data JSON, only the hnzip protocol entries of the datapoints are kept.
+ * It reports the same errors as a DOM walk of the configuration: missing or invalid fields make the
+ * configuration incomplete, a datapoint or protocol that is not an object stops the import.
+ */
+class HNZPivotConfigHandler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, HNZPivotConfigHandler>
+{
+public:
+  explicit HNZPivotConfigHandler(HNZPivotConfig& config): m_config(config) {}
+
+  // Any scalar value other than a string
+  bool Default();
+  bool String(const char* str, rapidjson::SizeType length, bool copy);
+  bool Key(const char* str, rapidjson::SizeType length, bool copy);
+  bool StartObject();
+  bool EndObject(rapidjson::SizeType memberCount);
+  bool StartArray();
+  bool EndArray(rapidjson::SizeType elementCount);
+
+  bool isAborted() const {return m_aborted;}
+  /**
+   * Check the mandatory parts of the configuration once the whole JSON is parsed
+   * @return True if the configuration is complete
+   */
+  bool checkComplete() const;
+
+private:
+  enum class Context {
+    ROOT,
+    EXCHANGED_DATA,
+    DATAPOINTS,
+    DATAPOINT,
+    PROTOCOLS,
+    PROTOCOL
+  };
+
+  /*
+   * String field of an object, only its first occurrence is taken into account
+   */
+  struct Field {
+    bool found = false;
+    bool valid = false;
+    std::string value;
+  };
+
+  struct HnzProtocol {
+    Field address;
+    Field typeId;
+    // Optional
+    Field station;
+  };
+
+  Field* m_currentField();
+  void m_invalidateCurrentField();
+  bool m_checkField(const Field& field, const char* key) const;
+  bool m_parseStation(const Field& field, unsigned int& station) const;
+  void m_endProtocol();
+  void m_endDataPoint();
+  void m_endExchangedData();
+  bool m_abort();
+
+  HNZPivotConfig& m_config;
+  std::vector<Context> m_contexts;
+  std::string m_key;
+  // Depth of the JSON containers currently skipped
+  int m_skipDepth = 0;
+  bool m_aborted = false;
+  bool m_isComplete = true;
+
+  bool m_exchangedDataKeyFound = false;
+  bool m_exchangedDataFound = false;
+  Field m_name;
+  Field m_version;
+  bool m_datapointsKeyFound = false;
+  bool m_datapointsFound = false;
+
+  Field m_label;
+  Field m_pivotId;
+  Field m_pivotType;
+  bool m_protocolsKeyFound = false;
+  bool m_protocolsFound = false;
+  std::vector<HnzProtocol> m_hnzProtocols;
+
+  Field m_protocolName;
+  HnzProtocol m_protocol;
+};
+
+HNZPivotConfigHandler::Field* HNZPivotConfigHandler::m_currentField() {
+  switch (m_contexts.back()) {
+    case Context::EXCHANGED_DATA:
+      if (m_key == JSON_NAME) return &m_name;
+      if (m_key == JSON_VERSION) return &m_version;
+      break;
+    case Context::DATAPOINT:
+      if (m_key == LABEL) return &m_label;
+      if (m_key == PIVOT_ID) return &m_pivotId;
+      if (m_key == PIVOT_TYPE) return &m_pivotType;
+      break;
+    case Context::PROTOCOL:
+      if (m_key == JSON_NAME) return &m_protocolName;
+      if (m_key == MESSAGE_ADDRESS) return &m_protocol.address;
+      if (m_key == MESSAGE_CODE) return &m_protocol.typeId;
+      if (m_key == MESSAGE_STATION) return &m_protocol.station;
+      break;
+    default:
+      break;
+  }
+  return nullptr;
+}
 
-  rapidjson::Document document;
-  if (document.Parse(exchangeConfig.c_str()).HasParseError()) {
-    HnzPivotUtility::log_fatal("Parsing error in exchanged_data json, offset " + //LCOV_EXCL_LINE
-                               std::to_string(static_cast<unsigned>(document.GetErrorOffset())) + //LCOV_EXCL_LINE
-                               " " + //LCOV_EXCL_LINE
-                               GetParseError_En(document.GetParseError())); //LCOV_EXCL_LINE
-    return;
+void HNZPivotConfigHandler::m_invalidateCurrentField() {
+  Field* field = m_currentField();
+  if (field != nullptr && !field->found) {
+    field->found = true;
   }
-  if (!document.IsObject()) return;
+}
 
-  if (!m_check_object(document, JSON_EXCHANGED_DATA_NAME)) return;
+bool HNZPivotConfigHandler::m_checkField(const Field& field, const char* key) const {
+  if (!field.found || !field.valid) {
+    std::string s = key;
+    HnzPivotUtility::log_error( //LCOV_EXCL_LINE
+        "Error with the field " + s + //LCOV_EXCL_LINE
+        ", the value does not exist or is not a std::string."); //LCOV_EXCL_LINE
+    return false;
+  }
+  return true;
+}
 
-  const rapidjson::Value &info = document[JSON_EXCHANGED_DATA_NAME];
+bool HNZPivotConfigHandler::m_abort() {
+  m_aborted = true;
+  return false;
+}
 
-  is_complete &= m_check_string(info, JSON_NAME);
-  is_complete &= m_check_string(info, JSON_VERSION);
+bool HNZPivotConfigHandler::Default() {
+  if (m_skipDepth > 0) return true;
+  if (m_contexts.empty()) return m_abort();
+  Context context = m_contexts.back();
+  if (context == Context::DATAPOINTS || context == Context::PROTOCOLS) return m_abort();
+  m_invalidateCurrentField();
+  return true;
+}
+
+bool HNZPivotConfigHandler::String(const char* str, rapidjson::SizeType length, bool) {
+  if (m_skipDepth > 0) return true;
+  if (m_contexts.empty()) return m_abort();
+  Context context = m_contexts.back();
+  if (context == Context::DATAPOINTS || context == Context::PROTOCOLS) return m_abort();
+  Field* field = m_currentField();
+  if (field != nullptr && !field->found) {
+    field->found = true;
+    field->valid = true;
+    field->value.assign(str, length);
+  }
+  return true;
+}
+
+bool HNZPivotConfigHandler::Key(const char* str, rapidjson::SizeType length, bool) {
+  if (m_skipDepth > 0) return true;
+  m_key.assign(str, length);
+  // Only the first occurrence of a container key is taken into account
+  bool* keyFound = nullptr;
+  switch (m_contexts.back()) {
+    case Context::ROOT:
+      if (m_key == JSON_EXCHANGED_DATA_NAME) keyFound = &m_exchangedDataKeyFound;
+      break;
+    case Context::EXCHANGED_DATA:
+      if (m_key == DATAPOINTS) keyFound = &m_datapointsKeyFound;
+      break;
+    case Context::DATAPOINT:
+      if (m_key == PROTOCOLS) keyFound = &m_protocolsKeyFound;
+      break;
+    default:
+      break;
+  }
+  if (keyFound != nullptr) {
+    if (*keyFound) {
+      m_key.clear();
+    }
+    *keyFound = true;
+  }
+  return true;
+}
+
+bool HNZPivotConfigHandler::StartObject() {
+  if (m_skipDepth > 0) {
+    m_skipDepth++;
+    return true;
+  }
+  if (m_contexts.empty()) {
+    m_contexts.push_back(Context::ROOT);
+    return true;
+  }
+  switch (m_contexts.back()) {
+    case Context::ROOT:
+      if (m_key == JSON_EXCHANGED_DATA_NAME) {
+        m_exchangedDataFound = true;
+        m_contexts.push_back(Context::EXCHANGED_DATA);
+        return true;
+      }
+      break;
+    case Context::DATAPOINTS:
+      m_label = Field();
+      m_pivotId = Field();
+      m_pivotType = Field();
+      m_protocolsKeyFound = false;
+      m_protocolsFound = false;
+      m_hnzProtocols.clear();
+      m_contexts.push_back(Context::DATAPOINT);
+      return true;
+    case Context::PROTOCOLS:
+      m_protocolName = Field();
+      m_protocol = HnzProtocol();
+      m_contexts.push_back(Context::PROTOCOL);
+      return true;
+    default:
+      m_invalidateCurrentField();
+      break;
+  }
+  m_skipDepth = 1;
+  return true;
+}
+
+bool HNZPivotConfigHandler::EndObject(rapidjson::SizeType) {
+  if (m_skipDepth > 0) {
+    m_skipDepth--;
+    return true;
+  }
+  Context context = m_contexts.back();
+  m_contexts.pop_back();
+  if (context == Context::PROTOCOL) {
+    m_endProtocol();
+  }
+  else if (context == Context::DATAPOINT) {
+    m_endDataPoint();
+  }
+  else if (context == Context::EXCHANGED_DATA) {
+    m_endExchangedData();
+  }
+  return true;
+}
 
-  if (!m_check_array(info, DATAPOINTS)) return;
+bool HNZPivotConfigHandler::StartArray() {
+  if (m_skipDepth > 0) {
+    m_skipDepth++;
+    return true;
+  }
+  if (m_contexts.empty()) return m_abort();
+  switch (m_contexts.back()) {
+    case Context::EXCHANGED_DATA:
+      if (m_key == DATAPOINTS) {
+        m_datapointsFound = true;
+        m_contexts.push_back(Context::DATAPOINTS);
+        return true;
+      }
+      break;
+    case Context::DATAPOINT:
+      if (m_key == PROTOCOLS) {
+        m_protocolsFound = true;
+        m_contexts.push_back(Context::PROTOCOLS);
+        return true;
+      }
+      break;
+    case Context::DATAPOINTS:
+    case Context::PROTOCOLS:
+      return m_abort();
+    default:
+      break;
+  }
+  m_invalidateCurrentField();
+  m_skipDepth = 1;
+  return true;
+}
 
-  for (const rapidjson::Value &msg : info[DATAPOINTS].GetArray()) {
-    if (!msg.IsObject()) return;
+bool HNZPivotConfigHandler::EndArray(rapidjson::SizeType) {
+  if (m_skipDepth > 0) {
+    m_skipDepth--;
+    return true;
+  }
+  m_contexts.pop_back();
+  return true;
+}
 
-    std::string label;
-    std::string pivotId;
-    std::string pivotType;
+void HNZPivotConfigHandler::m_endProtocol() {
+  m_isComplete &= m_checkField(m_protocolName, JSON_NAME);
 
-    is_complete &= m_retrieve(msg, LABEL, &label);
-    is_complete &= m_retrieve(msg, PIVOT_ID, &pivotId);
-    is_complete &= m_retrieve(msg, PIVOT_TYPE, &pivotType);
+  if (m_protocolName.value != HNZ_NAME) return;
 
-    if (!m_check_array(msg, PROTOCOLS)) continue;
-  
-    for (const rapidjson::Value &protocol : msg[PROTOCOLS].GetArray()) {
-      if (!protocol.IsObject()) return;
+  m_hnzProtocols.push_back(m_protocol);
+}
 
-      std::string protocol_name;
+void HNZPivotConfigHandler::m_endDataPoint() {
+  m_isComplete &= m_checkField(m_label, LABEL);
+  m_isComplete &= m_checkField(m_pivotId, PIVOT_ID);
+  m_isComplete &= m_checkField(m_pivotType, PIVOT_TYPE);
 
-      is_complete &= m_retrieve(protocol, JSON_NAME, &protocol_name);
+  if (!m_protocolsFound) {
+    std::string s = PROTOCOLS;
+    HnzPivotUtility::log_error("The array " + s + //LCOV_EXCL_LINE
+                               " is required but not found."); //LCOV_EXCL_LINE
+    return;
+  }
 
-      if (protocol_name != HNZ_NAME) continue;
+  for (const HnzProtocol& protocol : m_hnzProtocols) {
+    m_isComplete &= m_checkField(protocol.address, MESSAGE_ADDRESS);
+    m_isComplete &= m_checkField(protocol.typeId, MESSAGE_CODE);
 
-      std::string address;
-      std::string msg_code;
+    unsigned long tmp = 0;
+    try {
+      tmp = std::stoul(protocol.address.value);
+    }
+    catch (const std::invalid_argument&) {
+      m_isComplete = false;
+      HnzPivotUtility::log_error("Error with the field %s, the value is not an unsigned integer: %s", MESSAGE_ADDRESS, protocol.address.value.c_str()); //LCOV_EXCL_LINE
+      continue;
+    }
+    catch (const std::out_of_range&) {
+      tmp = static_cast<unsigned long>(-1);
+    }
+    unsigned int msg_address = 0;
+    // Check if number is in range for unsigned int
+    if (tmp > static_cast<unsigned int>(-1)) {
+      m_isComplete = false;
+      HnzPivotUtility::log_error("Error with the field %s, the value is out of range for unsigned integer: %ld", MESSAGE_ADDRESS, tmp); //LCOV_EXCL_LINE
+    } else {
+      msg_address = static_cast<unsigned int>(tmp);
+    }
 
-      is_complete &= m_retrieve(protocol, MESSAGE_ADDRESS, &address);
-      is_complete &= m_retrieve(protocol, MESSAGE_CODE, &msg_code);
-      
-      unsigned long tmp = std::stoul(address);
-      unsigned int msg_address = 0;
-      // Check if number is in range for unsigned int
-      if (tmp > static_cast<unsigned int>(-1)) {
-        is_complete = false;
-        HnzPivotUtility::log_error("Error with the field %s, the value is out of range for unsigned integer: %ld", MESSAGE_ADDRESS, tmp); //LCOV_EXCL_LINE
-      } else {
-        msg_address = static_cast<unsigned int>(tmp);
+    unsigned int station = 0;
+    if (protocol.station.found) {
+      if (!m_parseStation(protocol.station, station)) {
+        m_isComplete = false;
+        continue;
       }
-      auto newDp = std::make_shared<HNZPivotDataPoint>(label, pivotId, pivotType, msg_code, msg_address);
-      m_exchangeDefinitions[pivotId] = newDp;
-      m_pivotIdLookup[m_getLookupHash(msg_code, msg_address)] = pivotId;
     }
+    m_config.m_addDataPoint(m_label.value, m_pivotId.value, m_pivotType.value, protocol.typeId.value, msg_address,
+                            protocol.station.found, station);
   }
-
-  m_exchange_data_is_complete = is_complete;
 }
 
-bool HNZPivotConfig::m_check_string(const rapidjson::Value &json, const char *key) {
-  if (!json.HasMember(key) || !json[key].IsString()) {
-    std::string s = key;
-    HnzPivotUtility::log_error( //LCOV_EXCL_LINE
-        "Error with the field " + s + //LCOV_EXCL_LINE
-        ", the value does not exist or is not a std::string."); //LCOV_EXCL_LINE
+bool HNZPivotConfigHandler::m_parseStation(const Field& field, unsigned int& station) const {
+  if (!m_checkField(field, MESSAGE_STATION)) return false;
+  unsigned long tmp = 0;
+  size_t parsedLength = 0;
+  try {
+    tmp = std::stoul(field.value, &parsedLength);
+  }
+  catch (const std::exception&) {
+    parsedLength = 0;
+  }
+  if (parsedLength == 0 || parsedLength != field.value.size() || field.value[0] == '-' ||
+      tmp > static_cast<unsigned int>(-1)) {
+    HnzPivotUtility::log_error("Error with the field %s, the value is not an unsigned integer: %s", MESSAGE_STATION, field.value.c_str()); //LCOV_EXCL_LINE
     return false;
   }
+  station = static_cast<unsigned int>(tmp);
   return true;
 }
 
-bool HNZPivotConfig::m_check_array(const rapidjson::Value &json, const char *key) {
-  if (!json.HasMember(key) || !json[key].IsArray()) {
-    std::string s = key;
-    HnzPivotUtility::log_error("The array " + s + //LCOV_EXCL_LINE
+void HNZPivotConfigHandler::m_endExchangedData() {
+  m_isComplete &= m_checkField(m_name, JSON_NAME);
+  m_isComplete &= m_checkField(m_version, JSON_VERSION);
+}
+
+bool HNZPivotConfigHandler::checkComplete() const {
+  if (m_aborted) return false;
+
+  if (!m_exchangedDataFound) {
+    std::string s = JSON_EXCHANGED_DATA_NAME;
+    HnzPivotUtility::log_error("The object " + s + //LCOV_EXCL_LINE
                                " is required but not found."); //LCOV_EXCL_LINE
     return false;
   }
-  return true;
-}
 
-bool HNZPivotConfig::m_check_object(const rapidjson::Value &json, const char *key) {
-  if (!json.HasMember(key) || !json[key].IsObject()) {
-    std::string s = key;
-    HnzPivotUtility::log_error("The object " + s + //LCOV_EXCL_LINE
+  if (!m_datapointsFound) {
+    std::string s = DATAPOINTS;
+    HnzPivotUtility::log_error("The array " + s + //LCOV_EXCL_LINE
                                " is required but not found."); //LCOV_EXCL_LINE
     return false;
   }
-  return true;
+
+  return m_isComplete;
 }
 
-bool HNZPivotConfig::m_retrieve(const rapidjson::Value &json, const char *key,
-                         unsigned int *target) {
-  if (!json.HasMember(key) || !json[key].IsUint()) {
-    std::string s = key;
-    HnzPivotUtility::log_error( //LCOV_EXCL_LINE
-        "Error with the field " + s + //LCOV_EXCL_LINE
-        ", the value does not exist or is not an unsigned integer."); //LCOV_EXCL_LINE
-    return false;
+void HNZPivotConfig::importExchangeConfig(const std::string& exchangeConfig)
+{
+  m_parseExchangeConfig(exchangeConfig);
+  m_buildIndexes();
+}
+
+void HNZPivotConfig::importExchangeConfig(const std::string& exchangeConfig, const HNZPivotConfig& previousConfig)
+{
+  // The datapoints and the pivotId index of the previous configuration are shared or copied, not rebuilt
+  m_exchangeDefinitions = previousConfig.m_exchangeDefinitions;
+  m_pivotIdHash = previousConfig.m_pivotIdHash;
+  m_dataPointsBySlot = previousConfig.m_dataPointsBySlot;
+  m_commandsBySlot = previousConfig.m_commandsBySlot;
+  m_commandCount = previousConfig.m_commandCount;
+  HNZPivotConfig newConfig;
+  newConfig.m_parseExchangeConfig(exchangeConfig);
+  applyExchangeConfig(std::move(newConfig));
+}
+
+void HNZPivotConfig::m_parseExchangeConfig(const std::string& exchangeConfig)
+{
+  m_exchange_data_is_complete = false;
+
+  m_exchangeDefinitions.clear();
+  m_pivotIdLookup.clear();
+
+  HNZPivotConfigHandler handler(*this);
+  rapidjson::Reader reader;
+  rapidjson::StringStream stream(exchangeConfig.c_str());
+  reader.Parse(stream, handler);
+  if (reader.HasParseError() && !handler.isAborted()) {
+    // Nothing is imported from an invalid JSON
+    m_exchangeDefinitions.clear();
+    m_pivotIdLookup.clear();
+    m_sortLookup();
+    HnzPivotUtility::log_fatal("Parsing error in exchanged_data json, offset " + //LCOV_EXCL_LINE
+                               std::to_string(static_cast<unsigned>(reader.GetErrorOffset())) + //LCOV_EXCL_LINE
+                               " " + //LCOV_EXCL_LINE
+                               GetParseError_En(reader.GetParseErrorCode())); //LCOV_EXCL_LINE
+    return;
   }
-  *target = json[key].GetUint();
-  return true;
+
+  m_sortLookup();
+  m_exchange_data_is_complete = handler.checkComplete();
 }
 
-bool HNZPivotConfig::m_retrieve(const rapidjson::Value &json, const char *key,
-                         unsigned int *target, unsigned int def) {
-  if (!json.HasMember(key)) {
-    *target = def;
-  } else {
-    if (!json[key].IsUint()) {
-      std::string s = key;
-      HnzPivotUtility::log_error("Error with the field " + s + //LCOV_EXCL_LINE
-                                 ", the value is not an unsigned integer."); //LCOV_EXCL_LINE
-      return false;
+/*
+ * Walk both sorted maps together and apply the difference of newMap to currentMap, the entries of newMap are moved.
+ * Each step is done with an iterator hint, so the update costs a single pass over both maps.
+ * onChanged is called with each value replaced in currentMap.
+ */
+template <typename Map, typename Equal, typename Changed>
+static void mergeMap(Map& currentMap, Map& newMap, Equal isEqual, Changed onChanged,
+                     HNZPivotConfig::ExchangeChanges& changes) {
+  auto current = currentMap.begin();
+  auto next = newMap.begin();
+  while (current != currentMap.end() || next != newMap.end()) {
+    if (next == newMap.end() || (current != currentMap.end() && current->first < next->first)) {
+      current = currentMap.erase(current);
+      changes.removed++;
+    }
+    else if (current == currentMap.end() || next->first < current->first) {
+      currentMap.emplace_hint(current, next->first, std::move(next->second));
+      changes.added++;
+      ++next;
+    }
+    else {
+      if (isEqual(current->second, next->second)) {
+        changes.unchanged++;
+      }
+      else {
+        current->second = std::move(next->second);
+        onChanged(current->second);
+        changes.changed++;
+      }
+      ++current;
+      ++next;
     }
-    *target = json[key].GetUint();
   }
-  return true;
 }
 
-bool HNZPivotConfig::m_retrieve(const rapidjson::Value &json, const char *key, std::string *target) {
-  if (!json.HasMember(key) || !json[key].IsString()) {
-    std::string s = key;
-    HnzPivotUtility::log_error( //LCOV_EXCL_LINE
-        "Error with the field " + s + //LCOV_EXCL_LINE
-        ", the value does not exist or is not a std::string."); //LCOV_EXCL_LINE
-    return false;
+HNZPivotConfig::ExchangeChanges HNZPivotConfig::applyExchangeConfig(HNZPivotConfig&& newConfig)
+{
+  ExchangeChanges changes;
+  std::vector<const HNZPivotDataPoint*> changedDataPoints;
+  mergeMap(m_exchangeDefinitions, newConfig.m_exchangeDefinitions,
+           [](const std::shared_ptr<HNZPivotDataPoint>& a, const std::shared_ptr<HNZPivotDataPoint>& b) {
+             return *a == *b;
+           },
+           [&changedDataPoints](const std::shared_ptr<HNZPivotDataPoint>& dataPoint) {
+             changedDataPoints.push_back(dataPoint.get());
+           }, changes);
+  m_exchange_data_is_complete = newConfig.m_exchange_data_is_complete;
+  if ((changes.added > 0) || (changes.removed > 0)) {
+    // The hash function only covers the pivotIds it was built with
+    m_buildPointIndexes();
   }
-  *target = json[key].GetString();
-  return true;
+  else {
+    // Same pivotIds: the hash function and the slots are kept, only the slots of the changed datapoints are updated
+    for (const HNZPivotDataPoint* dataPoint : changedDataPoints) {
+      m_setSlot(m_pivotIdHash.getSlot(dataPoint->getPivotId()), dataPoint);
+    }
+  }
+  // The lookup table only holds keys and pivot ids, it is taken as a whole and only its station ranges are rebuilt
+  m_pivotIdLookup.swap(newConfig.m_pivotIdLookup);
+  m_buildStationRanges();
+  newConfig.m_exchangeDefinitions.clear();
+  newConfig.m_pivotIdLookup.clear();
+  newConfig.m_clearIndexes();
+  return changes;
 }
 
-bool HNZPivotConfig::m_retrieve(const rapidjson::Value &json, const char *key, std::string *target,
-                         const std::string& def) {
-  if (!json.HasMember(key)) {
-    *target = def;
-  } else {
-    if (!json[key].IsString()) {
-      std::string s = key;
-      HnzPivotUtility::log_error("Error with the field " + s + //LCOV_EXCL_LINE
-                                 ", the value is not a std::string."); //LCOV_EXCL_LINE
-      return false;
+void HNZPivotConfig::shareDataPoints(const HNZPivotConfig& previousConfig)
+{
+  auto previous = previousConfig.m_exchangeDefinitions.begin();
+  auto previousEnd = previousConfig.m_exchangeDefinitions.end();
+  for (auto& entry : m_exchangeDefinitions) {
+    while ((previous != previousEnd) && (previous->first < entry.first)) {
+      ++previous;
+    }
+    if (previous == previousEnd) {
+      break;
+    }
+    if ((previous->first == entry.first) && (previous->second != entry.second) && (*previous->second == *entry.second)) {
+      entry.second = previous->second;
+      m_setSlot(m_pivotIdHash.getSlot(entry.first), entry.second.get());
     }
-    *target = json[key].GetString();
   }
-  return true;
 }
 
-bool HNZPivotConfig::m_retrieve(const rapidjson::Value &json, const char *key,
-                         long long int *target, long long int def) {
-  if (!json.HasMember(key)) {
-    *target = def;
-  } else {
-    if (!json[key].IsInt64()) {
-      std::string s = key;
-      HnzPivotUtility::log_error("Error with the field " + s + //LCOV_EXCL_LINE
-                                 ", the value is not a long long integer."); //LCOV_EXCL_LINE
-      return false;
+HNZPivotConfig::ExchangeChanges HNZPivotConfig::mapPointIndexes(const HNZPivotConfig& previousConfig,
+                                                               std::vector<size_t>& pointIndexes) const
+{
+  ExchangeChanges changes;
+  pointIndexes.assign(previousConfig.getPointCount(), HnzPivotPerfectHash::NOT_FOUND);
+  for (size_t i = 0; i < previousConfig.getPointCount(); i++) {
+    const HNZPivotDataPoint* previousDataPoint = previousConfig.getDataPoint(i);
+    size_t pointIndex = findPointIndex(previousDataPoint->getPivotId());
+    if (pointIndex == HnzPivotPerfectHash::NOT_FOUND) {
+      changes.removed++;
+    }
+    else if ((m_dataPointsBySlot[pointIndex] == previousDataPoint) ||
+             (*m_dataPointsBySlot[pointIndex] == *previousDataPoint)) {
+      pointIndexes[i] = pointIndex;
+      changes.unchanged++;
+    }
+    else {
+      changes.changed++;
+    }
+  }
+  changes.added = getPointCount() - changes.unchanged - changes.changed;
+  return changes;
+}
+
+void HNZPivotConfig::m_addDataPoint(const std::string& label, const std::string& pivotId, const std::string& pivotType,
+                                    const std::string& typeIdStr, unsigned int address, bool hasStation, unsigned int station) {
+  auto newDp = std::make_shared<HNZPivotDataPoint>(label, pivotId, pivotType, typeIdStr, address, hasStation, station);
+  m_exchangeDefinitions[pivotId] = newDp;
+  LookupEntry entry;
+  entry.hasStation = hasStation;
+  entry.station = newDp->getStation();
+  entry.typeIdStr = typeIdStr;
+  entry.address = address;
+  entry.pivotId = pivotId;
+  // Sorted by m_sortLookup() once the whole configuration is imported
+  m_pivotIdLookup.push_back(std::move(entry));
+}
+
+static bool isLookupKeyLess(bool hasStationA, unsigned int stationA, const std::string& typeIdA, unsigned int addressA,
+                            bool hasStationB, unsigned int stationB, const std::string& typeIdB, unsigned int addressB) {
+  return std::tie(hasStationA, stationA, typeIdA, addressA) < std::tie(hasStationB, stationB, typeIdB, addressB);
+}
+
+void HNZPivotConfig::m_sortLookup() {
+  auto isLess = [](const LookupEntry& a, const LookupEntry& b) {
+    return isLookupKeyLess(a.hasStation, a.station, a.typeIdStr, a.address, b.hasStation, b.station, b.typeIdStr, b.address);
+  };
+  std::stable_sort(m_pivotIdLookup.begin(), m_pivotIdLookup.end(), isLess);
+  // When a key is configured several times, the last entry wins
+  size_t count = 0;
+  for (size_t i = 0; i < m_pivotIdLookup.size(); i++) {
+    if (count > 0 && !isLess(m_pivotIdLookup[count - 1], m_pivotIdLookup[i])) {
+      m_pivotIdLookup[count - 1] = std::move(m_pivotIdLookup[i]);
+    }
+    else {
+      if (count != i) {
+        m_pivotIdLookup[count] = std::move(m_pivotIdLookup[i]);
+      }
+      count++;
     }
-    *target = json[key].GetInt64();
   }
-  return true;
+  m_pivotIdLookup.resize(count);
+}
+
+void HNZPivotConfig::m_buildIndexes() {
+  m_buildPointIndexes();
+  m_buildStationRanges();
 }
 
-std::string HNZPivotConfig::findPivotId(const std::string& typeIdStr, unsigned int address) const {
-    const std::string& lookupHash = m_getLookupHash(typeIdStr, address);
-    if (m_pivotIdLookup.count(lookupHash) == 0){
-        return "";
+void HNZPivotConfig::m_buildPointIndexes() {
+  // The pivotIds are not copied, the datapoints own them and are kept by m_dataPointsBySlot
+  std::vector<const std::string*> pivotIds;
+  pivotIds.reserve(m_exchangeDefinitions.size());
+  for (const auto& entry : m_exchangeDefinitions) {
+    pivotIds.push_back(&entry.second->getPivotId());
+  }
+  m_dataPointsBySlot.clear();
+  m_commandsBySlot.clear();
+  m_commandCount = 0;
+  // Keys of a map are distinct, so the hash function can always be built
+  if (!m_pivotIdHash.build(pivotIds)) {
+    HnzPivotUtility::log_error("Could not build the pivot ID index of %lu datapoints", //LCOV_EXCL_LINE
+                               static_cast<unsigned long>(pivotIds.size())); //LCOV_EXCL_LINE
+  }
+  m_dataPointsBySlot.resize(m_pivotIdHash.size(), nullptr);
+  m_commandsBySlot.resize(m_pivotIdHash.size(), nullptr);
+  for (const auto& entry : m_exchangeDefinitions) {
+    size_t slot = m_pivotIdHash.getSlot(entry.second->getPivotId());
+    if (slot == HnzPivotPerfectHash::NOT_FOUND) continue;
+    m_setSlot(slot, entry.second.get());
+  }
+}
+
+void HNZPivotConfig::m_setSlot(size_t slot, const HNZPivotDataPoint* dataPoint) {
+  if (m_commandsBySlot[slot] != nullptr) {
+    m_commandCount--;
+  }
+  m_dataPointsBySlot[slot] = dataPoint;
+  const std::string& typeIdStr = dataPoint->getTypeId();
+  if (typeIdStr == "TC" || typeIdStr == "TVC") {
+    m_commandsBySlot[slot] = dataPoint;
+    m_commandCount++;
+  }
+  else {
+    m_commandsBySlot[slot] = nullptr;
+  }
+}
+
+void HNZPivotConfig::m_clearIndexes() {
+  m_pivotIdHash.clear();
+  m_dataPointsBySlot.clear();
+  m_commandsBySlot.clear();
+  m_commandCount = 0;
+  m_stationRanges.clear();
+  m_anyStationRange = LookupRange();
+}
+
+void HNZPivotConfig::m_buildStationRanges() {
+  m_stationRanges.clear();
+  m_anyStationRange = LookupRange();
+  for (size_t i = 0; i < m_pivotIdLookup.size(); i++) {
+    const LookupEntry& entry = m_pivotIdLookup[i];
+    LookupRange& range = entry.hasStation ? m_stationRanges[entry.station] : m_anyStationRange;
+    if (range.begin == range.end) {
+      range.begin = i;
     }
-    return m_pivotIdLookup.at(lookupHash);
+    range.end = i + 1;
+  }
+}
+
+const std::string* HNZPivotConfig::m_findInRange(const LookupRange& range, const std::string& typeIdStr,
+                                                 unsigned int address) const {
+  auto begin = m_pivotIdLookup.begin() + static_cast<std::ptrdiff_t>(range.begin);
+  auto end = m_pivotIdLookup.begin() + static_cast<std::ptrdiff_t>(range.end);
+  // All entries of the range have the same station, only typeid and address are compared
+  auto it = std::lower_bound(begin, end, 0, [&typeIdStr, address](const LookupEntry& entry, int) {
+    return isLookupKeyLess(false, 0, entry.typeIdStr, entry.address, false, 0, typeIdStr, address);
+  });
+  if (it == end || it->address != address || it->typeIdStr != typeIdStr) {
+    return nullptr;
+  }
+  return &it->pivotId;
+}
+
+const std::string& HNZPivotConfig::findPivotId(unsigned int station, const std::string& typeIdStr, unsigned int address) const {
+    static const std::string notFound;
+    auto stationRange = m_stationRanges.find(station);
+    if (stationRange != m_stationRanges.end()) {
+        const std::string* pivotId = m_findInRange(stationRange->second, typeIdStr, address);
+        if (pivotId != nullptr) {
+            return *pivotId;
+        }
+    }
+    const std::string* pivotId = m_findInRange(m_anyStationRange, typeIdStr, address);
+    return pivotId != nullptr ? *pivotId : notFound;
+}
+
+size_t HNZPivotConfig::findPointIndex(const std::string& pivotId) const {
+    size_t slot = m_pivotIdHash.getSlot(pivotId);
+    // The hash function gives a slot to any pivotId, only the one of the datapoint of the slot is configured
+    if ((slot == HnzPivotPerfectHash::NOT_FOUND) || (m_dataPointsBySlot[slot]->getPivotId() != pivotId)) {
+        return HnzPivotPerfectHash::NOT_FOUND;
+    }
+    return slot;
+}
+
+const HNZPivotDataPoint* HNZPivotConfig::findCommand(const std::string& pivotId) const {
+    size_t pointIndex = 0;
+    return findCommand(pivotId, pointIndex);
+}
+
+const HNZPivotDataPoint* HNZPivotConfig::findCommand(const std::string& pivotId, size_t& pointIndex) const {
+    size_t slot = findPointIndex(pivotId);
+    if ((slot == HnzPivotPerfectHash::NOT_FOUND) || (m_commandsBySlot[slot] == nullptr)) {
+        return nullptr;
+    }
+    pointIndex = slot;
+    return m_commandsBySlot[slot];
 }
 
 const std::string& HNZPivotConfig::getPluginName() {
   static std::string pluginName(FILTER_NAME);
   return pluginName;
 }
-
-std::string HNZPivotConfig::m_getLookupHash(const std::string& typeIdStr, unsigned int address) const {
-    return typeIdStr + "-" + std::to_string(address);
-}
\ No newline at end of file
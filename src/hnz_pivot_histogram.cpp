@@ -0,0 +1,102 @@
+/*
+ * FledgePower HNZ <-> pivot filter latency histogram.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <limits>
+
+#include "hnz_pivot_histogram.hpp"
+
+constexpr unsigned HnzPivotHistogram::SUB_BUCKET_BITS;
+constexpr unsigned HnzPivotHistogram::SUB_BUCKET_COUNT;
+constexpr unsigned HnzPivotHistogram::BUCKET_COUNT;
+
+HnzPivotHistogram::HnzPivotHistogram()
+{
+    reset();
+}
+
+void HnzPivotHistogram::reset()
+{
+    for (auto& bucket : m_buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_min.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+HnzPivotHistogram::Snapshot HnzPivotHistogram::snapshot() const
+{
+    Snapshot snap;
+    snap.buckets.reserve(BUCKET_COUNT);
+    for (const auto& bucket : m_buckets) {
+        snap.buckets.push_back(bucket.load(std::memory_order_relaxed));
+    }
+    snap.count = m_count.load(std::memory_order_relaxed);
+    snap.sum = m_sum.load(std::memory_order_relaxed);
+    snap.max = m_max.load(std::memory_order_relaxed);
+    snap.min = (snap.count > 0) ? m_min.load(std::memory_order_relaxed) : 0;
+    return snap;
+}
+
+uint64_t HnzPivotHistogram::bucketLowerBound(unsigned index)
+{
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    unsigned shift = (index >> SUB_BUCKET_BITS) - 1;
+    uint64_t subBucket = index & (SUB_BUCKET_COUNT - 1);
+    return (SUB_BUCKET_COUNT + subBucket) << shift;
+}
+
+uint64_t HnzPivotHistogram::bucketUpperBound(unsigned index)
+{
+    if (index < SUB_BUCKET_COUNT) {
+        return index;
+    }
+    unsigned shift = (index >> SUB_BUCKET_BITS) - 1;
+    return bucketLowerBound(index) + ((1ULL << shift) - 1);
+}
+
+double HnzPivotHistogram::Snapshot::mean() const
+{
+    if (count == 0) {
+        return 0.0;
+    }
+    return static_cast<double>(sum) / static_cast<double>(count);
+}
+
+uint64_t HnzPivotHistogram::Snapshot::percentile(double percent) const
+{
+    uint64_t total = 0;
+    for (uint64_t bucketCount : buckets) {
+        total += bucketCount;
+    }
+    if (total == 0) {
+        return 0;
+    }
+    if (percent < 0.0) percent = 0.0;
+    if (percent > 100.0) percent = 100.0;
+    // Rank of the value we are looking for, starting at 1
+    auto rank = static_cast<uint64_t>((percent / 100.0) * static_cast<double>(total) + 0.5);
+    if (rank == 0) {
+        rank = 1;
+    }
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < buckets.size(); i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint64_t upperBound = bucketUpperBound(i);
+            return (max > 0 && upperBound > max) ? max : upperBound;
+        }
+    }
+    return max;
+}
@@ -0,0 +1,254 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <vector>
+#include <datapoint.h>
+#include <reading_set.h>
+
+#include "hnz_pivot_ingest_queue.hpp"
+#include "hnz_pivot_utility.hpp"
+
+constexpr int HnzPivotIngestQueue::COUNTER_COUNT;
+
+HnzPivotIngestQueue::HnzPivotIngestQueue(size_t depth, Policy policy):
+    m_depth(depth > 0 ? depth : 1),
+    m_policy(policy),
+    m_cells(new Cell[m_depth]),
+    m_pushPosition(0),
+    m_popPosition(0),
+    m_closed(false),
+    m_waitingConsumers(0),
+    m_waitingProducers(0)
+{
+    // The cell of position p is free for a push when its sequence is 2p, and holds a reading set for a pop when it is 2p + 1
+    // (with p and p + 1 instead, a cell pushed at p could not be told from a cell free for p + depth when depth is 1)
+    for (size_t i = 0; i < m_depth; i++) {
+        m_cells[i].sequence.store(2 * i, std::memory_order_relaxed);
+        m_cells[i].readingSet = nullptr;
+    }
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+HnzPivotIngestQueue::~HnzPivotIngestQueue()
+{
+    ReadingSet* readingSet = nullptr;
+    while ((readingSet = tryPop()) != nullptr) {
+        delete readingSet;
+    }
+}
+
+bool HnzPivotIngestQueue::m_tryPush(ReadingSet* readingSet)
+{
+    size_t position = m_pushPosition.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = m_cells[position % m_depth];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence - 2 * position);
+        if (diff == 0) {
+            if (m_pushPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.readingSet = readingSet;
+                cell.sequence.store(2 * position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if (diff < 0) {
+            // Cell still holding the reading set pushed one lap before: the queue is full
+            return false;
+        }
+        else {
+            position = m_pushPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+ReadingSet* HnzPivotIngestQueue::tryPop()
+{
+    ReadingSet* readingSet = m_tryPop();
+    if (readingSet != nullptr) {
+        m_wakeUp(m_waitingProducers, m_notFull);
+    }
+    return readingSet;
+}
+
+ReadingSet* HnzPivotIngestQueue::m_tryPop()
+{
+    size_t position = m_popPosition.load(std::memory_order_relaxed);
+    while (true) {
+        Cell& cell = m_cells[position % m_depth];
+        size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<std::ptrdiff_t>(sequence - (2 * position + 1));
+        if (diff == 0) {
+            if (m_popPosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                ReadingSet* readingSet = cell.readingSet;
+                cell.sequence.store(2 * (position + m_depth), std::memory_order_release);
+                return readingSet;
+            }
+        }
+        else if (diff < 0) {
+            // Cell not pushed yet: the queue is empty
+            return nullptr;
+        }
+        else {
+            position = m_popPosition.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void HnzPivotIngestQueue::m_wakeUp(std::atomic<int>& waiting, std::condition_variable& condition)
+{
+    // Pairs with the fence of the waiting thread: either it sees the cell just pushed or popped, or we see it waiting
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (waiting.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> guard(m_waitMutex);
+        condition.notify_all();
+    }
+}
+
+bool HnzPivotIngestQueue::push(ReadingSet* readingSet)
+{
+    if (m_closed.load(std::memory_order_acquire)) {
+        return false;
+    }
+    bool blocked = false;
+    while (!m_tryPush(readingSet)) {
+        if (m_policy == Policy::DROP_NEWEST) {
+            delete readingSet;
+            m_increment(Counter::DROPPED_NEWEST);
+            return true;
+        }
+        if (m_policy == Policy::DROP_OLDEST) {
+            ReadingSet* oldest = tryPop();
+            if (oldest != nullptr) {
+                delete oldest;
+                m_increment(Counter::DROPPED_OLDEST);
+            }
+            continue;
+        }
+        if (!blocked) {
+            blocked = true;
+            m_increment(Counter::BLOCKED);
+        }
+        std::unique_lock<std::mutex> lock(m_waitMutex);
+        m_waitingProducers.fetch_add(1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        // Read under the mutex: close() sets the flag before notifying under the same mutex, so it cannot be missed
+        bool closed = m_closed.load(std::memory_order_acquire);
+        bool pushed = !closed && m_tryPush(readingSet);
+        if (!pushed && !closed) {
+            m_notFull.wait(lock);
+            closed = m_closed.load(std::memory_order_acquire);
+        }
+        m_waitingProducers.fetch_sub(1, std::memory_order_relaxed);
+        if (pushed) {
+            break;
+        }
+        if (closed) {
+            // Not taken, the caller keeps the reading set
+            return false;
+        }
+    }
+    m_increment(Counter::ENQUEUED);
+    m_wakeUp(m_waitingConsumers, m_notEmpty);
+    return true;
+}
+
+ReadingSet* HnzPivotIngestQueue::pop()
+{
+    while (true) {
+        ReadingSet* readingSet = tryPop();
+        if (readingSet != nullptr) {
+            return readingSet;
+        }
+        bool closed = false;
+        {
+            std::unique_lock<std::mutex> lock(m_waitMutex);
+            m_waitingConsumers.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            // Read before trying again, so that all reading sets pushed before the queue was closed are seen
+            closed = m_closed.load(std::memory_order_acquire);
+            readingSet = m_tryPop();
+            if ((readingSet == nullptr) && !closed) {
+                m_notEmpty.wait(lock);
+            }
+            m_waitingConsumers.fetch_sub(1, std::memory_order_relaxed);
+        }
+        if (readingSet != nullptr) {
+            // Only once m_waitMutex is released, waking up the producers takes it
+            m_wakeUp(m_waitingProducers, m_notFull);
+            return readingSet;
+        }
+        if (closed) {
+            return nullptr;
+        }
+    }
+}
+
+void HnzPivotIngestQueue::close()
+{
+    m_closed.store(true, std::memory_order_release);
+    std::lock_guard<std::mutex> guard(m_waitMutex);
+    m_notEmpty.notify_all();
+    m_notFull.notify_all();
+}
+
+Datapoint* HnzPivotIngestQueue::toDatapoint(const std::string& name) const
+{
+    Datapoint* queue = HnzPivotUtility::createDp(name);
+
+    HnzPivotUtility::addElementWithValue(queue, "depth", static_cast<long>(m_depth));
+    for (int counterIndex = 0; counterIndex < COUNTER_COUNT; counterIndex++) {
+        auto counter = static_cast<Counter>(counterIndex);
+        HnzPivotUtility::addElementWithValue(queue, CounterStr(counter), static_cast<long>(get(counter)));
+    }
+
+    return queue;
+}
+
+std::string HnzPivotIngestQueue::CounterStr(Counter counter)
+{
+    switch (counter) {
+        case Counter::ENQUEUED:
+            return "enqueued";
+        case Counter::DROPPED_OLDEST:
+            return "dropped_oldest";
+        case Counter::DROPPED_NEWEST:
+            return "dropped_newest";
+        case Counter::BLOCKED:
+            return "blocked";
+    }
+    return "";
+}
+
+std::string HnzPivotIngestQueue::PolicyStr(Policy policy)
+{
+    switch (policy) {
+        case Policy::BLOCK:
+            return "block";
+        case Policy::DROP_OLDEST:
+            return "drop_oldest";
+        case Policy::DROP_NEWEST:
+            return "drop_newest";
+    }
+    return "";
+}
+
+bool HnzPivotIngestQueue::policyFromStr(const std::string& policyStr, Policy& policy)
+{
+    for (Policy candidate : {Policy::BLOCK, Policy::DROP_OLDEST, Policy::DROP_NEWEST}) {
+        if (policyStr == PolicyStr(candidate)) {
+            policy = candidate;
+            return true;
+        }
+    }
+    return false;
+}
@@ -11,6 +11,7 @@
 
 #include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <datapoint.h>
 
 #include "hnz_pivot_utility.hpp"
@@ -18,56 +19,45 @@
 #include "hnz_pivot_filter_config.hpp"
 
 
-static Datapoint* createDp(const std::string& name)
+static void appendJsonString(std::string& json, const std::string& value)
 {
-    auto datapoints = new std::vector<Datapoint*>;
-
-    DatapointValue dpv(datapoints, true);
-
-    auto dp = new Datapoint(name, dpv);
-
-    return dp;
-}
-
-template <class T>
-static Datapoint* createDpWithValue(const std::string& name, const T value)
-{
-    DatapointValue dpv(value);
-
-    auto dp = new Datapoint(name, dpv);
-
-    return dp;
+    json += '"';
+    for (char c : value) {
+        if ((c == '"') || (c == '\\')) {
+            json += '\\';
+            json += c;
+        }
+        else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            json += escaped;
+        }
+        else {
+            json += c;
+        }
+    }
+    json += '"';
 }
 
-static Datapoint* addElement(Datapoint* dp, const std::string& name)
+/*
+ * Append "name":rawValue to the fields of a JSON object being written
+ */
+static void appendJsonField(std::string& json, const char* name, const std::string& rawValue)
 {
-    DatapointValue& dpv = dp->getData();
-
-    std::vector<Datapoint*>* subDatapoints = dpv.getDpVec();
-
-    Datapoint* element = createDp(name);
-
-    if (element) {
-       subDatapoints->push_back(element);
+    if (!json.empty()) {
+        json += ',';
     }
-
-    return element;
+    json += '"';
+    json += name;
+    json += "\":";
+    json += rawValue;
 }
 
-template <class T>
-static Datapoint* addElementWithValue(Datapoint* dp, const std::string& name, const T value)
+static std::string jsonString(const std::string& value)
 {
-    DatapointValue& dpv = dp->getData();
-
-    std::vector<Datapoint*>* subDatapoints = dpv.getDpVec();
-
-    Datapoint* element = createDpWithValue(name, value);
-
-    if (element) {
-       subDatapoints->push_back(element);
-    }
-
-    return element;
+    std::string json;
+    appendJsonString(json, value);
+    return json;
 }
 
 static Datapoint* getChild(Datapoint* dp, const std::string& name)
@@ -526,131 +516,242 @@ HnzPivotObject::HnzPivotObject(Datapoint* pivotData) {
     handleGTIX();
 }
 
-HnzPivotObject::HnzPivotObject(const std::string& pivotLN, const std::string& valueType)
+HnzPivotJsonFragments HnzPivotJsonFragments::build(const std::string& pivotLN, const std::string& pivotId,
+                                                   const std::string& pivotType)
 {
-    m_dp = createDp("PIVOT");
+    HnzPivotJsonFragments fragments;
+    fragments.lnOpen = "{" + jsonString(pivotLN) + ":{\"Identifier\":" + jsonString(pivotId);
+    fragments.cdcOpen = jsonString(pivotType) + ":{";
+    return fragments;
+}
 
-    m_ln = addElement(m_dp, pivotLN);
+HnzPivotObject::HnzPivotObject(const std::string& pivotLN, const std::string& valueType, bool compact,
+                               const HnzPivotJsonFragments* jsonFragments):
+    m_compact(compact), m_jsonFragments(jsonFragments)
+{
+    if (m_jsonFragments) {
+        m_lnJson = m_jsonFragments->lnOpen;
+        if (!m_compact) {
+            appendJsonField(m_lnJson, "ComingFrom", "\"hnzip\"");
+        }
+        return;
+    }
+
+    m_dp = HnzPivotUtility::createDp("PIVOT");
 
-    addElementWithValue(m_ln, "ComingFrom", "hnzip");
+    m_ln = HnzPivotUtility::addElement(m_dp, pivotLN);
+
+    if (!m_compact) {
+        HnzPivotUtility::addElementWithValue(m_ln, "ComingFrom", "hnzip");
+    }
 
-    m_cdc = addElement(m_ln, valueType);
+    m_cdc = HnzPivotUtility::addElement(m_ln, valueType);
 }
 
 void HnzPivotObject::setIdentifier(const std::string& identifier)
 {
-    addElementWithValue(m_ln, "Identifier", identifier);
+    if (m_jsonFragments) {
+        // Already part of the fragments
+        return;
+    }
+    HnzPivotUtility::addElementWithValue(m_ln, "Identifier", identifier);
 }
 
 void HnzPivotObject::setCause(int cause)
 {
-    Datapoint* causeDp = addElement(m_ln, "Cause");
+    if (m_jsonFragments) {
+        appendJsonField(m_lnJson, "Cause", "{\"stVal\":" + std::to_string(cause) + "}");
+        return;
+    }
+    Datapoint* causeDp = HnzPivotUtility::addElement(m_ln, "Cause");
 
-    addElementWithValue(causeDp, "stVal", static_cast<long>(cause));
+    HnzPivotUtility::addElementWithValue(causeDp, "stVal", static_cast<long>(cause));
 }
 
 void HnzPivotObject::setStVal(bool value)
 {
-    addElementWithValue(m_cdc, "stVal", static_cast<long>(value ? 1 : 0));
+    if (m_jsonFragments) {
+        appendJsonField(m_cdcJson, "stVal", value ? "1" : "0");
+        return;
+    }
+    HnzPivotUtility::addElementWithValue(m_cdc, "stVal", static_cast<long>(value ? 1 : 0));
 }
 
 void HnzPivotObject::setStValStr(const std::string& value)
 {
-    addElementWithValue(m_cdc, "stVal", value);
+    if (m_jsonFragments) {
+        appendJsonField(m_cdcJson, "stVal", jsonString(value));
+        return;
+    }
+    HnzPivotUtility::addElementWithValue(m_cdc, "stVal", value);
 }
 
 void HnzPivotObject::setMagF(float value)
 {
-    Datapoint* mag = addElement(m_cdc, "mag");
+    if (m_jsonFragments) {
+        appendJsonField(m_cdcJson, "mag", "{\"f\":" + std::to_string(value) + "}");
+        return;
+    }
+    Datapoint* mag = HnzPivotUtility::addElement(m_cdc, "mag");
 
-    addElementWithValue(mag, "f", value);
+    HnzPivotUtility::addElementWithValue(mag, "f", value);
 }
 
 void HnzPivotObject::setMagI(int value)
 {
-    Datapoint* mag = addElement(m_cdc, "mag");
+    if (m_jsonFragments) {
+        appendJsonField(m_cdcJson, "mag", "{\"i\":" + std::to_string(value) + "}");
+        return;
+    }
+    Datapoint* mag = HnzPivotUtility::addElement(m_cdc, "mag");
 
-    addElementWithValue(mag, "i", static_cast<long>(value));
+    HnzPivotUtility::addElementWithValue(mag, "i", static_cast<long>(value));
 }
 
 void HnzPivotObject::setConfirmation(bool value)
 {
-    Datapoint* confirmation = addElement(m_ln, "Confirmation");
+    if (m_jsonFragments) {
+        appendJsonField(m_lnJson, "Confirmation", value ? "{\"stVal\":1}" : "{\"stVal\":0}");
+        return;
+    }
+    Datapoint* confirmation = HnzPivotUtility::addElement(m_ln, "Confirmation");
 
     if (confirmation) {
-        addElementWithValue(confirmation, "stVal", static_cast<long>(value ? 1 : 0));
+        HnzPivotUtility::addElementWithValue(confirmation, "stVal", static_cast<long>(value ? 1 : 0));
     }
 }
 
-void HnzPivotObject::addQuality(unsigned int doValid, bool doOutdated, bool doTsC, bool doTsS)
+void HnzPivotObject::addQuality(unsigned int doValid, bool doOutdated, bool doTsC, bool doTsS, bool oscillatory)
 {
-    Datapoint* q = addElement(m_cdc, "q");
+    bool good = (doValid != 1) && !doOutdated && !doTsC && !doTsS && !oscillatory;
+    // A good quality has no detail, the whole q is the default
+    if (m_compact && good) {
+        return;
+    }
+    if (m_jsonFragments) {
+        std::string q = "{\"Validity\":";
+        q += (doValid == 1) ? "\"invalid\"" : (good ? "\"good\"" : "\"questionable\"");
+        if (doTsC || doOutdated || oscillatory) {
+            std::string detailQuality;
+            if (doTsC || doOutdated) {
+                appendJsonField(detailQuality, "oldData", "1");
+            }
+            if (oscillatory) {
+                appendJsonField(detailQuality, "oscillatory", "1");
+            }
+            appendJsonField(q, "DetailQuality", "{" + detailQuality + "}");
+        }
+        appendJsonField(m_cdcJson, "q", q + "}");
+        return;
+    }
+    Datapoint* q = HnzPivotUtility::addElement(m_cdc, "q");
     // doValid of 1 means "invalid"
     if (doValid == 1) {
-        addElementWithValue(q, "Validity", "invalid");
+        HnzPivotUtility::addElementWithValue(q, "Validity", "invalid");
     }
-    else if (doOutdated || doTsC || doTsS) {
-        addElementWithValue(q, "Validity", "questionable");
+    else if (doOutdated || doTsC || doTsS || oscillatory) {
+        HnzPivotUtility::addElementWithValue(q, "Validity", "questionable");
     }
     else {
-        addElementWithValue(q, "Validity", "good");
+        HnzPivotUtility::addElementWithValue(q, "Validity", "good");
     }
 
-    if (doTsC || doOutdated) {
-        Datapoint* detailQuality = addElement(q, "DetailQuality");
+    if (doTsC || doOutdated || oscillatory) {
+        Datapoint* detailQuality = HnzPivotUtility::addElement(q, "DetailQuality");
 
-        addElementWithValue(detailQuality, "oldData", 1L);
+        if (doTsC || doOutdated) {
+            HnzPivotUtility::addElementWithValue(detailQuality, "oldData", 1L);
+        }
+        if (oscillatory) {
+            HnzPivotUtility::addElementWithValue(detailQuality, "oscillatory", 1L);
+        }
     }
 }
 
 void HnzPivotObject::addTmOrg(bool substituted)
 {
-    Datapoint* tmOrg = addElement(m_ln, "TmOrg");
+    if (m_compact && !substituted) {
+        return;
+    }
+    if (m_jsonFragments) {
+        appendJsonField(m_lnJson, "TmOrg", substituted ? "{\"stVal\":\"substituted\"}" : "{\"stVal\":\"genuine\"}");
+        return;
+    }
+    Datapoint* tmOrg = HnzPivotUtility::addElement(m_ln, "TmOrg");
 
     if (substituted)
-        addElementWithValue(tmOrg, "stVal", "substituted");
+        HnzPivotUtility::addElementWithValue(tmOrg, "stVal", "substituted");
     else
-        addElementWithValue(tmOrg, "stVal", "genuine");
+        HnzPivotUtility::addElementWithValue(tmOrg, "stVal", "genuine");
 }
 
 void HnzPivotObject::addTmValidity(bool invalid)
 {
-    Datapoint* tmValidity = addElement(m_ln, "TmValidity");
+    if (m_compact && !invalid) {
+        return;
+    }
+    if (m_jsonFragments) {
+        appendJsonField(m_lnJson, "TmValidity", invalid ? "{\"stVal\":\"invalid\"}" : "{\"stVal\":\"good\"}");
+        return;
+    }
+    Datapoint* tmValidity = HnzPivotUtility::addElement(m_ln, "TmValidity");
 
     if (invalid)
-        addElementWithValue(tmValidity, "stVal", "invalid");
+        HnzPivotUtility::addElementWithValue(tmValidity, "stVal", "invalid");
     else
-        addElementWithValue(tmValidity, "stVal", "good");
+        HnzPivotUtility::addElementWithValue(tmValidity, "stVal", "good");
 }
 
 void HnzPivotObject::addTimestamp(unsigned long doTs, bool doTsS)
 {
-    Datapoint* t = addElement(m_cdc, "t");
-
     auto timePair = HnzPivotTimestamp::fromTimestamp(static_cast<long>(doTs));
-    addElementWithValue(t, "SecondSinceEpoch", timePair.first);
-    addElementWithValue(t, "FractionOfSecond", timePair.second);
+    if (m_jsonFragments) {
+        std::string t = "{\"SecondSinceEpoch\":" + std::to_string(timePair.first) +
+                        ",\"FractionOfSecond\":" + std::to_string(timePair.second);
+        if (doTsS) {
+            appendJsonField(t, "TimeQuality", "{\"clockNotSynchronized\":1}");
+        }
+        appendJsonField(m_cdcJson, "t", t + "}");
+        return;
+    }
+
+    Datapoint* t = HnzPivotUtility::addElement(m_cdc, "t");
+
+    HnzPivotUtility::addElementWithValue(t, "SecondSinceEpoch", timePair.first);
+    HnzPivotUtility::addElementWithValue(t, "FractionOfSecond", timePair.second);
 
     if (doTsS) {
-        Datapoint* timeQuality = addElement(t, "TimeQuality");
-        addElementWithValue(timeQuality, "clockNotSynchronized", 1L);
+        Datapoint* timeQuality = HnzPivotUtility::addElement(t, "TimeQuality");
+        HnzPivotUtility::addElementWithValue(timeQuality, "clockNotSynchronized", 1L);
     }
 }
 
-std::vector<Datapoint*> HnzPivotObject::toHnzCommandObject(std::shared_ptr<HNZPivotDataPoint> exchangeConfig) const
+Datapoint* HnzPivotObject::toDatapoint()
 {
-    std::vector<Datapoint*> commandObject;
+    if (!m_jsonFragments) {
+        return m_dp;
+    }
+    std::string json;
+    json.reserve(m_lnJson.size() + m_jsonFragments->cdcOpen.size() + m_cdcJson.size() + 4);
+    json += m_lnJson;
+    json += ',';
+    json += m_jsonFragments->cdcOpen;
+    json += m_cdcJson;
+    json += "}}}";
+    DatapointValue dpv(json);
+    return new Datapoint("PIVOT_JSON", dpv);
+}
 
-    Datapoint* type = createDpWithValue("co_type", exchangeConfig->getTypeId());
+void HnzPivotObject::toHnzCommandObject(const HNZPivotDataPoint& exchangeConfig, std::vector<Datapoint*>& commandObject) const
+{
+    Datapoint* type = HnzPivotUtility::createDpWithValue("co_type", exchangeConfig.getTypeId());
     commandObject.push_back(type);
 
-    Datapoint* addr = createDpWithValue("co_addr", static_cast<long>(exchangeConfig->getAddress()));
+    Datapoint* addr = HnzPivotUtility::createDpWithValue("co_addr", static_cast<long>(exchangeConfig.getAddress()));
     commandObject.push_back(addr);
 
-    Datapoint* value = createDpWithValue("co_value", intVal);
+    Datapoint* value = HnzPivotUtility::createDpWithValue("co_value", intVal);
     commandObject.push_back(value);
-
-    return commandObject;
 }
 
 bool HnzPivotObject::checkCdcTypeMatch(HnzPivotCdc pivotCdc, HnzPivotClass pivotClass) {
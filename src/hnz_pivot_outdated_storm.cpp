@@ -0,0 +1,89 @@
+/*
+ * FledgePower HNZ <-> pivot filter outdated storm.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <algorithm>
+#include <datapoint.h>
+
+#include "hnz_pivot_outdated_storm.hpp"
+#include "hnz_pivot_utility.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_object.hpp"
+
+void HnzPivotOutdatedStorm::setConfig(const HNZPivotConfig& config)
+{
+    m_anyStationCount = 0;
+    m_stationCounts.clear();
+    for (size_t i = 0; i < config.getPointCount(); i++) {
+        const HNZPivotDataPoint* dataPoint = config.getDataPoint(i);
+        if ((dataPoint->getTypeId() != "TS") && (dataPoint->getTypeId() != "TM")) {
+            continue;
+        }
+        if (dataPoint->hasStation()) {
+            m_stationCounts[dataPoint->getStation()]++;
+        }
+        else {
+            m_anyStationCount++;
+        }
+    }
+}
+
+size_t HnzPivotOutdatedStorm::getMonitoringPointCount(unsigned int station) const
+{
+    auto stationCount = m_stationCounts.find(station);
+    return m_anyStationCount + (stationCount != m_stationCounts.end() ? stationCount->second : 0);
+}
+
+void HnzPivotOutdatedStorm::addPoint(unsigned int station, bool invalid, const Point& point)
+{
+    m_groups[std::make_pair(station, invalid)].push_back(point);
+}
+
+void HnzPivotOutdatedStorm::takeStorms(std::vector<Storm>& storms)
+{
+    for (auto& group : m_groups) {
+        size_t pointCount = getMonitoringPointCount(group.first.first);
+        // A single outdated point is not a storm
+        size_t minPoints = std::max<size_t>((pointCount * m_ratio + 99) / 100, 2);
+        if (group.second.size() < minPoints) {
+            continue;
+        }
+        Storm storm;
+        storm.station = group.first.first;
+        storm.invalid = group.first.second;
+        storm.points.swap(group.second);
+        storms.push_back(std::move(storm));
+    }
+    m_groups.clear();
+}
+
+Datapoint* HnzPivotOutdatedStorm::toDatapoint(const Storm& storm, uint64_t timestampMs)
+{
+    Datapoint* stationQuality = HnzPivotUtility::createDp("station_quality");
+    HnzPivotUtility::addElementWithValue(stationQuality, "station", static_cast<long>(storm.station));
+
+    // Same quality as the pivot objects of the data_objects
+    Datapoint* q = HnzPivotUtility::addElement(stationQuality, "q");
+    HnzPivotUtility::addElementWithValue(q, "Validity", std::string(storm.invalid ? "invalid" : "questionable"));
+    Datapoint* detailQuality = HnzPivotUtility::addElement(q, "DetailQuality");
+    HnzPivotUtility::addElementWithValue(detailQuality, "oldData", 1L);
+
+    Datapoint* t = HnzPivotUtility::addElement(stationQuality, "t");
+    auto timePair = HnzPivotTimestamp::fromTimestamp(static_cast<long>(timestampMs));
+    HnzPivotUtility::addElementWithValue(t, "SecondSinceEpoch", timePair.first);
+    HnzPivotUtility::addElementWithValue(t, "FractionOfSecond", timePair.second);
+
+    Datapoint* points = HnzPivotUtility::addElement(stationQuality, "points");
+    for (const Point& point : storm.points) {
+        HnzPivotUtility::addElementWithValue(points, point.exchangeConfig->getPivotId(), point.exchangeConfig->getPivotType());
+    }
+
+    return stationQuality;
+}
@@ -0,0 +1,187 @@
+/*
+ * FledgePower HNZ <-> pivot filter plugin.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "hnz_pivot_perfect_hash.hpp"
+
+// Average number of keys per bucket, more keys per bucket make the function smaller but longer to build
+static constexpr size_t KEYS_PER_BUCKET = 4;
+// Pilots tried for a bucket before trying another seed
+static constexpr uint32_t MAX_PILOT = 1 << 24;
+static constexpr int MAX_SEEDS = 8;
+
+constexpr size_t HnzPivotPerfectHash::NOT_FOUND;
+
+static inline uint64_t mix(uint64_t x)
+{
+    // splitmix64 finalizer
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Map a 32 bits value to [0, range) without a division
+static inline size_t reduce(uint32_t value, size_t range)
+{
+    return static_cast<size_t>((static_cast<uint64_t>(value) * static_cast<uint64_t>(range)) >> 32);
+}
+
+uint64_t HnzPivotPerfectHash::m_hash(const std::string& key) const
+{
+    // Keys are read 8 bytes at a time, then mixed so that all bits of the result depend on the whole key
+    const char* data = key.data();
+    size_t size = key.size();
+    uint64_t hash = m_seed ^ (static_cast<uint64_t>(size) * 0x9E3779B97F4A7C15ULL);
+    uint64_t word = 0;
+    if (size < sizeof(word)) {
+        for (size_t i = 0; i < size; i++) {
+            word = (word << 8) | static_cast<unsigned char>(data[i]);
+        }
+        hash = (hash ^ word) * 0x9FB21C651E98DF25ULL;
+        return mix(hash);
+    }
+    const char* last = data + size - sizeof(word);
+    for (; data < last; data += sizeof(word)) {
+        memcpy(&word, data, sizeof(word));
+        hash = (hash ^ word) * 0x9FB21C651E98DF25ULL;
+        hash ^= hash >> 29;
+    }
+    // Last 8 bytes, overlapping the previous word if the size is not a multiple of 8
+    memcpy(&word, last, sizeof(word));
+    hash = (hash ^ word) * 0x9FB21C651E98DF25ULL;
+    return mix(hash);
+}
+
+size_t HnzPivotPerfectHash::m_bucket(uint64_t hash) const
+{
+    return reduce(static_cast<uint32_t>(hash >> 32), m_pilots.size());
+}
+
+size_t HnzPivotPerfectHash::m_slot(uint64_t hash, uint32_t pilot) const
+{
+    return reduce(static_cast<uint32_t>(mix(hash ^ (0x9E3779B97F4A7C15ULL * (static_cast<uint64_t>(pilot) + 1)))), m_size);
+}
+
+void HnzPivotPerfectHash::clear()
+{
+    m_seed = 0;
+    m_size = 0;
+    m_pilots.clear();
+}
+
+bool HnzPivotPerfectHash::build(const std::vector<const std::string*>& keys)
+{
+    clear();
+    size_t keyCount = keys.size();
+    if (keyCount == 0) {
+        return true;
+    }
+    size_t bucketCount = keyCount / KEYS_PER_BUCKET + 1;
+    std::vector<uint64_t> hashes(keyCount);
+    std::vector<size_t> bucketStarts(bucketCount + 1);
+    std::vector<size_t> bucketKeys(keyCount);
+    std::vector<size_t> bucketOrder(bucketCount);
+    std::vector<bool> taken(keyCount);
+    std::vector<size_t> slots;
+
+    for (int seed = 0; seed < MAX_SEEDS; seed++) {
+        m_seed = mix(static_cast<uint64_t>(seed) + 1);
+        m_pilots.assign(bucketCount, 0);
+        m_size = keyCount;
+
+        // Group the keys by bucket
+        std::fill(bucketStarts.begin(), bucketStarts.end(), 0);
+        for (size_t i = 0; i < keyCount; i++) {
+            hashes[i] = m_hash(*keys[i]);
+            bucketStarts[m_bucket(hashes[i]) + 1]++;
+        }
+        for (size_t b = 0; b < bucketCount; b++) {
+            bucketStarts[b + 1] += bucketStarts[b];
+        }
+        std::vector<size_t> bucketFill(bucketStarts.begin(), bucketStarts.end() - 1);
+        for (size_t i = 0; i < keyCount; i++) {
+            bucketKeys[bucketFill[m_bucket(hashes[i])]++] = i;
+        }
+
+        // Place the largest buckets first, while the table is still mostly empty
+        for (size_t b = 0; b < bucketCount; b++) {
+            bucketOrder[b] = b;
+        }
+        std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&bucketStarts](size_t a, size_t b) {
+            return bucketStarts[a + 1] - bucketStarts[a] > bucketStarts[b + 1] - bucketStarts[b];
+        });
+
+        std::fill(taken.begin(), taken.end(), false);
+        bool placed = true;
+        for (size_t b : bucketOrder) {
+            size_t begin = bucketStarts[b];
+            size_t end = bucketStarts[b + 1];
+            if (begin == end) {
+                break;
+            }
+            // Keys with the same hash can never be placed with this seed
+            for (size_t i = begin; i < end && placed; i++) {
+                for (size_t j = begin; j < i && placed; j++) {
+                    if (hashes[bucketKeys[i]] == hashes[bucketKeys[j]]) {
+                        if (*keys[bucketKeys[i]] == *keys[bucketKeys[j]]) {
+                            clear();
+                            return false;
+                        }
+                        placed = false;
+                    }
+                }
+            }
+            if (!placed) {
+                break;
+            }
+            uint32_t pilot = 0;
+            for (; pilot < MAX_PILOT; pilot++) {
+                slots.clear();
+                bool free = true;
+                for (size_t i = begin; i < end && free; i++) {
+                    size_t slot = m_slot(hashes[bucketKeys[i]], pilot);
+                    free = !taken[slot] && std::find(slots.begin(), slots.end(), slot) == slots.end();
+                    slots.push_back(slot);
+                }
+                if (free) {
+                    break;
+                }
+            }
+            if (pilot == MAX_PILOT) {
+                placed = false;
+                break;
+            }
+            m_pilots[b] = pilot;
+            for (size_t slot : slots) {
+                taken[slot] = true;
+            }
+        }
+        if (placed) {
+            return true;
+        }
+    }
+    clear();
+    return false;
+}
+
+size_t HnzPivotPerfectHash::getSlot(const std::string& key) const
+{
+    if (m_size == 0) {
+        return NOT_FOUND;
+    }
+    uint64_t hash = m_hash(key);
+    return m_slot(hash, m_pilots[m_bucket(hash)]);
+}
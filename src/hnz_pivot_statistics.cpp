@@ -0,0 +1,104 @@
+/*
+ * FledgePower HNZ <-> pivot filter statistics.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <vector>
+#include <datapoint.h>
+
+#include "hnz_pivot_statistics.hpp"
+#include "hnz_pivot_utility.hpp"
+
+constexpr int HnzPivotStatistics::DATA_TYPE_COUNT;
+constexpr int HnzPivotStatistics::COUNTER_COUNT;
+
+HnzPivotStatistics::HnzPivotStatistics()
+{
+    reset();
+}
+
+void HnzPivotStatistics::reset()
+{
+    for (auto& counter : m_counters) {
+        counter.store(0, std::memory_order_relaxed);
+    }
+}
+
+Datapoint* HnzPivotStatistics::toDatapoint(const std::string& name) const
+{
+    Datapoint* statistics = HnzPivotUtility::createDp(name);
+
+    for (int typeIndex = 0; typeIndex < DATA_TYPE_COUNT; typeIndex++) {
+        auto type = static_cast<DataType>(typeIndex);
+        Datapoint* typeDp = HnzPivotUtility::addElement(statistics, DataTypeStr(type));
+        for (int counterIndex = 0; counterIndex < COUNTER_COUNT; counterIndex++) {
+            auto counter = static_cast<Counter>(counterIndex);
+            HnzPivotUtility::addElementWithValue(typeDp, CounterStr(counter), static_cast<long>(get(type, counter)));
+        }
+    }
+
+    return statistics;
+}
+
+HnzPivotStatistics::DataType HnzPivotStatistics::dataTypeFromTypeId(const std::string& typeIdStr)
+{
+    if (typeIdStr == "TS") {
+        return DataType::TS;
+    }
+    else if (typeIdStr == "TM") {
+        return DataType::TM;
+    }
+    else if (typeIdStr == "TC") {
+        return DataType::TC;
+    }
+    else if (typeIdStr == "TVC") {
+        return DataType::TVC;
+    }
+    return DataType::OTHER;
+}
+
+std::string HnzPivotStatistics::DataTypeStr(DataType type)
+{
+    switch (type) {
+        case DataType::TS:
+            return "TS";
+        case DataType::TM:
+            return "TM";
+        case DataType::TC:
+            return "TC";
+        case DataType::TVC:
+            return "TVC";
+        case DataType::PIVOT:
+            return "PIVOT";
+        case DataType::OTHER:
+            return "OTHER";
+    }
+    return "";
+}
+
+std::string HnzPivotStatistics::CounterStr(Counter counter)
+{
+    switch (counter) {
+        case Counter::CONVERTED:
+            return "converted";
+        case Counter::UNKNOWN_ADDRESS:
+            return "dropped_unknown_address";
+        case Counter::TYPE_MISMATCH:
+            return "dropped_type_mismatch";
+        case Counter::OUT_OF_RANGE:
+            return "out_of_range";
+        case Counter::MISSING_ATTRIBUTE:
+            return "missing_attribute";
+        case Counter::PASSTHROUGH:
+            return "passthrough";
+        case Counter::SUPPRESSED:
+            return "suppressed";
+    }
+    return "";
+}
@@ -0,0 +1,158 @@
+/*
+ * FledgePower HNZ <-> pivot filter TM aggregator.
+ *
+ * Copyright (c) 2022, RTE (https://www.rte-france.com)
+ *
+ * Released under the Apache 2.0 Licence
+ *
+ * Author: Michael Zillgith (michael.zillgith at mz-automation.de)
+ *
+ */
+
+#include <algorithm>
+#include <cmath>
+
+#include "hnz_pivot_tm_aggregator.hpp"
+#include "hnz_pivot_utility.hpp"
+
+void HnzPivotTmAggregator::setWindow(Mode mode, uint64_t windowMs)
+{
+    if ((mode == m_mode) && (windowMs == m_windowMs)) {
+        return;
+    }
+    m_mode = mode;
+    m_windowMs = windowMs;
+    // Samples accumulated with the previous settings are dropped
+    reset(m_points.size());
+}
+
+void HnzPivotTmAggregator::reset(size_t pointCount)
+{
+    m_points.assign(pointCount, Accumulator());
+    m_openPoints.clear();
+}
+
+void HnzPivotTmAggregator::remap(const std::vector<size_t>& pointIndexes, size_t pointCount)
+{
+    HnzPivotUtility::remapPoints(m_points, pointIndexes, pointCount);
+    HnzPivotUtility::remapPointList(m_openPoints, pointIndexes, pointCount);
+}
+
+void HnzPivotTmAggregator::m_open(size_t pointIndex, uint64_t nowMs)
+{
+    Accumulator& point = m_points[pointIndex];
+    point.open = true;
+    point.windowStartMs = nowMs;
+    point.count = 0;
+    if (!point.listed) {
+        point.listed = true;
+        m_openPoints.push_back(pointIndex);
+    }
+}
+
+long HnzPivotTmAggregator::m_aggregate(const Accumulator& point) const
+{
+    switch (m_mode) {
+        case Mode::MEAN:
+            return std::lround(static_cast<double>(point.sum) / point.count);
+        case Mode::MIN:
+            return point.min;
+        case Mode::MAX:
+            return point.max;
+        default:
+            return point.last;
+    }
+}
+
+bool HnzPivotTmAggregator::addSample(size_t pointIndex, long value, uint64_t nowMs, long& aggregate)
+{
+    if (!isEnabled() || pointIndex >= m_points.size()) {
+        aggregate = value;
+        return true;
+    }
+    Accumulator& point = m_points[pointIndex];
+
+    if (!point.open) {
+        // Idle point, forwarded immediately
+        m_open(pointIndex, nowMs);
+        aggregate = value;
+        return true;
+    }
+    if (point.count == 0) {
+        point.sum = 0;
+        point.min = value;
+        point.max = value;
+    }
+    point.count++;
+    point.sum += value;
+    point.min = std::min(point.min, value);
+    point.max = std::max(point.max, value);
+    point.last = value;
+
+    if (nowMs < point.windowStartMs + m_windowMs) {
+        return false;
+    }
+    aggregate = m_aggregate(point);
+    m_open(pointIndex, nowMs);
+    return true;
+}
+
+void HnzPivotTmAggregator::flush(uint64_t nowMs, std::vector<Aggregate>& aggregates)
+{
+    size_t i = 0;
+    while (i < m_openPoints.size()) {
+        size_t pointIndex = m_openPoints[i];
+        Accumulator& point = m_points[pointIndex];
+        if (point.open && (nowMs < point.windowStartMs + m_windowMs)) {
+            i++;
+            continue;
+        }
+        if (point.open && (point.count > 0)) {
+            aggregates.push_back({pointIndex, m_aggregate(point)});
+            m_open(pointIndex, nowMs);
+            i++;
+            continue;
+        }
+        // Window without sample, or discarded: the point becomes idle
+        point.open = false;
+        point.listed = false;
+        m_openPoints[i] = m_openPoints.back();
+        m_openPoints.pop_back();
+    }
+}
+
+void HnzPivotTmAggregator::discard(size_t pointIndex)
+{
+    if (pointIndex < m_points.size()) {
+        m_points[pointIndex].open = false;
+        m_points[pointIndex].count = 0;
+    }
+}
+
+std::string HnzPivotTmAggregator::ModeStr(Mode mode)
+{
+    switch (mode) {
+        case Mode::NONE:
+            return "none";
+        case Mode::LAST:
+            return "last";
+        case Mode::MEAN:
+            return "mean";
+        case Mode::MIN:
+            return "min";
+        case Mode::MAX:
+            return "max";
+    }
+    return ""; //LCOV_EXCL_LINE
+}
+
+bool HnzPivotTmAggregator::modeFromStr(const std::string& modeStr, Mode& mode)
+{
+    for (Mode candidate : {Mode::NONE, Mode::LAST, Mode::MEAN, Mode::MIN, Mode::MAX}) {
+        if (modeStr == ModeStr(candidate)) {
+            mode = candidate;
+            return true;
+        }
+    }
+    return false;
+}
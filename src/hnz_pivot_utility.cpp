@@ -36,3 +36,32 @@ std::vector<std::string> HnzPivotUtility::split(const std::string& str, char sep
     }
     return elems;
 }
+
+void HnzPivotUtility::remapPointList(std::vector<size_t>& pointList, const std::vector<size_t>& pointIndexes,
+                                     size_t pointCount) {
+    size_t count = 0;
+    for (size_t pointIndex : pointList) {
+        if ((pointIndex < pointIndexes.size()) && (pointIndexes[pointIndex] < pointCount)) {
+            pointList[count++] = pointIndexes[pointIndex];
+        }
+    }
+    pointList.resize(count);
+}
+
+Datapoint* HnzPivotUtility::createDp(const std::string& name)
+{
+    auto datapoints = new std::vector<Datapoint*>;
+
+    DatapointValue dpv(datapoints, true);
+
+    return new Datapoint(name, dpv);
+}
+
+Datapoint* HnzPivotUtility::addElement(Datapoint* dp, const std::string& name)
+{
+    Datapoint* element = createDp(name);
+
+    dp->getData().getDpVec()->push_back(element);
+
+    return element;
+}
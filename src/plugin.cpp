@@ -92,6 +92,122 @@ static const char *default_config = QUOTE({
                 ]
             }
         })
+    },
+    "statistics_period": {
+        "description" : "Period in seconds at which conversion statistics are sent as a reading (0 to disable)",
+        "type" : "integer",
+        "displayName" : "Statistics period",
+        "order" : "2",
+        "default" : "0"
+    },
+    "config_cache": {
+        "description" : "Save the compiled exchanged data list in the Fledge data directory to skip its parsing on the next start",
+        "type" : "boolean",
+        "displayName" : "Exchanged data cache",
+        "order" : "3",
+        "default" : "false"
+    },
+    "async_ingest": {
+        "description" : "Queue the readings received and convert them in a dedicated thread, so that the caller does not wait for their conversion. Pivot commands are converted and forwarded right away, they are never queued",
+        "type" : "boolean",
+        "displayName" : "Asynchronous ingest",
+        "order" : "4",
+        "default" : "false"
+    },
+    "async_queue_depth": {
+        "description" : "Maximum number of reading sets waiting for conversion in asynchronous ingest",
+        "type" : "integer",
+        "displayName" : "Asynchronous queue depth",
+        "order" : "5",
+        "default" : "64"
+    },
+    "async_backpressure": {
+        "description" : "Behavior of asynchronous ingest when the queue is full: wait for a free place, drop the oldest or the newest reading set",
+        "type" : "enumeration",
+        "options" : ["block", "drop_oldest", "drop_newest"],
+        "displayName" : "Asynchronous queue full policy",
+        "order" : "6",
+        "default" : "block"
+    },
+    "command_ack_timeout": {
+        "description" : "Time in seconds after which a command without ACK is counted as timed out in the statistics",
+        "type" : "integer",
+        "displayName" : "Command ACK timeout",
+        "order" : "7",
+        "default" : "10"
+    },
+    "data_age_threshold": {
+        "description" : "Age in milliseconds of a TS (time between its RTU timestamp and its arrival) above which it is counted as late in the statistics",
+        "type" : "integer",
+        "displayName" : "Data age threshold",
+        "order" : "8",
+        "default" : "5000"
+    },
+    "chatter_max_transitions": {
+        "description" : "Maximum number of state changes of a TS within the chatter window, the next ones are suppressed until the TS calms down, its last state being forwarded then (0 to disable)",
+        "type" : "integer",
+        "displayName" : "Chatter maximum transitions",
+        "order" : "9",
+        "default" : "0"
+    },
+    "chatter_window": {
+        "description" : "Duration in milliseconds of the sliding window over which the state changes of a TS are counted, by their timestamp",
+        "type" : "integer",
+        "displayName" : "Chatter window",
+        "order" : "10",
+        "default" : "1000"
+    },
+    "tm_aggregation": {
+        "description" : "Value of a TM forwarded once per aggregation window instead of every sample: last, mean, minimum or maximum of the samples of the window (none to forward every sample). The first sample of an idle TM is forwarded immediately",
+        "type" : "enumeration",
+        "options" : ["none", "last", "mean", "min", "max"],
+        "displayName" : "TM aggregation",
+        "order" : "11",
+        "default" : "none"
+    },
+    "tm_aggregation_window": {
+        "description" : "Duration in milliseconds of the window over which the samples of a TM are aggregated",
+        "type" : "integer",
+        "displayName" : "TM aggregation window",
+        "order" : "12",
+        "default" : "60000"
+    },
+    "outdated_storm_ratio": {
+        "description" : "Percentage of the TS and TM of a station received outdated in the same batch (link lost) above which they are replaced by a single station quality event (0 to disable)",
+        "type" : "integer",
+        "displayName" : "Outdated storm ratio",
+        "order" : "13",
+        "default" : "0"
+    },
+    "command_dedup_window": {
+        "description" : "Time in milliseconds during which a pivot command identical to the previous one (same pivot ID and value) is dropped (0 to disable)",
+        "type" : "integer",
+        "displayName" : "Duplicate command window",
+        "order" : "14",
+        "default" : "0"
+    },
+    "output_profile": {
+        "description" : "Content of the pivot objects: all fields, or only the fields differing from their pivot model default (ComingFrom, good quality, genuine and good timestamp)",
+        "type" : "enumeration",
+        "options" : ["full", "compact"],
+        "displayName" : "Output profile",
+        "order" : "15",
+        "default" : "full"
+    },
+    "output_format": {
+        "description" : "Form of the pivot objects: datapoint tree (PIVOT), or JSON string rendered directly from precomputed fragments of each point (PIVOT_JSON)",
+        "type" : "enumeration",
+        "options" : ["datapoint", "json"],
+        "displayName" : "Output format",
+        "order" : "16",
+        "default" : "datapoint"
+    },
+    "data_age_flag": {
+        "description" : "Flag the TS older than the data age threshold as old data (DetailQuality oldData) in their pivot quality",
+        "type" : "boolean",
+        "displayName" : "Flag late data",
+        "order" : "17",
+        "default" : "false"
     }
 });
 
@@ -0,0 +1,234 @@
+#include <benchmark/benchmark.h>
+#include <cstdio>
+#include <map>
+#include <memory>
+#include <rapidjson/document.h>
+
+#include "hnz_alloc_counter.hpp"
+#include "hnz_pivot_config_cache.hpp"
+#include "hnz_pivot_filter_config.hpp"
+
+/*
+ * exchanged_data of a multi-protocol substation: each point has an iec104, a tase2 and an hnzip entry
+ */
+static const std::string& multiProtocolExchangedData(int pointCount)
+{
+    static std::map<int, std::string> configs;
+    std::string& json = configs[pointCount];
+    if (!json.empty()) {
+        return json;
+    }
+    static const char* typeIds[] = {"TS", "TM", "TC", "TVC"};
+    static const char* pivotTypes[] = {"SpsTyp", "MvTyp", "SpcTyp", "IncTyp"};
+    json = "{\"exchanged_data\":{\"name\":\"BENCH\",\"version\":\"1.0\",\"datapoints\":[";
+    for (int i = 0; i < pointCount; i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        std::string index = std::to_string(i);
+        json += "{\"label\":\"P" + index + "\",\"pivot_id\":\"ID" + std::to_string(100000 + i) + "\",\"pivot_type\":\"" +
+                pivotTypes[i % 4] + "\",\"protocols\":["
+                "{\"name\":\"iec104\",\"address\":\"45-" + index + "\",\"typeid\":\"M_SP_TB_1\"},"
+                "{\"name\":\"tase2\",\"address\":\"S_" + index + "\",\"typeid\":\"Data_StateQTimeTagExtended\"},"
+                "{\"name\":\"hnzip\",\"address\":\"" + index + "\",\"typeid\":\"" + typeIds[i % 4] + "\"}]}";
+    }
+    json += "]}}";
+    return json;
+}
+
+/*
+ * Reference DOM import: parse the whole document, then walk it with HasMember/operator[] lookups
+ */
+static size_t importWithDom(const std::string& exchangeConfig)
+{
+    std::map<std::string, std::shared_ptr<HNZPivotDataPoint>> exchangeDefinitions;
+    std::map<std::string, std::string> pivotIdLookup;
+    rapidjson::Document document;
+    if (document.Parse(exchangeConfig.c_str()).HasParseError()) {
+        return 0;
+    }
+    const rapidjson::Value& info = document[JSON_EXCHANGED_DATA_NAME];
+    for (const rapidjson::Value& msg : info[DATAPOINTS].GetArray()) {
+        std::string label = msg.HasMember(LABEL) ? msg[LABEL].GetString() : "";
+        std::string pivotId = msg.HasMember(PIVOT_ID) ? msg[PIVOT_ID].GetString() : "";
+        std::string pivotType = msg.HasMember(PIVOT_TYPE) ? msg[PIVOT_TYPE].GetString() : "";
+        for (const rapidjson::Value& protocol : msg[PROTOCOLS].GetArray()) {
+            if (std::string(protocol[JSON_NAME].GetString()) != HNZ_NAME) {
+                continue;
+            }
+            std::string msgCode = protocol.HasMember(MESSAGE_CODE) ? protocol[MESSAGE_CODE].GetString() : "";
+            auto address = static_cast<unsigned int>(std::stoul(protocol[MESSAGE_ADDRESS].GetString()));
+            exchangeDefinitions[pivotId] = std::make_shared<HNZPivotDataPoint>(label, pivotId, pivotType, msgCode, address);
+            pivotIdLookup[msgCode + "-" + std::to_string(address)] = pivotId;
+        }
+    }
+    return exchangeDefinitions.size();
+}
+
+static void reportCounters(benchmark::State& state, int pointCount, const HnzAllocStats& stats)
+{
+    state.SetItemsProcessed(state.iterations() * pointCount);
+    state.SetBytesProcessed(state.iterations() * static_cast<int64_t>(multiProtocolExchangedData(pointCount).size()));
+    state.counters["peak_heap_MB"] = static_cast<double>(stats.peakBytes) / (1024 * 1024);
+    // malloc calls include the ones made by operator new, they are not counted without glibc
+    uint64_t allocations = stats.mallocs > 0 ? stats.mallocs : stats.news;
+    state.counters["allocs/point"] = static_cast<double>(allocations) / pointCount;
+}
+
+/*
+ * Heap peak and allocations are measured on the first iteration only
+ */
+static void BM_ImportExchangeConfig_SAX(benchmark::State& state)
+{
+    auto pointCount = static_cast<int>(state.range(0));
+    const std::string& exchangedData = multiProtocolExchangedData(pointCount);
+    HnzAllocStats stats;
+    bool first = true;
+    for (auto _ : state) {
+        HNZPivotConfig config;
+        if (first) {
+            HnzAllocCounter::start();
+        }
+        config.importExchangeConfig(exchangedData);
+        if (first) {
+            stats = HnzAllocCounter::stop();
+            first = false;
+        }
+        benchmark::DoNotOptimize(config.getExchangeDefinitions().size());
+    }
+    reportCounters(state, pointCount, stats);
+}
+
+static void BM_ImportExchangeConfig_DOM(benchmark::State& state)
+{
+    auto pointCount = static_cast<int>(state.range(0));
+    const std::string& exchangedData = multiProtocolExchangedData(pointCount);
+    HnzAllocStats stats;
+    bool first = true;
+    for (auto _ : state) {
+        if (first) {
+            HnzAllocCounter::start();
+        }
+        benchmark::DoNotOptimize(importWithDom(exchangedData));
+        if (first) {
+            stats = HnzAllocCounter::stop();
+            first = false;
+        }
+    }
+    reportCounters(state, pointCount, stats);
+}
+
+/*
+ * Restart with an up to date cache file: the JSON is only hashed, the tables are loaded from the file
+ */
+static void BM_ImportExchangeConfig_Cache(benchmark::State& state)
+{
+    auto pointCount = static_cast<int>(state.range(0));
+    const std::string& exchangedData = multiProtocolExchangedData(pointCount);
+    HnzPivotConfigCache cache("/tmp/hnz_pivot_bench_" + std::to_string(pointCount) + ".cache");
+    {
+        HNZPivotConfig config;
+        cache.importExchangeConfig(config, exchangedData);
+    }
+    HnzAllocStats stats;
+    bool first = true;
+    for (auto _ : state) {
+        HNZPivotConfig config;
+        if (first) {
+            HnzAllocCounter::start();
+        }
+        bool loaded = cache.importExchangeConfig(config, exchangedData);
+        if (first) {
+            stats = HnzAllocCounter::stop();
+            first = false;
+        }
+        if (!loaded) {
+            state.SkipWithError("Cache file not loaded");
+            break;
+        }
+        benchmark::DoNotOptimize(config.getExchangeDefinitions().size());
+    }
+    reportCounters(state, pointCount, stats);
+    remove(cache.getPath().c_str());
+}
+
+/*
+ * Reconfigure where a single label changes: only the application of the new configuration to the current one
+ * is measured, the import of the new configuration is excluded
+ */
+static void BM_ApplyExchangeConfig_OneChange(benchmark::State& state)
+{
+    auto pointCount = static_cast<int>(state.range(0));
+    std::string exchangedData = multiProtocolExchangedData(pointCount);
+    std::string renamedExchangedData = exchangedData;
+    renamedExchangedData.replace(renamedExchangedData.find("\"label\":\"P0\""), 12, "\"label\":\"Q0\"");
+    HNZPivotConfig config;
+    config.importExchangeConfig(exchangedData);
+    bool renamed = false;
+    for (auto _ : state) {
+        state.PauseTiming();
+        HNZPivotConfig newConfig;
+        newConfig.importExchangeConfig(renamed ? exchangedData : renamedExchangedData);
+        renamed = !renamed;
+        state.ResumeTiming();
+        HNZPivotConfig::ExchangeChanges changes = config.applyExchangeConfig(std::move(newConfig));
+        benchmark::DoNotOptimize(changes.changed);
+    }
+    state.SetItemsProcessed(state.iterations() * pointCount);
+}
+
+/*
+ * Reconfigure where a single label changes, as done by the filter: the new configuration is imported from the JSON
+ * and the current one, to compare with BM_ImportExchangeConfig_SAX
+ */
+static void BM_ImportExchangeConfig_OneChange(benchmark::State& state)
+{
+    auto pointCount = static_cast<int>(state.range(0));
+    std::string exchangedData = multiProtocolExchangedData(pointCount);
+    std::string renamedExchangedData = exchangedData;
+    renamedExchangedData.replace(renamedExchangedData.find("\"label\":\"P0\""), 12, "\"label\":\"Q0\"");
+    HNZPivotConfig config;
+    config.importExchangeConfig(exchangedData);
+    for (auto _ : state) {
+        HNZPivotConfig newConfig;
+        newConfig.importExchangeConfig(renamedExchangedData, config);
+        benchmark::DoNotOptimize(newConfig.getPointCount());
+    }
+    state.SetItemsProcessed(state.iterations() * pointCount);
+}
+
+/*
+ * Lookup of the pivot id of data objects on a multi-drop link: 100 points per station, the cost of a lookup
+ * must not depend on the number of stations
+ */
+static void BM_FindPivotId_Stations(benchmark::State& state)
+{
+    auto stationCount = static_cast<unsigned int>(state.range(0));
+    const unsigned int pointsPerStation = 100;
+    std::string json = "{\"exchanged_data\":{\"name\":\"BENCH\",\"version\":\"1.0\",\"datapoints\":[";
+    for (unsigned int station = 0; station < stationCount; station++) {
+        for (unsigned int address = 0; address < pointsPerStation; address++) {
+            std::string id = std::to_string(station * pointsPerStation + address);
+            json += std::string(json.back() == '[' ? "" : ",") + "{\"label\":\"P" + id + "\",\"pivot_id\":\"ID" + id +
+                    "\",\"pivot_type\":\"SpsTyp\",\"protocols\":[{\"name\":\"hnzip\",\"station\":\"" + std::to_string(station) +
+                    "\",\"address\":\"" + std::to_string(address) + "\",\"typeid\":\"TS\"}]}";
+        }
+    }
+    json += "]}}";
+    HNZPivotConfig config;
+    config.importExchangeConfig(json);
+    const std::string typeId = "TS";
+    unsigned int i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(config.findPivotId(i % stationCount, typeId, (i / stationCount) % pointsPerStation).size());
+        i += 7;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_ImportExchangeConfig_SAX)->ArgName("points")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImportExchangeConfig_DOM)->ArgName("points")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImportExchangeConfig_Cache)->ArgName("points")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ApplyExchangeConfig_OneChange)->ArgName("points")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_ImportExchangeConfig_OneChange)->ArgName("points")->Arg(1000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_FindPivotId_Stations)->ArgName("stations")->Arg(1)->Arg(10)->Arg(100)->Arg(500);
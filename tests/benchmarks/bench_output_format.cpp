@@ -0,0 +1,77 @@
+#include <benchmark/benchmark.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+// Size of the serialization of the last reading forwarded by the filter
+static size_t lastJsonSize = 0;
+
+/*
+ * Serialize every reading forwarded, as the next service in the pipeline would
+ */
+static void serializeOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    for (Reading* reading : readingSet->getAllReadings()) {
+        std::string json = reading->toJSON();
+        lastJsonSize = json.size();
+        benchmark::DoNotOptimize(json);
+    }
+    delete readingSet;
+}
+
+static std::string tsCeJson(int address)
+{
+    return "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":" + std::to_string(address) + ",\"do_value\":1,"
+           "\"do_valid\":0,\"do_cg\":0,\"do_outdated\":0,\"do_ts\":1685019425432,\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+}
+
+static std::string tmJson(int address)
+{
+    return "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":" + std::to_string(address) + ",\"do_value\":42,"
+           "\"do_valid\":0,\"do_an\":\"TMA\",\"do_outdated\":0}}";
+}
+
+/*
+ * Convert and serialize batches of 100 messages of different points with the given output format
+ */
+static void BM_OutputFormat(benchmark::State& state, const std::string& format, const std::string& typeId)
+{
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("output_format", format);
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(400));
+    PLUGIN_HANDLE filter = plugin_init(&config, nullptr, serializeOutputStream);
+
+    // Points of HnzTrafficGenerator::generateExchangedData are TS, TM, TC and TVC by address modulo 4
+    std::vector<std::string> jsons;
+    for (int i = 0; i < 100; i++) {
+        jsons.push_back(typeId == "TS" ? tsCeJson(i * 4) : tmJson(i * 4 + 1));
+    }
+
+    for (auto _ : state) {
+        plugin_ingest(filter, HnzTestReadings::createReadingSet("P", jsons));
+    }
+    state.SetItemsProcessed(state.iterations() * static_cast<int64_t>(jsons.size()));
+    state.counters["json_bytes"] = static_cast<double>(lastJsonSize);
+
+    plugin_shutdown(filter);
+}
+
+BENCHMARK_CAPTURE(BM_OutputFormat, TSCE_datapoint, std::string("datapoint"), std::string("TS"));
+BENCHMARK_CAPTURE(BM_OutputFormat, TSCE_json, std::string("json"), std::string("TS"));
+BENCHMARK_CAPTURE(BM_OutputFormat, TM_datapoint, std::string("datapoint"), std::string("TM"));
+BENCHMARK_CAPTURE(BM_OutputFormat, TM_json, std::string("json"), std::string("TM"));
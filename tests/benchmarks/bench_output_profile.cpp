@@ -0,0 +1,88 @@
+#include <benchmark/benchmark.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+// Size of the last message forwarded by the filter
+static size_t lastNodeCount = 0;
+static size_t lastJsonSize = 0;
+
+static size_t countNodes(Datapoint* dp)
+{
+    size_t count = 1;
+    DatapointValue& dpv = dp->getData();
+    if ((dpv.getType() == DatapointValue::T_DP_DICT) || (dpv.getType() == DatapointValue::T_DP_LIST)) {
+        for (Datapoint* child : *dpv.getDpVec()) {
+            count += countNodes(child);
+        }
+    }
+    return count;
+}
+
+static void profileOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    for (Reading* reading : readingSet->getAllReadings()) {
+        lastNodeCount = 0;
+        lastJsonSize = 0;
+        for (Datapoint* dp : reading->getReadingData()) {
+            lastNodeCount += countNodes(dp);
+            lastJsonSize += dp->toJSONProperty().size();
+        }
+    }
+    delete readingSet;
+}
+
+/*
+ * Messages of the points configured by HnzTrafficGenerator::generateExchangedData(4)
+ */
+static const char* tsCeJson = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":1,\"do_valid\":0,"
+                              "\"do_cg\":0,\"do_outdated\":0,\"do_ts\":1685019425432,\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+static const char* tsCgJson = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":1,\"do_valid\":0,"
+                              "\"do_cg\":1,\"do_outdated\":0}}";
+static const char* tmJson = "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,\"do_value\":42,\"do_valid\":0,"
+                            "\"do_an\":\"TMA\",\"do_outdated\":0}}";
+static const char* tcAckJson = "{\"data_object\":{\"do_type\":\"TC\",\"do_station\":12,\"do_addr\":2,\"do_valid\":0}}";
+
+/*
+ * Convert one message at a time with the given output profile, and report the number of datapoints of the
+ * converted message (tree nodes) and the size of its JSON serialization
+ */
+static void BM_OutputProfile(benchmark::State& state, const std::string& profile, const std::string& json)
+{
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("output_profile", profile);
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(4));
+    PLUGIN_HANDLE filter = plugin_init(&config, nullptr, profileOutputStream);
+
+    for (auto _ : state) {
+        plugin_ingest(filter, HnzTestReadings::createReadingSet("P", {json}));
+    }
+    state.counters["nodes"] = static_cast<double>(lastNodeCount);
+    state.counters["json_bytes"] = static_cast<double>(lastJsonSize);
+
+    plugin_shutdown(filter);
+}
+
+BENCHMARK_CAPTURE(BM_OutputProfile, TSCE_full, std::string("full"), std::string(tsCeJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TSCE_compact, std::string("compact"), std::string(tsCeJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TSCG_full, std::string("full"), std::string(tsCgJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TSCG_compact, std::string("compact"), std::string(tsCgJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TM_full, std::string("full"), std::string(tmJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TM_compact, std::string("compact"), std::string(tmJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TCACK_full, std::string("full"), std::string(tcAckJson));
+BENCHMARK_CAPTURE(BM_OutputProfile, TCACK_compact, std::string("compact"), std::string(tcAckJson));
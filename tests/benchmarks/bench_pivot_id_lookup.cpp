@@ -0,0 +1,105 @@
+#include <benchmark/benchmark.h>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hnz_pivot_perfect_hash.hpp"
+
+/*
+ * Lookup of a pivot id among the configured ones, as done for every reading and every command.
+ * Pivot ids of a substation share a long prefix, which is the worst case for std::map comparisons.
+ */
+static std::vector<std::string> generatePivotIds(int count)
+{
+    std::vector<std::string> pivotIds;
+    pivotIds.reserve(count);
+    for (int i = 0; i < count; i++) {
+        pivotIds.push_back("ID_SUBSTATION_BAY_" + std::to_string(1000000 + i));
+    }
+    return pivotIds;
+}
+
+static std::vector<const std::string*> keysOf(const std::vector<std::string>& pivotIds)
+{
+    std::vector<const std::string*> keys;
+    keys.reserve(pivotIds.size());
+    for (const auto& pivotId : pivotIds) {
+        keys.push_back(&pivotId);
+    }
+    return keys;
+}
+
+// Lookups go through the ids in a scattered order so that consecutive lookups do not share cache lines
+static size_t nextLookup(size_t i, size_t count)
+{
+    return (i + 7919) % count;
+}
+
+static void BM_PivotIdLookup_Map(benchmark::State& state)
+{
+    std::vector<std::string> pivotIds = generatePivotIds(static_cast<int>(state.range(0)));
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < pivotIds.size(); i++) {
+        index.emplace(pivotIds[i], i);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.find(pivotIds[i])->second);
+        i = nextLookup(i, pivotIds.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_PivotIdLookup_UnorderedMap(benchmark::State& state)
+{
+    std::vector<std::string> pivotIds = generatePivotIds(static_cast<int>(state.range(0)));
+    std::unordered_map<std::string, size_t> index;
+    for (size_t i = 0; i < pivotIds.size(); i++) {
+        index.emplace(pivotIds[i], i);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(index.find(pivotIds[i])->second);
+        i = nextLookup(i, pivotIds.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_PivotIdLookup_PerfectHash(benchmark::State& state)
+{
+    std::vector<std::string> pivotIds = generatePivotIds(static_cast<int>(state.range(0)));
+    HnzPivotPerfectHash index;
+    if (!index.build(keysOf(pivotIds))) {
+        state.SkipWithError("Could not build the perfect hash");
+        return;
+    }
+    // The owner of the keys keeps the key of each slot to check the lookups, as HNZPivotConfig does
+    std::vector<const std::string*> keysBySlot(index.size());
+    for (const auto& pivotId : pivotIds) {
+        keysBySlot[index.getSlot(pivotId)] = &pivotId;
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        size_t slot = index.getSlot(pivotIds[i]);
+        benchmark::DoNotOptimize(*keysBySlot[slot] == pivotIds[i]);
+        i = nextLookup(i, pivotIds.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+static void BM_PivotIdLookup_PerfectHashBuild(benchmark::State& state)
+{
+    std::vector<std::string> pivotIds = generatePivotIds(static_cast<int>(state.range(0)));
+    std::vector<const std::string*> keys = keysOf(pivotIds);
+    for (auto _ : state) {
+        HnzPivotPerfectHash index;
+        benchmark::DoNotOptimize(index.build(keys));
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+BENCHMARK(BM_PivotIdLookup_Map)->ArgName("ids")->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_PivotIdLookup_UnorderedMap)->ArgName("ids")->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_PivotIdLookup_PerfectHash)->ArgName("ids")->Arg(1000)->Arg(10000)->Arg(100000);
+BENCHMARK(BM_PivotIdLookup_PerfectHashBuild)->ArgName("ids")->Arg(1000)->Arg(10000)->Arg(100000)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,270 @@
+#include <benchmark/benchmark.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+#include <chrono>
+#include <map>
+#include <memory>
+
+#include "hnz_alloc_counter.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+/*
+ * Kind of points configured by HnzTrafficGenerator::generateExchangedData, the point of index i has the kind
+ * i % KIND_COUNT and its HNZ address is i
+ */
+enum PointKind {
+    KIND_TS_SPS,
+    KIND_TM,
+    KIND_TC_SPC,
+    KIND_TVC_INC,
+    KIND_COUNT
+};
+
+static const std::vector<int64_t> readingSetSizes = {1, 10, 100, 1000, 10000};
+static const std::vector<int64_t> exchangedDataSizes = {10, 1000, 50000};
+
+// Reading sets forwarded by the filter since the last call to deleteOutputs, and time the first one was received
+static std::vector<ReadingSet*> outputs;
+static std::chrono::steady_clock::time_point firstOutputTime;
+
+static void benchOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    if (outputs.empty()) {
+        firstOutputTime = std::chrono::steady_clock::now();
+    }
+    outputs.push_back(readingSet);
+}
+
+static void deleteOutputs()
+{
+    for (ReadingSet* readingSet : outputs) {
+        delete readingSet;
+    }
+    outputs.clear();
+}
+
+static std::string pivotId(int index)
+{
+    return "ID" + std::to_string(100000 + index);
+}
+
+/*
+ * Filter instances are expensive to create for large exchanged_data, so they are shared between benchmarks
+ */
+static PLUGIN_HANDLE getFilter(int pointCount)
+{
+    static std::map<int, PLUGIN_HANDLE> filters;
+    if (filters.count(pointCount) == 0) {
+        ConfigCategory config("hnztopivot", plugin_info()->config);
+        config.setItemsValueFromDefault();
+        config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(pointCount));
+        filters[pointCount] = plugin_init(&config, nullptr, benchOutputStream);
+    }
+    return filters[pointCount];
+}
+
+/*
+ * Index of the n-th point of the given kind, wrapping around the configured points
+ */
+static int pointIndex(PointKind kind, int n, int pointCount)
+{
+    int pointsOfKind = (pointCount - kind + KIND_COUNT - 1) / KIND_COUNT;
+    return (n % pointsOfKind) * KIND_COUNT + kind;
+}
+
+static Reading* parseReading(const std::string& assetName, const std::string& json)
+{
+    return HnzTestReadings::createReading(assetName, {json});
+}
+
+static std::string tsJson(int address, bool cg)
+{
+    std::string json = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":" + std::to_string(address) +
+                       ",\"do_value\":1,\"do_valid\":0,\"do_outdated\":0";
+    if (cg) {
+        return json + ",\"do_cg\":1}}";
+    }
+    return json + ",\"do_cg\":0,\"do_ts\":1685019425432,\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+}
+
+static std::string tmJson(int address, const std::string& an, long value)
+{
+    return "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":" + std::to_string(address) +
+           ",\"do_value\":" + std::to_string(value) + ",\"do_valid\":0,\"do_an\":\"" + an + "\",\"do_outdated\":0}}";
+}
+
+static std::string ackJson(const std::string& type, int address)
+{
+    return "{\"data_object\":{\"do_type\":\"" + type + "\",\"do_station\":12,\"do_addr\":" + std::to_string(address) +
+           ",\"do_valid\":0}}";
+}
+
+static std::string pivotCommandJson(int index)
+{
+    return "{\"PIVOT\":{\"GTIC\":{\"SpcTyp\":{\"q\":{\"Source\":\"process\",\"Validity\":\"good\"},"
+           "\"t\":{\"FractionOfSecond\":9529458,\"SecondSinceEpoch\":1669714185},\"ctlVal\":1},"
+           "\"Identifier\":\"" + pivotId(index) + "\"}}}";
+}
+
+static std::string passthroughJson()
+{
+    return "{\"south_event\":{\"connx_status\":\"started\",\"gi_status\":\"idle\"}}";
+}
+
+enum class Scenario {
+    TS_CE,
+    TS_CG,
+    TM_TMA,
+    TM_TM8,
+    TM_TM16,
+    TC_ACK,
+    TVC_ACK,
+    PIVOT_COMMAND,
+    PASSTHROUGH
+};
+
+static Reading* createReading(Scenario scenario, int n, int pointCount)
+{
+    switch (scenario) {
+        case Scenario::TS_CE:
+            return parseReading("TS", tsJson(pointIndex(KIND_TS_SPS, n, pointCount), false));
+        case Scenario::TS_CG:
+            return parseReading("TS", tsJson(pointIndex(KIND_TS_SPS, n, pointCount), true));
+        case Scenario::TM_TMA:
+            return parseReading("TM", tmJson(pointIndex(KIND_TM, n, pointCount), "TMA", -42));
+        case Scenario::TM_TM8:
+            return parseReading("TM", tmJson(pointIndex(KIND_TM, n, pointCount), "TM8", 200));
+        case Scenario::TM_TM16:
+            return parseReading("TM", tmJson(pointIndex(KIND_TM, n, pointCount), "TM16", -12345));
+        case Scenario::TC_ACK:
+            return parseReading("TC", ackJson("TC", pointIndex(KIND_TC_SPC, n, pointCount)));
+        case Scenario::TVC_ACK:
+            return parseReading("TVC", ackJson("TVC", pointIndex(KIND_TVC_INC, n, pointCount)));
+        case Scenario::PIVOT_COMMAND:
+            return parseReading("PivotCommand", pivotCommandJson(pointIndex(KIND_TC_SPC, n, pointCount)));
+        case Scenario::PASSTHROUGH:
+            return parseReading("CONNECTION-1", passthroughJson());
+    }
+    return nullptr;
+}
+
+/*
+ * Measure HNZPivotFilter::ingest on reading sets of state.range(0) readings,
+ * with an exchanged_data of state.range(1) points.
+ */
+static void BM_Ingest(benchmark::State& state, Scenario scenario)
+{
+    auto readingCount = static_cast<int>(state.range(0));
+    auto pointCount = static_cast<int>(state.range(1));
+    PLUGIN_HANDLE filter = getFilter(pointCount);
+
+    // Build the template readings once, then copy them for each iteration
+    std::vector<std::unique_ptr<Reading>> templates;
+    for (int i = 0; i < readingCount; i++) {
+        templates.emplace_back(createReading(scenario, i, pointCount));
+    }
+
+    uint64_t allocations = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto readings = new std::vector<Reading*>();
+        readings->reserve(readingCount);
+        for (const auto& reading : templates) {
+            readings->push_back(new Reading(*reading));
+        }
+        auto readingSet = new ReadingSet(readings);
+        delete readings;
+        HnzAllocCounter::start();
+        state.ResumeTiming();
+
+        plugin_ingest(filter, readingSet);
+
+        state.PauseTiming();
+        allocations += HnzAllocCounter::stop().news;
+        deleteOutputs();
+        state.ResumeTiming();
+    }
+
+    auto processed = static_cast<double>(state.iterations()) * readingCount;
+    state.SetItemsProcessed(static_cast<int64_t>(processed));
+    state.counters["readings/s"] = benchmark::Counter(processed, benchmark::Counter::kIsRate);
+    state.counters["s/reading"] = benchmark::Counter(processed, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+    state.counters["allocs/reading"] = benchmark::Counter(static_cast<double>(allocations) / processed);
+}
+
+#define HNZ_PIVOT_BENCHMARK(name, scenario) \
+    BENCHMARK_CAPTURE(BM_Ingest, name, scenario) \
+        ->ArgNames({"readings", "points"}) \
+        ->ArgsProduct({readingSetSizes, exchangedDataSizes}) \
+        ->Unit(benchmark::kMicrosecond)
+
+HNZ_PIVOT_BENCHMARK(TS_CE, Scenario::TS_CE);
+HNZ_PIVOT_BENCHMARK(TS_CG, Scenario::TS_CG);
+HNZ_PIVOT_BENCHMARK(TM_TMA, Scenario::TM_TMA);
+HNZ_PIVOT_BENCHMARK(TM_TM8, Scenario::TM_TM8);
+HNZ_PIVOT_BENCHMARK(TM_TM16, Scenario::TM_TM16);
+HNZ_PIVOT_BENCHMARK(TC_ACK, Scenario::TC_ACK);
+HNZ_PIVOT_BENCHMARK(TVC_ACK, Scenario::TVC_ACK);
+HNZ_PIVOT_BENCHMARK(PivotCommand, Scenario::PIVOT_COMMAND);
+HNZ_PIVOT_BENCHMARK(Passthrough, Scenario::PASSTHROUGH);
+
+/*
+ * Measure the time until a pivot command is forwarded when it is received at the end of a reading set
+ * holding state.range(0) TS readings of a GI, with an exchanged_data of 1000 points.
+ * The time of the whole ingest grows with the GI, while the command is forwarded ahead of the GI so that the
+ * command_latency counter should not depend on its size.
+ */
+static void BM_CommandDuringGI(benchmark::State& state)
+{
+    auto giCount = static_cast<int>(state.range(0));
+    const int pointCount = 1000;
+    PLUGIN_HANDLE filter = getFilter(pointCount);
+
+    std::vector<std::unique_ptr<Reading>> templates;
+    for (int i = 0; i < giCount; i++) {
+        templates.emplace_back(createReading(Scenario::TS_CG, i, pointCount));
+    }
+    templates.emplace_back(createReading(Scenario::PIVOT_COMMAND, 0, pointCount));
+
+    double commandLatency = 0;
+    for (auto _ : state) {
+        state.PauseTiming();
+        auto readings = new std::vector<Reading*>();
+        readings->reserve(templates.size());
+        for (const auto& reading : templates) {
+            readings->push_back(new Reading(*reading));
+        }
+        auto readingSet = new ReadingSet(readings);
+        delete readings;
+        state.ResumeTiming();
+        auto start = std::chrono::steady_clock::now();
+
+        plugin_ingest(filter, readingSet);
+
+        state.PauseTiming();
+        commandLatency += std::chrono::duration<double>(firstOutputTime - start).count();
+        deleteOutputs();
+        state.ResumeTiming();
+    }
+
+    state.counters["command_latency"] = benchmark::Counter(commandLatency, benchmark::Counter::kAvgIterations);
+}
+
+BENCHMARK(BM_CommandDuringGI)
+    ->ArgName("gi_readings")
+    ->Arg(0)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,108 @@
+#include <benchmark/benchmark.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+static void deleteOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    delete readingSet;
+}
+
+/*
+ * Realistic mixes of traffic sent by the HNZ south plugin
+ */
+static HnzTrafficProfile steadyStateProfile()
+{
+    HnzTrafficProfile profile;
+    profile.tsWeight = 4;
+    profile.tmWeight = 6;
+    profile.tcWeight = 0.1;
+    profile.tvcWeight = 0.1;
+    profile.invalidRate = 0.01;
+    profile.outdatedRate = 0.01;
+    profile.tsCRate = 0.01;
+    profile.tsSRate = 0.01;
+    profile.unknownAddressRate = 0.001;
+    return profile;
+}
+
+static HnzTrafficProfile generalInterrogationProfile()
+{
+    HnzTrafficProfile profile;
+    profile.tsWeight = 1;
+    profile.tmWeight = 0;
+    profile.cgRatio = 1.0;
+    return profile;
+}
+
+static HnzTrafficProfile linkLossProfile()
+{
+    HnzTrafficProfile profile;
+    profile.invalidRate = 1.0;
+    profile.outdatedRate = 1.0;
+    return profile;
+}
+
+static HnzTrafficProfile unknownAddressProfile()
+{
+    HnzTrafficProfile profile;
+    profile.unknownAddressRate = 0.5;
+    return profile;
+}
+
+/*
+ * Feed plugin_ingest with generated batches of state.range(0) readings, for an exchanged_data
+ * of state.range(1) points, and report the sustained throughput. Batches are generated outside
+ * of the measured time.
+ */
+static void BM_Traffic(benchmark::State& state, HnzTrafficProfile profile)
+{
+    auto pointCount = static_cast<int>(state.range(1));
+    profile.batchSize = static_cast<unsigned int>(state.range(0));
+    std::string exchangedData = HnzTrafficGenerator::generateExchangedData(pointCount);
+    HnzTrafficGenerator generator(exchangedData, profile);
+
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("exchanged_data", exchangedData);
+    PLUGIN_HANDLE filter = plugin_init(&config, nullptr, deleteOutputStream);
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        ReadingSet* readingSet = generator.nextBatch();
+        state.ResumeTiming();
+
+        plugin_ingest(filter, readingSet);
+    }
+
+    plugin_shutdown(filter);
+
+    auto processed = static_cast<double>(state.iterations()) * profile.batchSize;
+    state.SetItemsProcessed(static_cast<int64_t>(processed));
+    state.counters["readings/s"] = benchmark::Counter(processed, benchmark::Counter::kIsRate);
+    state.counters["s/reading"] = benchmark::Counter(processed, benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+
+#define HNZ_TRAFFIC_BENCHMARK(name, profile) \
+    BENCHMARK_CAPTURE(BM_Traffic, name, profile) \
+        ->ArgNames({"batch", "points"}) \
+        ->ArgsProduct({{100, 1000}, {1000, 50000}}) \
+        ->Unit(benchmark::kMillisecond)
+
+HNZ_TRAFFIC_BENCHMARK(SteadyState, steadyStateProfile());
+HNZ_TRAFFIC_BENCHMARK(GeneralInterrogation, generalInterrogationProfile());
+HNZ_TRAFFIC_BENCHMARK(LinkLoss, linkLossProfile());
+HNZ_TRAFFIC_BENCHMARK(UnknownAddress, unknownAddressProfile());
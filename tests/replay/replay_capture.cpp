@@ -0,0 +1,109 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <plugin_api.h>
+#include <config_category.h>
+
+#include "hnz_reading_replay.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+};
+
+/*
+ * Replay a capture of south readings through the filter and report throughput and latency:
+ *   ReplayCapture <capture.jsonl> --exchanged-data <file.json> [--paced] [--speed <factor>] [--batch <size>]
+ *                 [--golden <file.jsonl> [--update-golden]]
+ * Exit code is 1 if the output differs from the golden file.
+ */
+static void usage(const char* program)
+{
+    std::cerr << "Usage: " << program << " <capture.jsonl> --exchanged-data <file.json> [--paced] [--speed <factor>]"
+              << " [--batch <size>] [--golden <file.jsonl> [--update-golden]]" << std::endl;
+}
+
+static std::string readFile(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    return content.str();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        usage(argv[0]);
+        return 2;
+    }
+    std::string capturePath = argv[1];
+    std::string exchangedDataPath;
+    std::string goldenPath;
+    bool updateGolden = false;
+    HnzReplayOptions options;
+    for (int i = 2; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--exchanged-data") == 0 && hasValue) {
+            exchangedDataPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--paced") == 0) {
+            options.paced = true;
+        }
+        else if (strcmp(argv[i], "--speed") == 0 && hasValue) {
+            options.speed = atof(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--batch") == 0 && hasValue) {
+            options.batchSize = static_cast<unsigned int>(atoi(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--golden") == 0 && hasValue) {
+            goldenPath = argv[++i];
+        }
+        else if (strcmp(argv[i], "--update-golden") == 0) {
+            updateGolden = true;
+        }
+        else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+
+    try {
+        HnzReadingReplay replay(HnzReadingReplay::loadLines(capturePath));
+
+        ConfigCategory config("hnztopivot", plugin_info()->config);
+        config.setItemsValueFromDefault();
+        if (!exchangedDataPath.empty()) {
+            config.setValue("exchanged_data", readFile(exchangedDataPath));
+        }
+
+        HnzReplayReport report = replay.run(&config, options);
+        std::cout << report.toString() << std::endl;
+
+        if (!goldenPath.empty()) {
+            if (updateGolden) {
+                HnzReadingReplay::saveLines(goldenPath, report.output);
+                std::cout << "Golden file updated: " << goldenPath << std::endl;
+            }
+            else {
+                auto differences = HnzReadingReplay::diff(HnzReadingReplay::loadLines(goldenPath), report.output);
+                for (const std::string& difference : differences) {
+                    std::cout << difference << std::endl;
+                }
+                std::cout << differences.size() << " difference(s) with " << goldenPath << std::endl;
+                if (!differences.empty()) {
+                    return 1;
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    return 0;
+}
@@ -0,0 +1,240 @@
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <config_category.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+
+#include "hnz_alloc_counter.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+static void deleteOutputStream(OUTPUT_HANDLE * handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    delete readingSet;
+}
+
+/*
+ * Allocation budgets of a single plugin_ingest call converting one message. They lock in the current
+ * allocation count: lower them when an optimization removes allocations, never raise them silently.
+ * Budgets include the allocations made by the UNIT_TEST logs and by the Fledge reading classes,
+ * with about 15% of headroom over the measured values.
+ */
+class PivotHNZPluginAllocationBudget : public testing::Test
+{
+protected:
+    PLUGIN_HANDLE handle = nullptr;
+
+    // Points P0 (TS, address 0), P1 (TM, address 1), P2 (TC, address 2) and P3 (TVC, address 3)
+    void SetUp() override
+    {
+        ConfigCategory config("hnztopivot", plugin_info()->config);
+        config.setItemsValueFromDefault();
+        config.setValue("enable", "true");
+        config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(4));
+        handle = plugin_init(&config, nullptr, deleteOutputStream);
+    }
+
+    void TearDown() override
+    {
+        plugin_shutdown(handle);
+    }
+
+    /*
+     * Ingest the messages a first time to warm up the filter (buffers sized for the batch), then measure the
+     * allocations of a second ingest
+     */
+    HnzAllocStats measureIngest(const std::string& assetName, const std::string& json, size_t readingCount = 1)
+    {
+        plugin_ingest(handle, HnzTestReadings::createReadingSet(assetName, std::vector<std::string>(readingCount, json)));
+        ReadingSet* readingSet = HnzTestReadings::createReadingSet(assetName, std::vector<std::string>(readingCount, json));
+        HnzAllocCounter::start();
+        plugin_ingest(handle, readingSet);
+        HnzAllocStats stats = HnzAllocCounter::stop();
+        printf("%s x%lu: %lu news (%lu bytes), %lu deletes, %lu mallocs, %lu frees\n", assetName.c_str(),
+               static_cast<unsigned long>(readingCount), static_cast<unsigned long>(stats.news), static_cast<unsigned long>(stats.newBytes),
+               static_cast<unsigned long>(stats.deletes), static_cast<unsigned long>(stats.mallocs),
+               static_cast<unsigned long>(stats.frees));
+        return stats;
+    }
+};
+
+// Volatile so that the compiler cannot elide the allocations of the Counter test
+static int* volatile allocated = nullptr;
+
+TEST_F(PivotHNZPluginAllocationBudget, Counter)
+{
+    HnzAllocCounter::start();
+    allocated = new int(42);
+    delete allocated;
+    HnzAllocStats stats = HnzAllocCounter::stop();
+    ASSERT_EQ(stats.news, 1);
+    ASSERT_EQ(stats.newBytes, sizeof(int));
+    ASSERT_EQ(stats.deletes, 1);
+#ifdef __GLIBC__
+    ASSERT_GE(stats.mallocs, 1);
+    ASSERT_GE(stats.frees, 1);
+#endif
+    // Nothing is counted once stopped
+    allocated = new int(42);
+    delete allocated;
+    ASSERT_EQ(HnzAllocCounter::stop().news, 1);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, TSCE)
+{
+    HnzAllocStats stats = measureIngest("P0", QUOTE({
+        "data_object":{
+            "do_type":"TS",
+            "do_station":12,
+            "do_addr":0,
+            "do_value":1,
+            "do_valid":0,
+            "do_cg":0,
+            "do_outdated":0,
+            "do_ts": 1685019425432,
+            "do_ts_iv":0,
+            "do_ts_c":0,
+            "do_ts_s":0
+        }
+    }));
+    ASSERT_LE(stats.news, 170);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, TSCG)
+{
+    HnzAllocStats stats = measureIngest("P0", QUOTE({
+        "data_object":{
+            "do_type":"TS",
+            "do_station":12,
+            "do_addr":0,
+            "do_value":1,
+            "do_valid":0,
+            "do_cg":1,
+            "do_outdated":0
+        }
+    }));
+    ASSERT_LE(stats.news, 180);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, TM)
+{
+    HnzAllocStats stats = measureIngest("P1", QUOTE({
+        "data_object":{
+            "do_type":"TM",
+            "do_station":12,
+            "do_addr":1,
+            "do_value":-15,
+            "do_valid":0,
+            "do_an":"TMA",
+            "do_outdated":0
+        }
+    }));
+    ASSERT_LE(stats.news, 175);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, TCACK)
+{
+    HnzAllocStats stats = measureIngest("P2", QUOTE({
+        "data_object":{
+            "do_type":"TC",
+            "do_station":12,
+            "do_addr":2,
+            "do_valid":0
+        }
+    }));
+    ASSERT_LE(stats.news, 175);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, PivotCommand)
+{
+    HnzAllocStats stats = measureIngest("PivotCommand", QUOTE({
+        "PIVOT": {
+            "GTIC": {
+                "SpcTyp": {
+                    "q": {
+                        "Source": "process",
+                        "Validity": "good"
+                    },
+                    "t": {
+                        "FractionOfSecond": 9529458,
+                        "SecondSinceEpoch": 1669714185
+                    },
+                    "ctlVal": 1
+                },
+                "Identifier": "ID100002"
+            }
+        }
+    }));
+    ASSERT_LE(stats.news, 90);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, SouthEvent)
+{
+    HnzAllocStats stats = measureIngest("CONNECTION-1", QUOTE({
+        "south_event":{
+            "connx_status": "not connected",
+            "gi_status": "idle"
+        }
+    }));
+    ASSERT_LE(stats.news, 60);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, PivotCommandBatch)
+{
+    const std::string json = QUOTE({
+        "PIVOT": {
+            "GTIC": {
+                "SpcTyp": {
+                    "q": {
+                        "Source": "process",
+                        "Validity": "good"
+                    },
+                    "t": {
+                        "FractionOfSecond": 9529458,
+                        "SecondSinceEpoch": 1669714185
+                    },
+                    "ctlVal": 1
+                },
+                "Identifier": "ID100002"
+            }
+        }
+    });
+    // The converted datapoints buffer keeps its capacity between readings: each reading of a batch costs
+    // the same number of allocations, and none of them is a growth of the buffer or of the datapoints vector
+    // of the reading (74 allocations per reading when each reading and each command built its own vectors).
+    // One of them is the entry of the command in the pending commands of the command tracker.
+    HnzAllocStats oneReading = measureIngest("PivotCommand", json, 1);
+    HnzAllocStats twoReadings = measureIngest("PivotCommand", json, 2);
+    HnzAllocStats tenReadings = measureIngest("PivotCommand", json, 10);
+    size_t perReading = twoReadings.news - oneReading.news;
+    ASSERT_EQ(tenReadings.news, oneReading.news + 9 * perReading);
+    ASSERT_LE(perReading, 70);
+}
+
+TEST_F(PivotHNZPluginAllocationBudget, EmptiedReadingSetFreed)
+{
+    // No point configured at this address: the only reading is removed and nothing is forwarded
+    const std::string json = QUOTE({"data_object":{"do_type":"TS","do_station":12,"do_addr":511,"do_value":1,
+                                                   "do_valid":0,"do_cg":1,"do_outdated":0}});
+    plugin_ingest(handle, HnzTestReadings::createReadingSet("P0", {json}));
+    // Creating and deleting the reading set leaves some allocations of the Fledge classes alive: the ingest
+    // must leave the same number, the reading set being deleted rather than leaked
+    HnzAllocCounter::start();
+    delete HnzTestReadings::createReadingSet("P0", {json});
+    HnzAllocStats created = HnzAllocCounter::stop();
+    HnzAllocCounter::start();
+    plugin_ingest(handle, HnzTestReadings::createReadingSet("P0", {json}));
+    HnzAllocStats stats = HnzAllocCounter::stop();
+    ASSERT_EQ(stats.news - stats.deletes, created.news - created.deletes);
+}
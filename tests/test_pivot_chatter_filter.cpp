@@ -0,0 +1,310 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <thread>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_chatter_filter.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using Decision = HnzPivotChatterFilter::Decision;
+using Transition = HnzPivotChatterFilter::Transition;
+
+static Decision onTransition(HnzPivotChatterFilter& chatterFilter, size_t pointIndex, uint64_t tsMs, bool value = false)
+{
+    Transition transition;
+    transition.hasValue = true;
+    transition.value = value;
+    transition.hasTs = true;
+    transition.ts = tsMs;
+    return chatterFilter.onTransition(pointIndex, tsMs, tsMs, transition);
+}
+
+TEST(PivotHNZChatterFilter, Disabled)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.reset(2);
+    ASSERT_FALSE(chatterFilter.isEnabled());
+    for (int i = 0; i < 100; i++) {
+        ASSERT_EQ(onTransition(chatterFilter, 0, 1000), Decision::FORWARD);
+    }
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 0);
+}
+
+TEST(PivotHNZChatterFilter, TripAndRelease)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.setLimits(4, 1000);
+    chatterFilter.reset(2);
+    ASSERT_TRUE(chatterFilter.isEnabled());
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(onTransition(chatterFilter, 0, 10000 + i * 10), Decision::FORWARD);
+    }
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10050), Decision::FORWARD_OSCILLATORY);
+    ASSERT_TRUE(chatterFilter.isChattering(0));
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10060), Decision::SUPPRESS);
+    // Other points are not affected
+    ASSERT_EQ(onTransition(chatterFilter, 1, 10060), Decision::FORWARD);
+    ASSERT_FALSE(chatterFilter.isChattering(1));
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 1);
+
+    // Still chattering in the next window, the transitions of the previous one are still counted
+    ASSERT_EQ(onTransition(chatterFilter, 0, 11100), Decision::SUPPRESS);
+    // Calm for two windows, released by the next transition
+    ASSERT_EQ(onTransition(chatterFilter, 0, 14000), Decision::FORWARD);
+    ASSERT_FALSE(chatterFilter.isChattering(0));
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 0);
+
+    // Out of range index
+    ASSERT_EQ(onTransition(chatterFilter, 2, 14000), Decision::FORWARD);
+    ASSERT_FALSE(chatterFilter.isChattering(2));
+}
+
+TEST(PivotHNZChatterFilter, Remap)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.setLimits(2, 1000);
+    chatterFilter.reset(3);
+    for (size_t pointIndex : {0, 2}) {
+        ASSERT_EQ(onTransition(chatterFilter, pointIndex, 10000), Decision::FORWARD);
+        ASSERT_EQ(onTransition(chatterFilter, pointIndex, 10010), Decision::FORWARD);
+        ASSERT_EQ(onTransition(chatterFilter, pointIndex, 10020), Decision::FORWARD_OSCILLATORY);
+    }
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 2);
+
+    // Point 0 moves to index 3, point 1 to index 0, point 2 is removed or changed
+    chatterFilter.remap({3, 0, HnzPivotPerfectHash::NOT_FOUND}, 4);
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 1);
+    ASSERT_TRUE(chatterFilter.isChattering(3));
+    ASSERT_FALSE(chatterFilter.isChattering(0));
+    ASSERT_FALSE(chatterFilter.isChattering(2));
+    ASSERT_EQ(onTransition(chatterFilter, 3, 10030), Decision::SUPPRESS);
+    ASSERT_EQ(onTransition(chatterFilter, 2, 10030), Decision::FORWARD);
+    // Released at its new index
+    std::vector<HnzPivotChatterFilter::Released> released;
+    chatterFilter.release(20000, released);
+    ASSERT_EQ(released.size(), 1);
+    ASSERT_EQ(released[0].pointIndex, 3);
+}
+
+TEST(PivotHNZChatterFilter, SlidingWindow)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.setLimits(4, 1000);
+    chatterFilter.reset(1);
+
+    // 4 transitions at the end of a window and 1 at the start of the next one: 5 within the sliding window
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(onTransition(chatterFilter, 0, 900 + i * 10), Decision::FORWARD);
+    }
+    ASSERT_EQ(onTransition(chatterFilter, 0, 1000), Decision::FORWARD_OSCILLATORY);
+
+    // Same transitions spread over more than a window
+    chatterFilter.reset(1);
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(onTransition(chatterFilter, 0, i * 10), Decision::FORWARD);
+    }
+    ASSERT_EQ(onTransition(chatterFilter, 0, 1900), Decision::FORWARD);
+}
+
+TEST(PivotHNZChatterFilter, TimestampBased)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.setLimits(2, 1000);
+    chatterFilter.reset(1);
+
+    // Transitions received together are counted by their timestamp, spread over more than two windows here
+    Transition transition;
+    for (int i = 0; i < 4; i++) {
+        ASSERT_EQ(chatterFilter.onTransition(0, 10000 + i * 2000, 50000, transition), Decision::FORWARD);
+    }
+    // Burst of transitions timestamped within a window, although received over several seconds
+    ASSERT_EQ(chatterFilter.onTransition(0, 20000, 50000, transition), Decision::FORWARD);
+    ASSERT_EQ(chatterFilter.onTransition(0, 20010, 52000, transition), Decision::FORWARD);
+    ASSERT_EQ(chatterFilter.onTransition(0, 20020, 54000, transition), Decision::FORWARD_OSCILLATORY);
+}
+
+TEST(PivotHNZChatterFilter, ReleaseLastSuppressed)
+{
+    HnzPivotChatterFilter chatterFilter;
+    chatterFilter.setLimits(2, 1000);
+    chatterFilter.reset(2);
+    std::vector<HnzPivotChatterFilter::Released> released;
+
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10000, true), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10010, false), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10020, true), Decision::FORWARD_OSCILLATORY);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10030, false), Decision::SUPPRESS);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 10040, true), Decision::SUPPRESS);
+    // Point 1 chattering without any transition suppressed
+    ASSERT_EQ(onTransition(chatterFilter, 1, 10000), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 1, 10010), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 1, 10020), Decision::FORWARD_OSCILLATORY);
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 2);
+
+    // Still chattering shortly after
+    chatterFilter.release(10500, released);
+    ASSERT_TRUE(released.empty());
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 2);
+
+    // Calm for two windows: both points released, the last transition suppressed of point 0 is returned
+    chatterFilter.release(12100, released);
+    ASSERT_EQ(released.size(), 1);
+    ASSERT_EQ(released[0].pointIndex, 0);
+    ASSERT_TRUE(released[0].transition.value);
+    ASSERT_EQ(released[0].transition.ts, 10040);
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 0);
+    ASSERT_FALSE(chatterFilter.isChattering(0));
+    ASSERT_FALSE(chatterFilter.isChattering(1));
+
+    // Released only once
+    released.clear();
+    chatterFilter.release(15000, released);
+    ASSERT_TRUE(released.empty());
+
+    // A point released by its next transition forgets its last transition suppressed
+    ASSERT_EQ(onTransition(chatterFilter, 0, 20000), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 20010), Decision::FORWARD);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 20020), Decision::FORWARD_OSCILLATORY);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 20030), Decision::SUPPRESS);
+    ASSERT_EQ(onTransition(chatterFilter, 0, 23000), Decision::FORWARD);
+    chatterFilter.release(30000, released);
+    ASSERT_TRUE(released.empty());
+}
+
+static std::string tsJson(int value, bool cg, unsigned long ts = 1685019425432)
+{
+    std::string json = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":" +
+                       std::to_string(value) + ",\"do_valid\":0,\"do_outdated\":0";
+    if (cg) {
+        return json + ",\"do_cg\":1}}";
+    }
+    return json + ",\"do_cg\":0,\"do_ts\":" + std::to_string(ts) + ",\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+}
+
+using PivotHNZPluginChatterFilter = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginChatterFilter, FilterSuppressChatteringTS)
+{
+    m_config.setValue("chatter_max_transitions", "3");
+    m_config.setValue("chatter_window", "60000");
+    // P0 (TS, address 0, any station)
+    HNZPivotFilter* filter = initFilter(4);
+    const HnzPivotChatterFilter& chatterFilter = filter->getChatterFilter();
+    ASSERT_EQ(chatterFilter.getMaxTransitions(), 3);
+    ASSERT_EQ(chatterFilter.getWindowMs(), 60000);
+
+    // 3 transitions forwarded, the 4th flagged oscillatory, the next ones suppressed
+    for (int i = 0; i < 10; i++) {
+        ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(i % 2, false, 1685019425432 + i)})));
+    }
+    ASSERT_EQ(m_outputJsons.size(), 4);
+    ASSERT_EQ(countOutputs("\"oscillatory\":1"), 1);
+    ASSERT_NE(m_outputJsons.back().find("\"Validity\":\"questionable\""), std::string::npos) << m_outputJsons.back();
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 1);
+    ASSERT_EQ(filter->getStatistics().get(HnzPivotStatistics::DataType::TS, HnzPivotStatistics::Counter::SUPPRESSED), 6);
+
+    // TS CG are not transitions, forwarded with the oscillatory flag while the point is chattering
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(1, true)})));
+    ASSERT_EQ(m_outputJsons.size(), 5);
+    ASSERT_EQ(countOutputs("\"oscillatory\":1"), 2);
+
+    // Suppressed datapoints do not prevent the others of the reading from being forwarded
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {
+        tsJson(0, false, 1685019425442),
+        "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,\"do_value\":1,\"do_valid\":0,\"do_an\":\"TMA\",\"do_outdated\":0}}"
+    })));
+    ASSERT_EQ(m_outputJsons.size(), 6);
+    ASSERT_EQ(countOutputs("GTIM"), 1);
+
+    // Statistics export the chattering points
+    m_config.setValue("statistics_period", "3600");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(1, false, 1685019425443)})));
+    ASSERT_NE(m_lastStatisticsJson.find("\"chattering_points\":1"), std::string::npos) << m_lastStatisticsJson;
+
+    // Invalid limits are ignored, disabling the filter forwards everything again
+    checkInvalidIgnored("chatter_max_transitions", "-1", [&chatterFilter]() { return chatterFilter.getMaxTransitions(); });
+    checkInvalidIgnored("chatter_window", "0", [&chatterFilter]() { return chatterFilter.getWindowMs(); });
+    m_config.setValue("chatter_max_transitions", "0");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(chatterFilter.isEnabled());
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 0);
+    clearOutputs();
+    for (int i = 0; i < 10; i++) {
+        ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(i % 2, false)})));
+    }
+    ASSERT_EQ(countOutputs("GTIS"), 10);
+    ASSERT_EQ(countOutputs("\"oscillatory\":1"), 0);
+    ASSERT_NE(m_lastStatisticsJson.find("\"chattering_points\":0"), std::string::npos) << m_lastStatisticsJson;
+}
+
+TEST_F(PivotHNZPluginChatterFilter, FilterKeepStateOnReconfigure)
+{
+    m_config.setValue("chatter_max_transitions", "3");
+    m_config.setValue("chatter_window", "60000");
+    HNZPivotFilter* filter = initFilter(4);
+    const HnzPivotChatterFilter& chatterFilter = filter->getChatterFilter();
+    for (int i = 0; i < 5; i++) {
+        ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(i % 2, false, 1685019425432 + i)})));
+    }
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 1);
+
+    // Points added: P0 is unchanged and still chattering
+    m_config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(8));
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 1);
+    clearOutputs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(1, false, 1685019425437)})));
+    ASSERT_EQ(m_outputJsons.size(), 0);
+
+    // P0 changed: its state is forgotten
+    std::string exchangedData = HnzTrafficGenerator::generateExchangedData(8);
+    exchangedData.replace(exchangedData.find("\"label\":\"P0\""), 12, "\"label\":\"Q0\"");
+    m_config.setValue("exchanged_data", exchangedData);
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_EQ(chatterFilter.getChatteringCount(), 0);
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(0, false, 1685019425438)})));
+    ASSERT_EQ(m_outputJsons.size(), 1);
+}
+
+TEST_F(PivotHNZPluginChatterFilter, FilterForwardLastSuppressedTS)
+{
+    m_config.setValue("chatter_max_transitions", "2");
+    m_config.setValue("chatter_window", "100");
+    HNZPivotFilter* filter = initFilter(4);
+
+    // 2 transitions forwarded, the 3rd flagged oscillatory, the last 2 suppressed, ending in state 0
+    const unsigned long ts = 1685019425432;
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {
+        tsJson(1, false, ts), tsJson(0, false, ts + 1), tsJson(1, false, ts + 2), tsJson(1, false, ts + 3), tsJson(0, false, ts + 4)
+    })));
+    ASSERT_EQ(m_outputJsons.size(), 3);
+    ASSERT_EQ(filter->getChatterFilter().getChatteringCount(), 1);
+
+    ASSERT_EQ(filter->getStatistics().get(HnzPivotStatistics::DataType::TS, HnzPivotStatistics::Counter::SUPPRESSED), 2);
+
+    // Calm for two windows: the last state is forwarded with the next reading set, without the oscillatory flag
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    clearOutputs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TM", {
+        "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,\"do_value\":1,\"do_valid\":0,\"do_an\":\"TMA\",\"do_outdated\":0}}"
+    })));
+    ASSERT_EQ(m_outputJsons.size(), 2);
+    ASSERT_NE(m_outputJsons[0].find("\"asset_code\":\"P0\""), std::string::npos) << m_outputJsons[0];
+    ASSERT_NE(m_outputJsons[0].find("\"stVal\":0"), std::string::npos) << m_outputJsons[0];
+    ASSERT_NE(m_outputJsons[0].find("\"SecondSinceEpoch\":1685019425"), std::string::npos) << m_outputJsons[0];
+    ASSERT_EQ(countOutputs("\"oscillatory\":1"), 0);
+    ASSERT_NE(m_outputJsons[1].find("GTIM"), std::string::npos) << m_outputJsons[1];
+    ASSERT_EQ(filter->getChatterFilter().getChatteringCount(), 0);
+
+    // Released once
+    clearOutputs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(1, false, ts + 1000)})));
+    ASSERT_EQ(m_outputJsons.size(), 1);
+}
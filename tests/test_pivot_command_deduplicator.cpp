@@ -0,0 +1,89 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_command_deduplicator.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_perfect_hash.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+TEST(PivotHNZCommandDeduplicator, Window)
+{
+    HnzPivotCommandDeduplicator deduplicator;
+    ASSERT_FALSE(deduplicator.isEnabled());
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 1, 1000));
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 1, 1000));
+
+    deduplicator.setWindowMs(500);
+    ASSERT_TRUE(deduplicator.isEnabled());
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 1, 1000));
+    ASSERT_TRUE(deduplicator.isDuplicate(3, 1, 1200));
+    // Duplicates do not extend the window
+    ASSERT_TRUE(deduplicator.isDuplicate(3, 1, 1499));
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 1, 1500));
+    // Other value or other point
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 2, 1600));
+    ASSERT_FALSE(deduplicator.isDuplicate(4, 2, 1600));
+    ASSERT_TRUE(deduplicator.isDuplicate(3, 2, 1700));
+
+    // Points sharing an entry of the table replace each other
+    size_t otherIndex = 3 + HnzPivotCommandDeduplicator::TABLE_SIZE;
+    ASSERT_FALSE(deduplicator.isDuplicate(otherIndex, 2, 1700));
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 2, 1700));
+
+    deduplicator.reset();
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 2, 1700));
+
+    // Commands follow their point to its new index, the ones of the points removed are forgotten
+    ASSERT_FALSE(deduplicator.isDuplicate(4, 2, 1700));
+    std::vector<size_t> pointIndexes(5, HnzPivotPerfectHash::NOT_FOUND);
+    pointIndexes[3] = 10;
+    deduplicator.remap(pointIndexes, 11);
+    ASSERT_TRUE(deduplicator.isDuplicate(10, 2, 1800));
+    ASSERT_FALSE(deduplicator.isDuplicate(3, 2, 1800));
+    ASSERT_FALSE(deduplicator.isDuplicate(4, 2, 1800));
+}
+
+static std::string pivotCommandJson(const std::string& pivotId, int ctlVal)
+{
+    return "{\"PIVOT\":{\"GTIC\":{\"SpcTyp\":{\"q\":{\"Source\":\"process\",\"Validity\":\"good\"},"
+           "\"t\":{\"FractionOfSecond\":9529458,\"SecondSinceEpoch\":1669714185},\"ctlVal\":" + std::to_string(ctlVal) + "},"
+           "\"Identifier\":\"" + pivotId + "\"}}}";
+}
+
+using PivotHNZPluginCommandDeduplicator = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginCommandDeduplicator, FilterDropDuplicates)
+{
+    m_config.setValue("command_dedup_window", "60000");
+    // P2 (TC, ID100002, address 2)
+    HNZPivotFilter* filter = initFilter(4);
+    ASSERT_EQ(filter->getCommandDeduplicator().getWindowMs(), 60000);
+
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {
+        pivotCommandJson("ID100002", 1),
+        pivotCommandJson("ID100002", 1), // duplicate
+        pivotCommandJson("ID100002", 0)
+    })));
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {pivotCommandJson("ID100002", 0)})));
+    ASSERT_EQ(m_outputJsons.size(), 2);
+    ASSERT_NE(m_outputJsons[0].find("\"co_value\":1"), std::string::npos) << m_outputJsons[0];
+    ASSERT_NE(m_outputJsons[1].find("\"co_value\":2"), std::string::npos) << m_outputJsons[1];
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    ASSERT_EQ(statistics.get(HnzPivotStatistics::DataType::PIVOT, HnzPivotStatistics::Counter::SUPPRESSED), 2);
+    ASSERT_EQ(statistics.get(HnzPivotStatistics::DataType::PIVOT, HnzPivotStatistics::Counter::CONVERTED), 2);
+    ASSERT_EQ(filter->getCommandTracker().get(HnzPivotCommandTracker::Counter::SENT), 2);
+
+    // Invalid window is ignored, disabled every command is forwarded
+    checkInvalidIgnored("command_dedup_window", "-1", [filter]() { return filter->getCommandDeduplicator().getWindowMs(); });
+    m_config.setValue("command_dedup_window", "0");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(filter->getCommandDeduplicator().isEnabled());
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {
+        pivotCommandJson("ID100002", 1),
+        pivotCommandJson("ID100002", 1)
+    })));
+    ASSERT_EQ(m_outputJsons.size(), 4);
+}
@@ -0,0 +1,192 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_command_tracker.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using Counter = HnzPivotCommandTracker::Counter;
+using Clock = HnzPivotCommandTracker::Clock;
+
+TEST(PivotHNZCommandTracker, RoundTrip)
+{
+    HnzPivotCommandTracker tracker;
+    tracker.remap({}, 4);
+    Clock::time_point start = Clock::now();
+    tracker.commandSent(2, start);
+    tracker.commandSent(3, start);
+    ASSERT_EQ(tracker.getPendingCount(), 2);
+
+    // Matched by point
+    ASSERT_TRUE(tracker.ackReceived(3, start + std::chrono::milliseconds(30)));
+    ASSERT_TRUE(tracker.ackReceived(2, start + std::chrono::milliseconds(120)));
+    ASSERT_FALSE(tracker.ackReceived(2, start + std::chrono::milliseconds(130)));
+    ASSERT_FALSE(tracker.ackReceived(1, start + std::chrono::milliseconds(130)));
+    // Out of range index
+    ASSERT_FALSE(tracker.ackReceived(4, start + std::chrono::milliseconds(130)));
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+
+    ASSERT_EQ(tracker.get(Counter::SENT), 2);
+    ASSERT_EQ(tracker.get(Counter::ACKNOWLEDGED), 2);
+    ASSERT_EQ(tracker.get(Counter::UNEXPECTED_ACK), 3);
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 0);
+    HnzPivotHistogram::Snapshot roundTrip = tracker.getRoundTripSnapshot();
+    ASSERT_EQ(roundTrip.count, 2);
+    ASSERT_EQ(roundTrip.min, 30000);
+    ASSERT_EQ(roundTrip.max, 120000);
+
+    tracker.commandSent(1, start);
+    tracker.reset();
+    ASSERT_EQ(tracker.get(Counter::SENT), 0);
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+    ASSERT_EQ(tracker.getRoundTripSnapshot().count, 0);
+    ASSERT_FALSE(tracker.ackReceived(1, start));
+
+    // A new configuration keeping none of the points forgets the pending commands
+    tracker.commandSent(1, start);
+    tracker.remap({}, 2);
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+    ASSERT_FALSE(tracker.ackReceived(1, start));
+}
+
+TEST(PivotHNZCommandTracker, Remap)
+{
+    HnzPivotCommandTracker tracker;
+    tracker.remap({}, 3);
+    Clock::time_point start = Clock::now();
+    tracker.commandSent(0, start);
+    tracker.commandSent(1, start);
+    tracker.commandSent(1, start);
+    ASSERT_EQ(tracker.getPendingCount(), 3);
+
+    // Point 1 moves to index 0, point 0 is removed or changed: its pending command is forgotten
+    tracker.remap({HnzPivotPerfectHash::NOT_FOUND, 0, 1}, 2);
+    ASSERT_EQ(tracker.getPendingCount(), 2);
+    ASSERT_TRUE(tracker.ackReceived(0, start + std::chrono::milliseconds(10)));
+    ASSERT_TRUE(tracker.ackReceived(0, start + std::chrono::milliseconds(10)));
+    ASSERT_FALSE(tracker.ackReceived(1, start + std::chrono::milliseconds(10)));
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 0);
+}
+
+TEST(PivotHNZCommandTracker, SamePointInOrder)
+{
+    HnzPivotCommandTracker tracker;
+    tracker.remap({}, 2);
+    Clock::time_point start = Clock::now();
+    tracker.commandSent(1, start);
+    tracker.commandSent(1, start + std::chrono::milliseconds(100));
+    // First ACK matches the first command sent
+    ASSERT_TRUE(tracker.ackReceived(1, start + std::chrono::milliseconds(150)));
+    ASSERT_EQ(tracker.getRoundTripSnapshot().max, 150000);
+    ASSERT_TRUE(tracker.ackReceived(1, start + std::chrono::milliseconds(160)));
+    ASSERT_EQ(tracker.getRoundTripSnapshot().min, 60000);
+}
+
+TEST(PivotHNZCommandTracker, Timeout)
+{
+    HnzPivotCommandTracker tracker;
+    tracker.remap({}, 5);
+    tracker.setTimeout(std::chrono::seconds(2));
+    ASSERT_EQ(tracker.getTimeout(), std::chrono::seconds(2));
+    Clock::time_point start = Clock::now();
+    tracker.commandSent(1, start);
+    tracker.commandSent(2, start);
+    tracker.commandSent(3, start + std::chrono::seconds(1));
+
+    // Late ACK of a command not expired yet
+    ASSERT_FALSE(tracker.ackReceived(1, start + std::chrono::seconds(3)));
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 1);
+
+    tracker.expire(start + std::chrono::milliseconds(2500));
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 2);
+    ASSERT_EQ(tracker.getPendingCount(), 1);
+    // ACK of an expired command
+    ASSERT_FALSE(tracker.ackReceived(2, start + std::chrono::seconds(3)));
+    ASSERT_EQ(tracker.get(Counter::UNEXPECTED_ACK), 1);
+
+    // Commands sent later to the same point expire its previous ones, the other points are left to expire
+    tracker.commandSent(4, start + std::chrono::seconds(4));
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 2);
+    ASSERT_EQ(tracker.getPendingCount(), 2);
+    tracker.commandSent(3, start + std::chrono::seconds(4));
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 3);
+    ASSERT_EQ(tracker.getPendingCount(), 2);
+    tracker.expire(start + std::chrono::seconds(10));
+    ASSERT_EQ(tracker.get(Counter::TIMED_OUT), 5);
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+    ASSERT_EQ(tracker.get(Counter::ACKNOWLEDGED), 0);
+    ASSERT_EQ(tracker.getRoundTripSnapshot().count, 0);
+}
+
+TEST(PivotHNZCommandTracker, Datapoint)
+{
+    HnzPivotCommandTracker tracker;
+    tracker.remap({}, 3);
+    Clock::time_point start = Clock::now();
+    tracker.commandSent(1, start);
+    tracker.commandSent(2, start);
+    tracker.ackReceived(1, start + std::chrono::milliseconds(5));
+
+    Datapoint* dp = tracker.toDatapoint("commands");
+    std::string json = dp->toJSONProperty();
+    delete dp;
+    ASSERT_NE(json.find("\"commands\":{\"sent\":2, \"acknowledged\":1, \"timed_out\":0, \"unexpected_ack\":0, \"pending\":1"),
+              std::string::npos) << json;
+    ASSERT_NE(json.find("\"round_trip_us\":{\"min\":5000, \"mean\":5000"), std::string::npos) << json;
+
+    for (int i = 0; i < HnzPivotCommandTracker::COUNTER_COUNT; i++) {
+        ASSERT_FALSE(HnzPivotCommandTracker::CounterStr(static_cast<Counter>(i)).empty());
+    }
+}
+
+static std::string pivotCommandJson(const std::string& pivotId)
+{
+    return "{\"PIVOT\":{\"GTIC\":{\"SpcTyp\":{\"q\":{\"Source\":\"process\",\"Validity\":\"good\"},"
+           "\"t\":{\"FractionOfSecond\":9529458,\"SecondSinceEpoch\":1669714185},\"ctlVal\":1},"
+           "\"Identifier\":\"" + pivotId + "\"}}}";
+}
+
+static std::string ackJson(const std::string& type, int address)
+{
+    return "{\"data_object\":{\"do_type\":\"" + type + "\",\"do_station\":12,\"do_addr\":" + std::to_string(address) +
+           ",\"do_valid\":0}}";
+}
+
+using PivotHNZPluginCommandTracker = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginCommandTracker, FilterRoundTrip)
+{
+    m_config.setValue("statistics_period", "1");
+    m_config.setValue("command_ack_timeout", "30");
+    // P2 (TC, ID100002, address 2) and P3 (TVC, ID100003, address 3)
+    HNZPivotFilter* filter = initFilter(4);
+    const HnzPivotCommandTracker& tracker = filter->getCommandTracker();
+    ASSERT_EQ(tracker.getTimeout(), std::chrono::seconds(30));
+
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {
+        pivotCommandJson("ID100002"),
+        pivotCommandJson("ID100003"),
+        pivotCommandJson("ID999999") // unknown, not tracked
+    })));
+    ASSERT_EQ(tracker.get(Counter::SENT), 2);
+    ASSERT_EQ(tracker.getPendingCount(), 2);
+
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TC", {ackJson("TC", 2)})));
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TVC", {ackJson("TVC", 3)})));
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TVC", {ackJson("TVC", 3)})));
+    ASSERT_EQ(tracker.get(Counter::ACKNOWLEDGED), 2);
+    ASSERT_EQ(tracker.get(Counter::UNEXPECTED_ACK), 1);
+    ASSERT_EQ(tracker.getPendingCount(), 0);
+    ASSERT_EQ(tracker.getRoundTripSnapshot().count, 2);
+
+    // Exported with the statistics
+    ASSERT_NE(m_lastStatisticsJson.find("\"commands\":{\"sent\":"), std::string::npos) << m_lastStatisticsJson;
+
+    // Invalid timeout is ignored
+    checkInvalidIgnored("command_ack_timeout", "0", [&tracker]() { return tracker.getTimeout(); });
+}
@@ -0,0 +1,289 @@
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <config_category.h>
+#include <filter.h>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <unistd.h>
+
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_config_cache.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+};
+
+static const std::string duplicatedPivotIdConfig = QUOTE({
+    "exchanged_data" : {
+        "name" : "SAMPLE",
+        "version" : "1.0",
+        "datapoints" : [
+            {
+                "label" : "TS1",
+                "pivot_id" : "ID114562",
+                "pivot_type" : "SpsTyp",
+                "protocols" : [
+                    {
+                        "name" : "hnzip",
+                        "address" : "511",
+                        "typeid" : "TS"
+                    },
+                    {
+                        "name" : "hnzip",
+                        "address" : "513",
+                        "typeid" : "TS"
+                    },
+                    {
+                        "name" : "hnzip",
+                        "station" : "7",
+                        "address" : "514",
+                        "typeid" : "TS"
+                    }
+                ]
+            }
+        ]
+    }
+});
+
+class PivotHNZPluginConfigCache : public testing::Test
+{
+protected:
+    std::string directory;
+    std::string path;
+
+    void SetUp() override
+    {
+        char dirTemplate[] = "/tmp/hnz_pivot_cache_XXXXXX";
+        ASSERT_NE(mkdtemp(dirTemplate), nullptr);
+        directory = dirTemplate;
+        // The cache creates the directory of the file
+        path = directory + "/cache/filter.cache";
+    }
+
+    void TearDown() override
+    {
+        remove(path.c_str());
+        rmdir((directory + "/cache").c_str());
+        rmdir(directory.c_str());
+    }
+
+    static void assertSameTables(const HNZPivotConfig& expected, const HNZPivotConfig& actual)
+    {
+        ASSERT_EQ(actual.isComplete(), expected.isComplete());
+        ASSERT_EQ(actual.getExchangeDefinitions().size(), expected.getExchangeDefinitions().size());
+        for (const auto& entry : expected.getExchangeDefinitions()) {
+            ASSERT_EQ(actual.getExchangeDefinitions().count(entry.first), 1);
+            const HNZPivotDataPoint& dp = *actual.getExchangeDefinitions().at(entry.first);
+            ASSERT_EQ(dp.getLabel(), entry.second->getLabel());
+            ASSERT_EQ(dp.getPivotId(), entry.second->getPivotId());
+            ASSERT_EQ(dp.getPivotType(), entry.second->getPivotType());
+            ASSERT_EQ(dp.getTypeId(), entry.second->getTypeId());
+            ASSERT_EQ(dp.getAddress(), entry.second->getAddress());
+            ASSERT_EQ(dp.hasStation(), entry.second->hasStation());
+            ASSERT_EQ(dp.getStation(), entry.second->getStation());
+            ASSERT_EQ(actual.findPivotId(dp.getStation(), dp.getTypeId(), dp.getAddress()), entry.first);
+        }
+    }
+};
+
+TEST_F(PivotHNZPluginConfigCache, Key)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    HnzPivotConfigCache::ConfigKey key = HnzPivotConfigCache::keyConfig(exchangedData);
+    ASSERT_EQ(key, HnzPivotConfigCache::keyConfig(exchangedData));
+    ASSERT_EQ(key.size, exchangedData.size());
+    HnzPivotConfigCache::ConfigKey otherKey = HnzPivotConfigCache::keyConfig(exchangedData + " ");
+    ASSERT_NE(key, otherKey);
+    ASSERT_NE(key.hash, otherKey.hash);
+    ASSERT_NE(key.checkHash, otherKey.checkHash);
+    ASSERT_NE(key.hash, key.checkHash);
+}
+
+TEST_F(PivotHNZPluginConfigCache, DefaultPath)
+{
+    const std::string cachePath = HnzPivotConfigCache::defaultPath("south/hnz 1");
+    ASSERT_EQ(cachePath.substr(cachePath.rfind('/')), "/south_hnz_1.cache");
+    ASSERT_NE(cachePath.find(FILTER_NAME), std::string::npos);
+}
+
+TEST_F(PivotHNZPluginConfigCache, SaveAndLoad)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(100);
+    HnzPivotConfigCache::ConfigKey key = HnzPivotConfigCache::keyConfig(exchangedData);
+    HNZPivotConfig parsedConfig;
+    parsedConfig.importExchangeConfig(exchangedData);
+
+    HnzPivotConfigCache cache(path);
+    ASSERT_TRUE(cache.save(parsedConfig, key));
+    HNZPivotConfig cachedConfig;
+    ASSERT_TRUE(cache.load(cachedConfig, key));
+    assertSameTables(parsedConfig, cachedConfig);
+    ASSERT_EQ(cachedConfig.findPivotId(0, "TS", 100), "");
+}
+
+TEST_F(PivotHNZPluginConfigCache, SaveAndLoadSharedPivotId)
+{
+    HnzPivotConfigCache::ConfigKey key = HnzPivotConfigCache::keyConfig(duplicatedPivotIdConfig);
+    HNZPivotConfig parsedConfig;
+    parsedConfig.importExchangeConfig(duplicatedPivotIdConfig);
+
+    HnzPivotConfigCache cache(path);
+    ASSERT_TRUE(cache.save(parsedConfig, key));
+    HNZPivotConfig cachedConfig;
+    ASSERT_TRUE(cache.load(cachedConfig, key));
+    // All addresses lead to the pivot id, even if only the last one is kept in the definitions
+    ASSERT_EQ(cachedConfig.getExchangeDefinitions().size(), 1);
+    ASSERT_EQ(cachedConfig.findPivotId(8, "TS", 511), "ID114562");
+    ASSERT_EQ(cachedConfig.findPivotId(8, "TS", 513), "ID114562");
+    ASSERT_EQ(cachedConfig.findPivotId(7, "TS", 514), "ID114562");
+    ASSERT_EQ(cachedConfig.findPivotId(7, "TS", 511), "ID114562");
+    ASSERT_EQ(cachedConfig.findPivotId(8, "TS", 514), "");
+    ASSERT_TRUE(cachedConfig.getExchangeDefinitions().at("ID114562")->hasStation());
+    ASSERT_EQ(cachedConfig.getExchangeDefinitions().at("ID114562")->getStation(), 7);
+}
+
+TEST_F(PivotHNZPluginConfigCache, LoadMismatch)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    HnzPivotConfigCache::ConfigKey key = HnzPivotConfigCache::keyConfig(exchangedData);
+    HNZPivotConfig parsedConfig;
+    parsedConfig.importExchangeConfig(exchangedData);
+    HnzPivotConfigCache cache(path);
+
+    // No file yet
+    HNZPivotConfig cachedConfig;
+    ASSERT_FALSE(cache.load(cachedConfig, key));
+
+    ASSERT_TRUE(cache.save(parsedConfig, key));
+    // Each part of the key must match
+    HnzPivotConfigCache::ConfigKey otherHash = key;
+    otherHash.hash++;
+    ASSERT_FALSE(cache.load(cachedConfig, otherHash));
+    HnzPivotConfigCache::ConfigKey otherSize = key;
+    otherSize.size++;
+    ASSERT_FALSE(cache.load(cachedConfig, otherSize));
+    HnzPivotConfigCache::ConfigKey otherCheckHash = key;
+    otherCheckHash.checkHash++;
+    ASSERT_FALSE(cache.load(cachedConfig, otherCheckHash));
+    ASSERT_FALSE(cachedConfig.isComplete());
+    ASSERT_EQ(cachedConfig.getExchangeDefinitions().size(), 0);
+}
+
+TEST_F(PivotHNZPluginConfigCache, LoadCorrupted)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    HnzPivotConfigCache::ConfigKey key = HnzPivotConfigCache::keyConfig(exchangedData);
+    HNZPivotConfig parsedConfig;
+    parsedConfig.importExchangeConfig(exchangedData);
+    HnzPivotConfigCache cache(path);
+    ASSERT_TRUE(cache.save(parsedConfig, key));
+
+    std::string content;
+    {
+        std::ifstream file(path, std::ios::binary);
+        content.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    HNZPivotConfig cachedConfig;
+
+    // Flipped byte in the strings
+    std::string corrupted = content;
+    corrupted[corrupted.size() - 1] ^= 0x01;
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << corrupted;
+    ASSERT_FALSE(cache.load(cachedConfig, key));
+
+    // Truncated file
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content.substr(0, content.size() - 4);
+    ASSERT_FALSE(cache.load(cachedConfig, key));
+
+    // Shorter than the header
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << content.substr(0, 4);
+    ASSERT_FALSE(cache.load(cachedConfig, key));
+
+    ASSERT_EQ(cachedConfig.getExchangeDefinitions().size(), 0);
+}
+
+TEST_F(PivotHNZPluginConfigCache, ImportExchangeConfig)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    HnzPivotConfigCache cache(path);
+
+    HNZPivotConfig firstConfig;
+    ASSERT_FALSE(cache.importExchangeConfig(firstConfig, exchangedData));
+    ASSERT_TRUE(firstConfig.isComplete());
+    ASSERT_EQ(access(path.c_str(), F_OK), 0);
+
+    HNZPivotConfig secondConfig;
+    ASSERT_TRUE(cache.importExchangeConfig(secondConfig, exchangedData));
+    assertSameTables(firstConfig, secondConfig);
+
+    // A modified configuration is parsed and replaces the cache file
+    const std::string newExchangedData = HnzTrafficGenerator::generateExchangedData(20);
+    HNZPivotConfig thirdConfig;
+    ASSERT_FALSE(cache.importExchangeConfig(thirdConfig, newExchangedData));
+    ASSERT_EQ(thirdConfig.getExchangeDefinitions().size(), 20);
+    HNZPivotConfig fourthConfig;
+    ASSERT_TRUE(cache.importExchangeConfig(fourthConfig, newExchangedData));
+    assertSameTables(thirdConfig, fourthConfig);
+}
+
+TEST_F(PivotHNZPluginConfigCache, IncompleteConfigNotCached)
+{
+    HnzPivotConfigCache cache(path);
+    HNZPivotConfig config;
+    ASSERT_FALSE(cache.importExchangeConfig(config, QUOTE({
+        "exchanged_data" : {
+            "name" : "SAMPLE",
+            "version" : "1.0",
+            "datapoints" : [
+                {
+                    "label" : "TS1",
+                    "pivot_id" : "ID114562",
+                    "protocols" : [
+                        {
+                            "name" : "hnzip",
+                            "address" : "511",
+                            "typeid" : "TS"
+                        }
+                    ]
+                }
+            ]
+        }
+    })));
+    ASSERT_FALSE(config.isComplete());
+    ASSERT_NE(access(path.c_str(), F_OK), 0);
+}
+
+TEST_F(PivotHNZPluginConfigCache, PluginInit)
+{
+    const char* previousDataDir = getenv("FLEDGE_DATA");
+    std::string savedDataDir = previousDataDir != nullptr ? previousDataDir : "";
+    setenv("FLEDGE_DATA", directory.c_str(), 1);
+    std::string filterPath = HnzPivotConfigCache::defaultPath("hnztopivot");
+
+    // Disabled by default
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    PLUGIN_HANDLE handle = plugin_init(&config, nullptr, nullptr);
+    plugin_shutdown(handle);
+    ASSERT_NE(access(filterPath.c_str(), F_OK), 0);
+
+    config.setValue("config_cache", "true");
+    handle = plugin_init(&config, nullptr, nullptr);
+    plugin_shutdown(handle);
+    ASSERT_EQ(access(filterPath.c_str(), F_OK), 0);
+
+    remove(filterPath.c_str());
+    rmdir(filterPath.substr(0, filterPath.rfind('/')).c_str());
+    if (previousDataDir != nullptr) {
+        setenv("FLEDGE_DATA", savedDataDir.c_str(), 1);
+    }
+    else {
+        unsetenv("FLEDGE_DATA");
+    }
+}
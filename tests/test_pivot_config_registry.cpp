@@ -0,0 +1,159 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <thread>
+#include <plugin_api.h>
+#include <config_category.h>
+#include <filter.h>
+
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_config_cache.hpp"
+#include "hnz_pivot_config_registry.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_reconfigure(PLUGIN_HANDLE handle, const std::string& newConfig);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+};
+
+static std::shared_ptr<const HNZPivotConfig> getConfig(const std::string& exchangedData, int& buildCount)
+{
+    return HnzPivotConfigRegistry::get(exchangedData, HnzPivotConfigCache::keyConfig(exchangedData).hash,
+                                       [&](HNZPivotConfig& config) {
+        buildCount++;
+        config.importExchangeConfig(exchangedData);
+    });
+}
+
+TEST(PivotHNZPluginConfigRegistry, SharedConfig)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    const std::string otherExchangedData = HnzTrafficGenerator::generateExchangedData(11);
+    size_t initialCount = HnzPivotConfigRegistry::getConfigCount();
+    int buildCount = 0;
+
+    std::shared_ptr<const HNZPivotConfig> config = getConfig(exchangedData, buildCount);
+    ASSERT_EQ(buildCount, 1);
+    ASSERT_EQ(config->getExchangeDefinitions().size(), 10);
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 1);
+
+    // Same JSON, the configuration is not built again
+    std::shared_ptr<const HNZPivotConfig> sameConfig = getConfig(exchangedData, buildCount);
+    ASSERT_EQ(buildCount, 1);
+    ASSERT_EQ(sameConfig, config);
+
+    std::shared_ptr<const HNZPivotConfig> otherConfig = getConfig(otherExchangedData, buildCount);
+    ASSERT_EQ(buildCount, 2);
+    ASSERT_NE(otherConfig, config);
+    ASSERT_EQ(otherConfig->getExchangeDefinitions().size(), 11);
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 2);
+
+    // Configurations are released with their last user
+    config.reset();
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 2);
+    sameConfig.reset();
+    otherConfig.reset();
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount);
+
+    getConfig(exchangedData, buildCount);
+    ASSERT_EQ(buildCount, 3);
+}
+
+TEST(PivotHNZPluginConfigRegistry, HashCollision)
+{
+    // Same size, the hash given for the second JSON is the one of the first
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(10);
+    std::string otherExchangedData = exchangedData;
+    otherExchangedData.replace(otherExchangedData.find("\"P0\""), 4, "\"Q0\"");
+    uint64_t hash = HnzPivotConfigCache::keyConfig(exchangedData).hash;
+    size_t initialCount = HnzPivotConfigRegistry::getConfigCount();
+    int buildCount = 0;
+
+    std::shared_ptr<const HNZPivotConfig> config = HnzPivotConfigRegistry::get(exchangedData, hash, [&](HNZPivotConfig& newConfig) {
+        buildCount++;
+        newConfig.importExchangeConfig(exchangedData);
+    });
+    std::shared_ptr<const HNZPivotConfig> otherConfig = HnzPivotConfigRegistry::get(otherExchangedData, hash,
+                                                                                    [&](HNZPivotConfig& newConfig) {
+        buildCount++;
+        newConfig.importExchangeConfig(otherExchangedData);
+    });
+    ASSERT_EQ(buildCount, 2);
+    ASSERT_NE(config, otherConfig);
+    ASSERT_EQ(otherConfig->getExchangeDefinitions().at("ID100000")->getLabel(), "Q0");
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 2);
+}
+
+TEST(PivotHNZPluginConfigRegistry, ConcurrentBuilds)
+{
+    const std::string exchangedData = HnzTrafficGenerator::generateExchangedData(12);
+    const std::string otherExchangedData = HnzTrafficGenerator::generateExchangedData(13);
+    std::promise<void> otherBuilt;
+    std::future<void> otherBuiltFuture = otherBuilt.get_future();
+    std::atomic<int> buildCount{0};
+
+    // The first build waits for the build of another JSON, which would never happen if builds held the registry lock
+    std::future<std::shared_ptr<const HNZPivotConfig>> config = std::async(std::launch::async, [&]() {
+        return HnzPivotConfigRegistry::get(exchangedData, HnzPivotConfigCache::keyConfig(exchangedData).hash,
+                                           [&](HNZPivotConfig& newConfig) {
+            buildCount++;
+            otherBuiltFuture.wait_for(std::chrono::seconds(10));
+            newConfig.importExchangeConfig(exchangedData);
+        });
+    });
+    while (buildCount == 0) {
+        std::this_thread::yield();
+    }
+    auto start = std::chrono::steady_clock::now();
+    std::shared_ptr<const HNZPivotConfig> otherConfig = HnzPivotConfigRegistry::get(otherExchangedData,
+                                                                                    HnzPivotConfigCache::keyConfig(otherExchangedData).hash,
+                                                                                    [&](HNZPivotConfig& newConfig) {
+        buildCount++;
+        newConfig.importExchangeConfig(otherExchangedData);
+    });
+    otherBuilt.set_value();
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+    ASSERT_EQ(config.get()->getExchangeDefinitions().size(), 12);
+    ASSERT_EQ(otherConfig->getExchangeDefinitions().size(), 13);
+    ASSERT_EQ(buildCount, 2);
+}
+
+TEST(PivotHNZPluginConfigRegistry, FilterInstances)
+{
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(4));
+    size_t initialCount = HnzPivotConfigRegistry::getConfigCount();
+
+    PLUGIN_HANDLE firstHandle = plugin_init(&config, nullptr, nullptr);
+    PLUGIN_HANDLE secondHandle = plugin_init(&config, nullptr, nullptr);
+    auto firstFilter = static_cast<HNZPivotFilter*>(firstHandle);
+    auto secondFilter = static_cast<HNZPivotFilter*>(secondHandle);
+    ASSERT_EQ(firstFilter->getExchangeConfig(), secondFilter->getExchangeConfig());
+    ASSERT_EQ(firstFilter->getExchangeConfig()->getExchangeDefinitions().size(), 4);
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 1);
+
+    // The reconfigured instance gets its own configuration, the other one is not affected
+    std::shared_ptr<const HNZPivotConfig> sharedConfig = firstFilter->getExchangeConfig();
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(5));
+    plugin_reconfigure(secondHandle, config.toJSON());
+    ASSERT_EQ(firstFilter->getExchangeConfig(), sharedConfig);
+    ASSERT_EQ(sharedConfig->getExchangeDefinitions().size(), 4);
+    ASSERT_EQ(secondFilter->getExchangeConfig()->getExchangeDefinitions().size(), 5);
+    // Unchanged datapoints are shared by both configurations
+    ASSERT_EQ(secondFilter->getExchangeConfig()->getExchangeDefinitions().at("ID100000"),
+              sharedConfig->getExchangeDefinitions().at("ID100000"));
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 2);
+
+    sharedConfig.reset();
+    plugin_shutdown(firstHandle);
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount + 1);
+    plugin_shutdown(secondHandle);
+    ASSERT_EQ(HnzPivotConfigRegistry::getConfigCount(), initialCount);
+}
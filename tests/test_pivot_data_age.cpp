@@ -0,0 +1,154 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_data_age.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_object.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+TEST(PivotHNZDataAge, Record)
+{
+    HnzPivotDataAge dataAge;
+    dataAge.setThresholdMs(1000);
+    ASSERT_EQ(dataAge.getThresholdMs(), 1000);
+    HnzPivotDataAge::StationSnapshot snapshot;
+    ASSERT_FALSE(dataAge.getStationSnapshot(12, snapshot));
+
+    ASSERT_FALSE(dataAge.record(12, 10000, 10100));
+    ASSERT_FALSE(dataAge.record(12, 10000, 11000));
+    ASSERT_TRUE(dataAge.record(12, 10000, 15000));
+    // RTU clock ahead
+    ASSERT_FALSE(dataAge.record(12, 20000, 15000));
+    ASSERT_FALSE(dataAge.record(13, 10000, 10010));
+    ASSERT_EQ(dataAge.getStationCount(), 2);
+
+    ASSERT_TRUE(dataAge.getStationSnapshot(12, snapshot));
+    ASSERT_EQ(snapshot.age.count, 3);
+    ASSERT_EQ(snapshot.age.min, 100);
+    ASSERT_EQ(snapshot.age.max, 5000);
+    ASSERT_EQ(snapshot.overThreshold, 1);
+    ASSERT_EQ(snapshot.inFuture, 1);
+    ASSERT_TRUE(dataAge.getStationSnapshot(13, snapshot));
+    ASSERT_EQ(snapshot.age.count, 1);
+    ASSERT_EQ(snapshot.overThreshold, 0);
+
+    Datapoint* dp = dataAge.toDatapoint("data_age");
+    std::string json = dp->toJSONProperty();
+    delete dp;
+    ASSERT_NE(json.find("\"data_age\":{\"threshold_ms\":1000, \"stations\":{\"12\":{\"count\":3"), std::string::npos) << json;
+    ASSERT_NE(json.find("\"max_ms\":5000, \"over_threshold\":1, \"in_future\":1}"), std::string::npos) << json;
+    ASSERT_NE(json.find("\"13\":{\"count\":1"), std::string::npos) << json;
+
+    dataAge.reset();
+    ASSERT_EQ(dataAge.getStationCount(), 0);
+}
+
+TEST(PivotHNZDataAge, StationSlots)
+{
+    HNZPivotConfig config;
+    config.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":["
+        "{\"label\":\"TS1\",\"pivot_id\":\"ID1\",\"pivot_type\":\"SpsTyp\",\"protocols\":[{\"name\":\"hnzip\",\"station\":\"12\","
+        "\"address\":\"511\",\"typeid\":\"TS\"}]}]}}");
+    ASSERT_TRUE(config.isComplete());
+
+    HnzPivotDataAge dataAge;
+    dataAge.setThresholdMs(1000);
+    ASSERT_TRUE(dataAge.record(12, 10000, 15000));
+    dataAge.setConfig(config);
+    // Station of the configuration, and stations above the highest configured one
+    ASSERT_FALSE(dataAge.record(12, 10000, 10100));
+    ASSERT_FALSE(dataAge.record(13, 10000, 10100));
+    ASSERT_TRUE(dataAge.record(100000, 10000, 15000));
+    ASSERT_EQ(dataAge.getStationCount(), 3);
+    HnzPivotDataAge::StationSnapshot snapshot;
+    ASSERT_TRUE(dataAge.getStationSnapshot(12, snapshot));
+    ASSERT_EQ(snapshot.age.count, 2);
+    ASSERT_EQ(snapshot.overThreshold, 1);
+
+    dataAge.reset();
+    ASSERT_FALSE(dataAge.getStationSnapshot(12, snapshot));
+    ASSERT_FALSE(dataAge.record(12, 10000, 10100));
+    ASSERT_TRUE(dataAge.getStationSnapshot(12, snapshot));
+    ASSERT_EQ(snapshot.age.count, 1);
+}
+
+static std::string tsJson(int station, uint64_t ts, bool cg, bool tsIv)
+{
+    std::string json = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":" + std::to_string(station) +
+                       ",\"do_addr\":0,\"do_value\":1,\"do_valid\":0,\"do_outdated\":0";
+    if (cg) {
+        return json + ",\"do_cg\":1}}";
+    }
+    return json + ",\"do_cg\":0,\"do_ts\":" + std::to_string(ts) + ",\"do_ts_iv\":" + (tsIv ? "1" : "0") +
+           ",\"do_ts_c\":0,\"do_ts_s\":0}}";
+}
+
+using PivotHNZPluginDataAge = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginDataAge, FilterTSAge)
+{
+    m_config.setValue("statistics_period", "3600");
+    m_config.setValue("data_age_threshold", "2000");
+    m_config.setValue("data_age_flag", "true");
+    // P0 (TS, address 0, any station)
+    HNZPivotFilter* filter = initFilter(4);
+    const HnzPivotDataAge& dataAge = filter->getDataAge();
+    ASSERT_EQ(dataAge.getThresholdMs(), 2000);
+
+    uint64_t now = HnzPivotTimestamp::getCurrentTimestampMs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {
+        tsJson(12, now - 100, false, false),
+        tsJson(12, now - 60000, false, false), // over threshold
+        tsJson(12, now - 100, false, true),    // invalid timestamp, not recorded
+        tsJson(12, 0, true, false),            // TS CG, no timestamp
+        tsJson(13, now - 100, false, false)
+    })));
+
+    // Only the TS received late is flagged as old data
+    ASSERT_EQ(m_outputJsons.size(), 5);
+    for (size_t i = 0; i < m_outputJsons.size(); i++) {
+        ASSERT_EQ(m_outputJsons[i].find("\"oldData\":1") != std::string::npos, i == 1) << m_outputJsons[i];
+    }
+
+    HnzPivotDataAge::StationSnapshot snapshot;
+    ASSERT_TRUE(dataAge.getStationSnapshot(12, snapshot));
+    ASSERT_EQ(snapshot.age.count, 2);
+    ASSERT_GE(snapshot.age.min, 100);
+    ASSERT_GE(snapshot.age.max, 60000);
+    ASSERT_EQ(snapshot.overThreshold, 1);
+    ASSERT_TRUE(dataAge.getStationSnapshot(13, snapshot));
+    ASSERT_EQ(snapshot.age.count, 1);
+    ASSERT_EQ(snapshot.overThreshold, 0);
+
+    // Exported with the statistics
+    ASSERT_NE(m_lastStatisticsJson.find("\"data_age\":{\"threshold_ms\":2000, \"stations\":{\"12\":{\"count\":2"), std::string::npos)
+        << m_lastStatisticsJson;
+
+    // Invalid threshold is ignored
+    checkInvalidIgnored("data_age_threshold", "-1", [&dataAge]() { return dataAge.getThresholdMs(); });
+    ASSERT_TRUE(dataAge.getStationSnapshot(12, snapshot));
+
+    // A new threshold starts the stations over
+    m_config.setValue("data_age_threshold", "3000");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_EQ(dataAge.getThresholdMs(), 3000);
+    ASSERT_FALSE(dataAge.getStationSnapshot(12, snapshot));
+}
+
+TEST_F(PivotHNZPluginDataAge, FilterFlagDisabled)
+{
+    HNZPivotFilter* filter = initFilter(4);
+
+    // Counted as late, but not flagged by default
+    uint64_t now = HnzPivotTimestamp::getCurrentTimestampMs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS", {tsJson(12, now - 60000, false, false)})));
+    ASSERT_EQ(m_outputJsons.size(), 1);
+    ASSERT_EQ(m_outputJsons[0].find("\"oldData\""), std::string::npos) << m_outputJsons[0];
+    HnzPivotDataAge::StationSnapshot snapshot;
+    ASSERT_TRUE(filter->getDataAge().getStationSnapshot(12, snapshot));
+    ASSERT_EQ(snapshot.overThreshold, 1);
+}
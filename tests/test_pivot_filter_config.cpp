@@ -199,4 +199,321 @@ TEST(PivotHNZPluginConfig, PivotConfigReconfigure)
 	ASSERT_FALSE(testConfig.isComplete());
 	auto exchangeDefinitions2 = testConfig.getExchangeDefinitions();
 	ASSERT_EQ(exchangeDefinitions2.size(), 0);
-}
\ No newline at end of file
+}
+TEST(PivotHNZPluginConfig, PivotConfigMembersOrder)
+{
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig(QUOTE({
+		"comment" : {"datapoints" : [42]},
+		"exchanged_data" : {
+			"datapoints" : [
+				{
+					"protocols" : [
+						{
+							"typeid" : "M_SP_TB_1",
+							"name" : "iec104",
+							"address" : "45-672",
+							"extra" : {"name" : "hnzip", "list" : [1, {"a" : [2]}]}
+						},
+						{
+							"address" : "511",
+							"typeid" : "TS",
+							"name" : "hnzip"
+						}
+					],
+					"tags" : ["protocols", {"label" : 42}],
+					"pivot_type" : "SpsTyp",
+					"label" : "TS1",
+					"pivot_id" : "ID114562",
+					"label" : 42
+				}
+			],
+			"version" : "1.0",
+			"name" : "SAMPLE"
+		}
+	}));
+	ASSERT_TRUE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 1);
+	ASSERT_EQ(testConfig.findPivotId(0, "TS", 511), "ID114562");
+	auto dataPoint = testConfig.getExchangeDefinitions().at("ID114562");
+	ASSERT_EQ(dataPoint->getLabel(), "TS1");
+	ASSERT_EQ(dataPoint->getPivotType(), "SpsTyp");
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigDatapointNotObject)
+{
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig(QUOTE({
+		"exchanged_data" : {
+			"name" : "SAMPLE",
+			"version" : "1.0",
+			"datapoints" : [
+				{
+					"label" : "TS1",
+					"pivot_id" : "ID114562",
+					"pivot_type" : "SpsTyp",
+					"protocols" : [
+						{
+							"name" : "hnzip",
+							"address" : "511",
+							"typeid" : "TS"
+						}
+					]
+				},
+				42
+			]
+		}
+	}));
+	ASSERT_FALSE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 1);
+
+	testConfig.importExchangeConfig("[]");
+	ASSERT_FALSE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 0);
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigMsgAddressInvalid)
+{
+	HNZPivotConfig testConfig;
+	ASSERT_NO_THROW(testConfig.importExchangeConfig(QUOTE({
+		"exchanged_data" : {
+			"name" : "SAMPLE",
+			"version" : "1.0",
+			"datapoints" : [
+				{
+					"label" : "TS1",
+					"pivot_id" : "ID114562",
+					"pivot_type" : "SpsTyp",
+					"protocols" : [
+						{
+							"name" : "hnzip",
+							"address" : "aaa",
+							"typeid" : "TS"
+						}
+					]
+				}
+			]
+		}
+	})));
+	ASSERT_FALSE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 0);
+}
+
+static std::string twoPointsConfig(const std::string& tsLabel, const std::string& tmAddress)
+{
+	return "{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":["
+		"{\"label\":\"" + tsLabel + "\",\"pivot_id\":\"ID114562\",\"pivot_type\":\"SpsTyp\","
+		"\"protocols\":[{\"name\":\"hnzip\",\"address\":\"511\",\"typeid\":\"TS\"}]},"
+		"{\"label\":\"TM1\",\"pivot_id\":\"ID99876\",\"pivot_type\":\"MvTyp\","
+		"\"protocols\":[{\"name\":\"hnzip\",\"address\":\"" + tmAddress + "\",\"typeid\":\"TM\"}]}]}}";
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigApplyExchangeConfig)
+{
+	HNZPivotConfig testConfig;
+	HNZPivotConfig newConfig;
+	newConfig.importExchangeConfig(twoPointsConfig("TS1", "512"));
+	HNZPivotConfig::ExchangeChanges changes = testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(changes.added, 2);
+	ASSERT_EQ(changes.removed, 0);
+	ASSERT_TRUE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.findPivotId(0, "TM", 512), "ID99876");
+	std::shared_ptr<HNZPivotDataPoint> tsDataPoint = testConfig.getExchangeDefinitions().at("ID114562");
+	std::shared_ptr<HNZPivotDataPoint> tmDataPoint = testConfig.getExchangeDefinitions().at("ID99876");
+
+	// Only the TM address changes, the TS datapoint is kept as is
+	newConfig.importExchangeConfig(twoPointsConfig("TS1", "513"));
+	changes = testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(changes.added, 0);
+	ASSERT_EQ(changes.removed, 0);
+	ASSERT_EQ(changes.changed, 1);
+	ASSERT_EQ(changes.unchanged, 1);
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID114562"), tsDataPoint);
+	ASSERT_NE(testConfig.getExchangeDefinitions().at("ID99876"), tmDataPoint);
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID99876")->getAddress(), 513);
+	ASSERT_EQ(testConfig.findPivotId(0, "TM", 512), "");
+	ASSERT_EQ(testConfig.findPivotId(0, "TM", 513), "ID99876");
+
+	// Label change
+	newConfig.importExchangeConfig(twoPointsConfig("TS1_RENAMED", "513"));
+	changes = testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(changes.changed, 1);
+	ASSERT_EQ(changes.unchanged, 1);
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID114562")->getLabel(), "TS1_RENAMED");
+	ASSERT_EQ(testConfig.findPivotId(0, "TS", 511), "ID114562");
+
+	// An invalid configuration removes everything, as a full import does
+	newConfig.importExchangeConfig("invalid json config");
+	changes = testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(changes.removed, 2);
+	ASSERT_FALSE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 0);
+	ASSERT_EQ(testConfig.findPivotId(0, "TS", 511), "");
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigImportFromPrevious)
+{
+	HNZPivotConfig previousConfig;
+	previousConfig.importExchangeConfig(twoPointsConfig("TS1", "512"));
+	size_t tsIndex = previousConfig.findPointIndex("ID114562");
+	size_t tmIndex = previousConfig.findPointIndex("ID99876");
+
+	// Same pivotIds: the unchanged datapoint is shared and the point indexes are kept
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig(twoPointsConfig("TS1", "513"), previousConfig);
+	ASSERT_TRUE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID114562"), previousConfig.getExchangeDefinitions().at("ID114562"));
+	ASSERT_EQ(testConfig.findPointIndex("ID114562"), tsIndex);
+	ASSERT_EQ(testConfig.findPointIndex("ID99876"), tmIndex);
+	ASSERT_EQ(testConfig.getDataPoint(tmIndex)->getAddress(), 513);
+	ASSERT_EQ(testConfig.findPivotId(1, "TM", 513), "ID99876");
+	ASSERT_EQ(testConfig.findPivotId(1, "TM", 512), "");
+	// The previous configuration is left as is
+	ASSERT_EQ(previousConfig.getDataPoint(tmIndex)->getAddress(), 512);
+	ASSERT_EQ(previousConfig.findPivotId(1, "TM", 512), "ID99876");
+
+	// Definition added: the index is rebuilt
+	HNZPivotConfig addedConfig;
+	std::string threePoints = twoPointsConfig("TS1", "512");
+	threePoints.insert(threePoints.size() - 3, ",{\"label\":\"TC1\",\"pivot_id\":\"ID3\",\"pivot_type\":\"SpcTyp\","
+		"\"protocols\":[{\"name\":\"hnzip\",\"address\":\"142\",\"typeid\":\"TC\"}]}");
+	addedConfig.importExchangeConfig(threePoints, previousConfig);
+	ASSERT_TRUE(addedConfig.isComplete());
+	ASSERT_EQ(addedConfig.getPointCount(), 3);
+	ASSERT_EQ(addedConfig.getCommandCount(), 1);
+	ASSERT_NE(addedConfig.findCommand("ID3"), nullptr);
+	ASSERT_EQ(addedConfig.getDataPoint(addedConfig.findPointIndex("ID99876"))->getAddress(), 512);
+
+	// An invalid configuration removes everything
+	HNZPivotConfig invalidConfig;
+	invalidConfig.importExchangeConfig("invalid json config", previousConfig);
+	ASSERT_FALSE(invalidConfig.isComplete());
+	ASSERT_EQ(invalidConfig.getPointCount(), 0);
+	ASSERT_EQ(invalidConfig.findPointIndex("ID114562"), HnzPivotPerfectHash::NOT_FOUND);
+}
+
+static std::string stationPointConfig(const std::string& pivotId, const std::string& typeId, const std::string& address,
+									  const std::string& stationMember)
+{
+	return "{\"label\":\"" + pivotId + "\",\"pivot_id\":\"" + pivotId + "\",\"pivot_type\":\"SpsTyp\","
+		"\"protocols\":[{\"name\":\"hnzip\"," + stationMember + "\"address\":\"" + address + "\",\"typeid\":\"" + typeId + "\"}]}";
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigStation)
+{
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID1", "TS", "10", "\"station\":\"1\",") + "," +
+		stationPointConfig("ID2", "TS", "10", "\"station\":\"2\",") + "," +
+		stationPointConfig("ID3", "TS", "10", "") + "," +
+		stationPointConfig("ID4", "TM", "11", "\"station\":\"2\",") + "," +
+		stationPointConfig("ID5", "TS", "9", "\"station\":\"2\",") + "]}}");
+	ASSERT_TRUE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 5);
+	ASSERT_TRUE(testConfig.getExchangeDefinitions().at("ID2")->hasStation());
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID2")->getStation(), 2);
+	ASSERT_FALSE(testConfig.getExchangeDefinitions().at("ID3")->hasStation());
+
+	ASSERT_EQ(testConfig.findPivotId(1, "TS", 10), "ID1");
+	ASSERT_EQ(testConfig.findPivotId(2, "TS", 10), "ID2");
+	ASSERT_EQ(testConfig.findPivotId(2, "TS", 9), "ID5");
+	ASSERT_EQ(testConfig.findPivotId(2, "TM", 11), "ID4");
+	// Points configured without station match all stations
+	ASSERT_EQ(testConfig.findPivotId(3, "TS", 10), "ID3");
+	ASSERT_EQ(testConfig.findPivotId(1, "TM", 11), "");
+	ASSERT_EQ(testConfig.findPivotId(1, "TS", 9), "");
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigStationInvalid)
+{
+	for (const auto& stationMember : {"\"station\":\"abc\",", "\"station\":\"-1\",", "\"station\":\"1a\",",
+											 "\"station\":\"9999999999\",", "\"station\":12,"}) {
+		HNZPivotConfig testConfig;
+		testConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+			stationPointConfig("ID1", "TS", "10", stationMember) + "]}}");
+		ASSERT_FALSE(testConfig.isComplete()) << stationMember;
+		ASSERT_EQ(testConfig.getExchangeDefinitions().size(), 0) << stationMember;
+	}
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigCommandIndex)
+{
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID1", "TS", "10", "") + "," +
+		stationPointConfig("ID2", "TC", "11", "") + "," +
+		stationPointConfig("ID3", "TVC", "12", "") + "," +
+		stationPointConfig("ID4", "TM", "13", "") + "]}}");
+	ASSERT_TRUE(testConfig.isComplete());
+	ASSERT_EQ(testConfig.getCommandCount(), 2);
+	ASSERT_EQ(testConfig.findCommand("ID1"), nullptr);
+	ASSERT_EQ(testConfig.findCommand("ID4"), nullptr);
+	ASSERT_EQ(testConfig.findCommand("ID5"), nullptr);
+	ASSERT_NE(testConfig.findCommand("ID2"), nullptr);
+	ASSERT_EQ(testConfig.findCommand("ID2")->getAddress(), 11);
+	ASSERT_EQ(testConfig.findCommand("ID3")->getTypeId(), "TVC");
+
+	// The index follows the changes of the configuration
+	HNZPivotConfig newConfig;
+	newConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID2", "TC", "14", "") + "]}}");
+	testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(testConfig.getCommandCount(), 1);
+	ASSERT_EQ(testConfig.findCommand("ID3"), nullptr);
+	ASSERT_EQ(testConfig.findCommand("ID2")->getAddress(), 14);
+
+	// Same pivotIds: the point index is kept, the datapoint of the changed definition replaces the previous one
+	size_t pointIndex = testConfig.findPointIndex("ID2");
+	newConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID2", "TM", "14", "") + "]}}");
+	HNZPivotConfig::ExchangeChanges changes = testConfig.applyExchangeConfig(std::move(newConfig));
+	ASSERT_EQ(changes.changed, 1);
+	ASSERT_EQ(testConfig.findPointIndex("ID2"), pointIndex);
+	ASSERT_EQ(testConfig.getDataPoint(pointIndex)->getTypeId(), "TM");
+	ASSERT_EQ(testConfig.getCommandCount(), 0);
+	ASSERT_EQ(testConfig.findCommand("ID2"), nullptr);
+	ASSERT_EQ(testConfig.findPivotId(0, "TM", 14), "ID2");
+}
+
+TEST(PivotHNZPluginConfig, PivotConfigMapPointIndexes)
+{
+	HNZPivotConfig previousConfig;
+	previousConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID1", "TS", "10", "") + "," +
+		stationPointConfig("ID2", "TM", "11", "") + "," +
+		stationPointConfig("ID3", "TC", "12", "") + "]}}");
+	HNZPivotConfig testConfig;
+	testConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID1", "TS", "10", "") + "," +
+		stationPointConfig("ID2", "TM", "21", "") + "," +
+		stationPointConfig("ID4", "TS", "13", "") + "," +
+		stationPointConfig("ID5", "TS", "14", "") + "]}}");
+
+	// Unchanged datapoints are shared
+	testConfig.shareDataPoints(previousConfig);
+	ASSERT_EQ(testConfig.getExchangeDefinitions().at("ID1"), previousConfig.getExchangeDefinitions().at("ID1"));
+	ASSERT_NE(testConfig.getExchangeDefinitions().at("ID2"), previousConfig.getExchangeDefinitions().at("ID2"));
+	ASSERT_EQ(testConfig.getDataPoint(testConfig.findPointIndex("ID1")),
+			  previousConfig.getDataPoint(previousConfig.findPointIndex("ID1")));
+
+	std::vector<size_t> pointIndexes;
+	HNZPivotConfig::ExchangeChanges changes = testConfig.mapPointIndexes(previousConfig, pointIndexes);
+	ASSERT_EQ(changes.added, 2);
+	ASSERT_EQ(changes.removed, 1);
+	ASSERT_EQ(changes.changed, 1);
+	ASSERT_EQ(changes.unchanged, 1);
+	ASSERT_EQ(pointIndexes.size(), 3);
+	ASSERT_EQ(pointIndexes[previousConfig.findPointIndex("ID1")], testConfig.findPointIndex("ID1"));
+	ASSERT_EQ(pointIndexes[previousConfig.findPointIndex("ID2")], HnzPivotPerfectHash::NOT_FOUND);
+	ASSERT_EQ(pointIndexes[previousConfig.findPointIndex("ID3")], HnzPivotPerfectHash::NOT_FOUND);
+
+	// Equal datapoints that are not shared are unchanged too
+	HNZPivotConfig sameConfig;
+	sameConfig.importExchangeConfig("{\"exchanged_data\":{\"name\":\"SAMPLE\",\"version\":\"1.0\",\"datapoints\":[" +
+		stationPointConfig("ID1", "TS", "10", "") + "]}}");
+	changes = sameConfig.mapPointIndexes(previousConfig, pointIndexes);
+	ASSERT_EQ(changes.unchanged, 1);
+	ASSERT_EQ(changes.removed, 2);
+	ASSERT_EQ(changes.added, 0);
+	ASSERT_EQ(pointIndexes[previousConfig.findPointIndex("ID1")], sameConfig.findPointIndex("ID1"));
+}
@@ -0,0 +1,129 @@
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_histogram.hpp"
+#include "hnz_test_readings.hpp"
+
+extern "C" {
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+static void deleteOutputStream(OUTPUT_HANDLE * handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    delete readingSet;
+}
+
+TEST(PivotHNZPluginHistogram, BucketBounds)
+{
+    for (uint64_t value = 0; value < 100000; value++) {
+        unsigned index = HnzPivotHistogram::bucketIndex(value);
+        ASSERT_LT(index, HnzPivotHistogram::BUCKET_COUNT);
+        ASSERT_LE(HnzPivotHistogram::bucketLowerBound(index), value);
+        ASSERT_GE(HnzPivotHistogram::bucketUpperBound(index), value);
+    }
+    ASSERT_EQ(HnzPivotHistogram::bucketIndex(UINT64_MAX), HnzPivotHistogram::BUCKET_COUNT - 1);
+    ASSERT_EQ(HnzPivotHistogram::bucketUpperBound(HnzPivotHistogram::BUCKET_COUNT - 1), UINT64_MAX);
+    // Relative precision is bound by the number of sub-buckets
+    unsigned index = HnzPivotHistogram::bucketIndex(1000000);
+    uint64_t width = HnzPivotHistogram::bucketUpperBound(index) - HnzPivotHistogram::bucketLowerBound(index) + 1;
+    ASSERT_LE(width * HnzPivotHistogram::SUB_BUCKET_COUNT, 1000000);
+}
+
+TEST(PivotHNZPluginHistogram, RecordAndReset)
+{
+    HnzPivotHistogram histogram;
+    HnzPivotHistogram::Snapshot empty = histogram.snapshot();
+    ASSERT_EQ(empty.count, 0);
+    ASSERT_EQ(empty.percentile(50), 0);
+    ASSERT_EQ(empty.mean(), 0.0);
+
+    for (uint64_t value = 1; value <= 1000; value++) {
+        histogram.record(value);
+    }
+    HnzPivotHistogram::Snapshot snap = histogram.snapshot();
+    ASSERT_EQ(snap.count, 1000);
+    ASSERT_EQ(snap.sum, 500500);
+    ASSERT_EQ(snap.min, 1);
+    ASSERT_EQ(snap.max, 1000);
+    ASSERT_DOUBLE_EQ(snap.mean(), 500.5);
+    ASSERT_NEAR(snap.percentile(50), 500, 500 / HnzPivotHistogram::SUB_BUCKET_COUNT);
+    ASSERT_NEAR(snap.percentile(99), 990, 990 / HnzPivotHistogram::SUB_BUCKET_COUNT);
+    ASSERT_EQ(snap.percentile(100), 1000);
+
+    histogram.reset();
+    snap = histogram.snapshot();
+    ASSERT_EQ(snap.count, 0);
+    ASSERT_EQ(snap.min, 0);
+    ASSERT_EQ(snap.max, 0);
+}
+
+TEST(PivotHNZPluginHistogram, FilterStageLatencies)
+{
+    PLUGIN_HANDLE handle = nullptr;
+    ASSERT_NO_THROW(handle = plugin_init(nullptr, nullptr, deleteOutputStream));
+    auto filter = static_cast<HNZPivotFilter*>(handle);
+
+    std::string jsonMessageTSCE = QUOTE({
+        "data_object":{
+            "do_type":"TS",
+            "do_station":12,
+            "do_addr":511,
+            "do_value":1,
+            "do_valid":0,
+            "do_cg":0,
+            "do_outdated":0,
+            "do_ts": 1685019425432,
+            "do_ts_iv":0,
+            "do_ts_c":0,
+            "do_ts_s":0
+        }
+    });
+    ASSERT_NO_THROW(plugin_ingest(handle, HnzTestReadings::createReadingSet("TS1", {jsonMessageTSCE})));
+
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::DECODE).count, 1);
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::LOOKUP).count, 1);
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::PIVOT_BUILD).count, 1);
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::HNZ_DECODE).count, 0);
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::FORWARD).count, 1);
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::COMMAND).count, 0);
+
+    std::string jsonMessagePivot = QUOTE({
+        "PIVOT": {
+            "GTIC": {
+                "SpcTyp": {
+                    "q": {
+                        "Source": "process",
+                        "Validity": "good"
+                    },
+                    "t": {
+                        "FractionOfSecond": 9529458,
+                        "SecondSinceEpoch": 1669714185
+                    },
+                    "ctlVal": 1
+                },
+                "Identifier": "ID114562"
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_ingest(handle, HnzTestReadings::createReadingSet("PivotCommand", {jsonMessagePivot})));
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::HNZ_DECODE).count, 1);
+    // Not a command in the default configuration: nothing forwarded
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::COMMAND).count, 0);
+
+    filter->resetLatencyStats();
+    for (int i = 0; i < HNZPivotFilter::LATENCY_STAGE_COUNT; i++) {
+        auto stage = static_cast<HNZPivotFilter::LatencyStage>(i);
+        ASSERT_FALSE(HNZPivotFilter::latencyStageStr(stage).empty());
+        ASSERT_EQ(filter->getLatencySnapshot(stage).count, 0);
+    }
+
+    ASSERT_NO_THROW(plugin_shutdown(handle));
+}
@@ -0,0 +1,359 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_ingest_queue.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using Policy = HnzPivotIngestQueue::Policy;
+using Counter = HnzPivotIngestQueue::Counter;
+
+static ReadingSet* createReadingSet(int index)
+{
+    return HnzTestReadings::createReadingSet("R" + std::to_string(index), {QUOTE({"south_event":{"connx_status":"started"}})});
+}
+
+static int readingSetIndex(ReadingSet* readingSet)
+{
+    return std::stoi(readingSet->getAllReadings()[0]->getAssetName().substr(1));
+}
+
+static std::vector<int> popAll(HnzPivotIngestQueue& queue)
+{
+    std::vector<int> indexes;
+    ReadingSet* readingSet = nullptr;
+    while ((readingSet = queue.tryPop()) != nullptr) {
+        indexes.push_back(readingSetIndex(readingSet));
+        delete readingSet;
+    }
+    return indexes;
+}
+
+TEST(PivotHNZIngestQueue, Fifo)
+{
+    HnzPivotIngestQueue queue(4, Policy::BLOCK);
+    ASSERT_EQ(queue.tryPop(), nullptr);
+    // Several laps around the ring
+    for (int lap = 0; lap < 3; lap++) {
+        for (int i = 0; i < 4; i++) {
+            ASSERT_TRUE(queue.push(createReadingSet(lap * 4 + i)));
+        }
+        ASSERT_EQ(popAll(queue), std::vector<int>({lap * 4, lap * 4 + 1, lap * 4 + 2, lap * 4 + 3}));
+    }
+    ASSERT_EQ(queue.get(Counter::ENQUEUED), 12);
+    ASSERT_EQ(queue.get(Counter::BLOCKED), 0);
+}
+
+TEST(PivotHNZIngestQueue, DropNewest)
+{
+    HnzPivotIngestQueue queue(2, Policy::DROP_NEWEST);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(queue.push(createReadingSet(i)));
+    }
+    ASSERT_EQ(popAll(queue), std::vector<int>({0, 1}));
+    ASSERT_EQ(queue.get(Counter::ENQUEUED), 2);
+    ASSERT_EQ(queue.get(Counter::DROPPED_NEWEST), 3);
+    ASSERT_EQ(queue.get(Counter::DROPPED_OLDEST), 0);
+}
+
+TEST(PivotHNZIngestQueue, DropOldest)
+{
+    HnzPivotIngestQueue queue(2, Policy::DROP_OLDEST);
+    for (int i = 0; i < 5; i++) {
+        ASSERT_TRUE(queue.push(createReadingSet(i)));
+    }
+    ASSERT_EQ(popAll(queue), std::vector<int>({3, 4}));
+    ASSERT_EQ(queue.get(Counter::ENQUEUED), 5);
+    ASSERT_EQ(queue.get(Counter::DROPPED_OLDEST), 3);
+    ASSERT_EQ(queue.get(Counter::DROPPED_NEWEST), 0);
+}
+
+TEST(PivotHNZIngestQueue, Block)
+{
+    HnzPivotIngestQueue queue(1, Policy::BLOCK);
+    ASSERT_TRUE(queue.push(createReadingSet(0)));
+    std::atomic<bool> pushed(false);
+    std::thread producer([&]() {
+        queue.push(createReadingSet(1));
+        pushed = true;
+    });
+    // The producer waits until the first reading set is popped
+    while (queue.get(Counter::BLOCKED) == 0) {
+        std::this_thread::yield();
+    }
+    ASSERT_FALSE(pushed);
+    ReadingSet* readingSet = queue.pop();
+    ASSERT_EQ(readingSetIndex(readingSet), 0);
+    delete readingSet;
+    producer.join();
+    ASSERT_TRUE(pushed);
+    ASSERT_EQ(popAll(queue), std::vector<int>({1}));
+    ASSERT_EQ(queue.get(Counter::BLOCKED), 1);
+}
+
+TEST(PivotHNZIngestQueue, Close)
+{
+    HnzPivotIngestQueue queue(4, Policy::BLOCK);
+    ReadingSet* popped = nullptr;
+    std::thread consumer([&]() {
+        popped = queue.pop();
+    });
+    // A waiting consumer is woken up by close
+    queue.close();
+    consumer.join();
+    ASSERT_EQ(popped, nullptr);
+
+    HnzPivotIngestQueue closedQueue(4, Policy::BLOCK);
+    ASSERT_TRUE(closedQueue.push(createReadingSet(0)));
+    ASSERT_TRUE(closedQueue.push(createReadingSet(1)));
+    closedQueue.close();
+    ReadingSet* rejected = createReadingSet(2);
+    ASSERT_FALSE(closedQueue.push(rejected));
+    delete rejected;
+    // Reading sets queued before the queue was closed are still returned
+    for (int i = 0; i < 2; i++) {
+        ReadingSet* readingSet = closedQueue.pop();
+        ASSERT_NE(readingSet, nullptr);
+        ASSERT_EQ(readingSetIndex(readingSet), i);
+        delete readingSet;
+    }
+    ASSERT_EQ(closedQueue.pop(), nullptr);
+
+    // Reading sets left in the queue are deleted with it
+    HnzPivotIngestQueue leftQueue(4, Policy::BLOCK);
+    ASSERT_TRUE(leftQueue.push(createReadingSet(0)));
+}
+
+TEST(PivotHNZIngestQueue, CloseBlockedPush)
+{
+    HnzPivotIngestQueue queue(1, Policy::BLOCK);
+    ASSERT_TRUE(queue.push(createReadingSet(0)));
+    ReadingSet* rejected = createReadingSet(1);
+    std::atomic<bool> taken(true);
+    std::thread producer([&]() {
+        taken = queue.push(rejected);
+    });
+    while (queue.get(Counter::BLOCKED) == 0) {
+        std::this_thread::yield();
+    }
+    // A producer waiting for a free cell gives up when the queue is closed
+    queue.close();
+    producer.join();
+    ASSERT_FALSE(taken);
+    delete rejected;
+    ASSERT_EQ(popAll(queue), std::vector<int>({0}));
+}
+
+TEST(PivotHNZIngestQueue, ProducersConsumer)
+{
+    const int producerCount = 3;
+    const int readingSetsPerProducer = 2000;
+    HnzPivotIngestQueue queue(8, Policy::BLOCK);
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < producerCount; producer++) {
+        producers.emplace_back([&queue, producer, readingSetsPerProducer]() {
+            for (int i = 0; i < readingSetsPerProducer; i++) {
+                queue.push(createReadingSet(producer * readingSetsPerProducer + i));
+            }
+        });
+    }
+    std::vector<int> lastIndexes(producerCount, -1);
+    for (int received = 0; received < producerCount * readingSetsPerProducer; received++) {
+        ReadingSet* readingSet = queue.pop();
+        ASSERT_NE(readingSet, nullptr);
+        int index = readingSetIndex(readingSet);
+        delete readingSet;
+        // Reading sets of a producer are received in order
+        int producer = index / readingSetsPerProducer;
+        ASSERT_GT(index, lastIndexes[producer]);
+        lastIndexes[producer] = index;
+    }
+    for (auto& producer : producers) {
+        producer.join();
+    }
+    ASSERT_EQ(queue.tryPop(), nullptr);
+    ASSERT_EQ(queue.get(Counter::ENQUEUED), producerCount * readingSetsPerProducer);
+}
+
+TEST(PivotHNZIngestQueue, Policies)
+{
+    Policy policy = Policy::BLOCK;
+    ASSERT_TRUE(HnzPivotIngestQueue::policyFromStr("drop_oldest", policy));
+    ASSERT_EQ(policy, Policy::DROP_OLDEST);
+    ASSERT_TRUE(HnzPivotIngestQueue::policyFromStr("drop_newest", policy));
+    ASSERT_EQ(policy, Policy::DROP_NEWEST);
+    ASSERT_TRUE(HnzPivotIngestQueue::policyFromStr("block", policy));
+    ASSERT_EQ(policy, Policy::BLOCK);
+    ASSERT_FALSE(HnzPivotIngestQueue::policyFromStr("drop", policy));
+    ASSERT_EQ(policy, Policy::BLOCK);
+}
+
+using PivotHNZPluginAsyncIngest = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginAsyncIngest, ConvertedInOrder)
+{
+    m_config.setValue("async_ingest", "true");
+    m_config.setValue("async_queue_depth", "4");
+    m_config.setValue("statistics_period", "3600");
+    HNZPivotFilter* filter = initFilter(0);
+    ASSERT_NE(filter->getIngestQueue(), nullptr);
+    ASSERT_EQ(filter->getIngestQueue()->getDepth(), 4);
+    ASSERT_EQ(filter->getIngestQueue()->getPolicy(), Policy::BLOCK);
+
+    const int readingSetCount = 200;
+    for (int i = 0; i < readingSetCount; i++) {
+        plugin_ingest(m_handle, createReadingSet(i));
+    }
+    std::shared_ptr<const HnzPivotIngestQueue> ingestQueue = filter->getIngestQueue();
+    // Shutdown waits for the queued reading sets to be converted and forwarded
+    shutdownFilter();
+
+    ASSERT_EQ(ingestQueue->get(Counter::ENQUEUED), readingSetCount);
+    std::vector<std::string> outputAssets = getOutputAssets();
+    ASSERT_EQ(outputAssets.size(), readingSetCount);
+    for (int i = 0; i < readingSetCount; i++) {
+        ASSERT_EQ(outputAssets[i], "R" + std::to_string(i));
+    }
+    for (const auto& threadId : m_outputThreads) {
+        ASSERT_NE(threadId, std::this_thread::get_id());
+    }
+    ASSERT_NE(m_lastStatisticsJson.find("\"ingest_queue\":{\"depth\":4"), std::string::npos) << m_lastStatisticsJson;
+}
+
+TEST_F(PivotHNZPluginAsyncIngest, Reconfigure)
+{
+    HNZPivotFilter* filter = initFilter(0);
+    ASSERT_EQ(filter->getIngestQueue(), nullptr);
+    plugin_ingest(m_handle, createReadingSet(0));
+
+    m_config.setValue("async_ingest", "true");
+    m_config.setValue("async_backpressure", "drop_newest");
+    reconfigure();
+    std::shared_ptr<const HnzPivotIngestQueue> ingestQueue = filter->getIngestQueue();
+    ASSERT_NE(ingestQueue, nullptr);
+    ASSERT_EQ(ingestQueue->getPolicy(), Policy::DROP_NEWEST);
+    ASSERT_EQ(ingestQueue->getDepth(), 64);
+    plugin_ingest(m_handle, createReadingSet(1));
+
+    // Same settings, the queue is kept
+    reconfigure();
+    ASSERT_EQ(filter->getIngestQueue(), ingestQueue);
+
+    // Invalid settings are ignored
+    checkInvalidIgnored("async_queue_depth", "0", [filter]() { return filter->getIngestQueue(); });
+    checkInvalidIgnored("async_backpressure", "drop", [filter]() { return filter->getIngestQueue(); });
+
+    m_config.setValue("async_queue_depth", "16");
+    reconfigure();
+    ASSERT_NE(filter->getIngestQueue(), ingestQueue);
+    ASSERT_EQ(filter->getIngestQueue()->getDepth(), 16);
+    plugin_ingest(m_handle, createReadingSet(2));
+
+    // Back to synchronous mode: the reading sets queued before are forwarded first
+    m_config.setValue("async_ingest", "false");
+    reconfigure();
+    ASSERT_EQ(filter->getIngestQueue(), nullptr);
+    plugin_ingest(m_handle, createReadingSet(3));
+    ASSERT_EQ(getOutputAssets(), std::vector<std::string>({"R0", "R1", "R2", "R3"}));
+    {
+        std::lock_guard<std::mutex> guard(m_outputMutex);
+        ASSERT_EQ(m_outputThreads.back(), std::this_thread::get_id());
+    }
+}
+
+TEST_F(PivotHNZPluginAsyncIngest, CommandsNotQueued)
+{
+    m_config.setValue("async_ingest", "true");
+    m_config.setValue("async_queue_depth", "1");
+    m_config.setValue("async_backpressure", "drop_newest");
+    // P2 (TC, ID100002, address 2)
+    HNZPivotFilter* filter = initFilter(4);
+    std::shared_ptr<const HnzPivotIngestQueue> ingestQueue = filter->getIngestQueue();
+
+    const std::string commandJson = QUOTE({"PIVOT":{"GTIC":{"SpcTyp":{"q":{"Source":"process","Validity":"good"},
+        "t":{"FractionOfSecond":9529458,"SecondSinceEpoch":1669714185},"ctlVal":1},"Identifier":"ID100002"}}});
+    std::vector<Reading*> readings;
+    readings.push_back(HnzTestReadings::createReading("R0", {QUOTE({"south_event":{"connx_status":"started"}})}));
+    readings.push_back(HnzTestReadings::createReading("PivotCommand", {commandJson}));
+    plugin_ingest(m_handle, HnzTestReadings::createReadingSet(readings));
+    // Commands are forwarded by the caller before the rest of the reading set is queued
+    std::vector<std::string> outputAssets = getOutputAssets();
+    ASSERT_FALSE(outputAssets.empty());
+    ASSERT_EQ(outputAssets[0], "HNZCommand");
+    {
+        std::lock_guard<std::mutex> guard(m_outputMutex);
+        ASSERT_EQ(m_outputThreads[0], std::this_thread::get_id());
+    }
+    // Reading sets only holding commands are not queued, whatever the queue policy
+    for (int i = 0; i < 10; i++) {
+        plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {commandJson}));
+    }
+    shutdownFilter();
+
+    ASSERT_EQ(ingestQueue->get(Counter::ENQUEUED) + ingestQueue->get(Counter::DROPPED_NEWEST), 1);
+    outputAssets = getOutputAssets();
+    ASSERT_EQ(std::count(outputAssets.begin(), outputAssets.end(), "HNZCommand"), 11);
+    ASSERT_EQ(std::count(outputAssets.begin(), outputAssets.end(), "R0"), 1);
+}
+
+/*
+ * The next filter blocks on the first south event until the test releases it
+ */
+class PivotHNZPluginAsyncSlowForward : public HnzFilterFixture
+{
+protected:
+    static void blockingOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+    {
+        if (readingSet->getAllReadings()[0]->getAssetName() == "R0") {
+            s_forwardBlocked = true;
+            while (!s_forwardReleased) {
+                std::this_thread::yield();
+            }
+        }
+        outputStream(handle, readingSet);
+    }
+
+    static std::atomic<bool> s_forwardBlocked;
+    static std::atomic<bool> s_forwardReleased;
+};
+
+std::atomic<bool> PivotHNZPluginAsyncSlowForward::s_forwardBlocked(false);
+std::atomic<bool> PivotHNZPluginAsyncSlowForward::s_forwardReleased(false);
+
+TEST_F(PivotHNZPluginAsyncSlowForward, CommandsNotBlocked)
+{
+    s_forwardBlocked = false;
+    s_forwardReleased = false;
+    m_config.setValue("async_ingest", "true");
+    // P2 (TC, ID100002, address 2)
+    m_config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(4));
+    m_handle = plugin_init(&m_config, this, blockingOutputStream);
+    plugin_ingest(m_handle, createReadingSet(0));
+    while (!s_forwardBlocked) {
+        std::this_thread::yield();
+    }
+
+    // The conversion thread waits for the next filter, the commands are forwarded meanwhile
+    const std::string commandJson = QUOTE({"PIVOT":{"GTIC":{"SpcTyp":{"q":{"Source":"process","Validity":"good"},
+        "t":{"FractionOfSecond":9529458,"SecondSinceEpoch":1669714185},"ctlVal":1},"Identifier":"ID100002"}}});
+    std::future<void> commandIngested = std::async(std::launch::async, [this, &commandJson]() {
+        plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {commandJson}));
+    });
+    std::future_status status = commandIngested.wait_for(std::chrono::seconds(5));
+    s_forwardReleased = true;
+    commandIngested.get();
+    ASSERT_EQ(status, std::future_status::ready);
+    shutdownFilter();
+    ASSERT_EQ(getOutputAssets(), std::vector<std::string>({"HNZCommand", "R0"}));
+}
@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_object.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+TEST(PivotHNZJsonOutput, JsonObject)
+{
+    HnzPivotJsonFragments fragments = HnzPivotJsonFragments::build("GTIM", "ID\"1", "MvTyp");
+    ASSERT_EQ(fragments.lnOpen, "{\"GTIM\":{\"Identifier\":\"ID\\\"1\"");
+    ASSERT_EQ(fragments.cdcOpen, "\"MvTyp\":{");
+
+    HnzPivotObject pivot("GTIM", "MvTyp", false, &fragments);
+    pivot.setIdentifier("ignored");
+    pivot.setCause(1);
+    pivot.setMagI(-42);
+    pivot.addQuality(0, true, false, true);
+    pivot.addTimestamp(1685019425432, true);
+    pivot.addTmOrg(true);
+    pivot.addTmValidity(false);
+    Datapoint* dp = pivot.toDatapoint();
+    ASSERT_EQ(dp->getName(), "PIVOT_JSON");
+    ASSERT_EQ(dp->getData().getType(), DatapointValue::T_STRING);
+    ASSERT_EQ(dp->getData().toStringValue(),
+              "{\"GTIM\":{\"Identifier\":\"ID\\\"1\",\"ComingFrom\":\"hnzip\",\"Cause\":{\"stVal\":1},"
+              "\"TmOrg\":{\"stVal\":\"substituted\"},\"TmValidity\":{\"stVal\":\"good\"},"
+              "\"MvTyp\":{\"mag\":{\"i\":-42},\"q\":{\"Validity\":\"questionable\",\"DetailQuality\":{\"oldData\":1}},"
+              "\"t\":{\"SecondSinceEpoch\":1685019425,\"FractionOfSecond\":7247757,\"TimeQuality\":{\"clockNotSynchronized\":1}}}}}");
+    delete dp;
+
+    // The compact profile applies to the JSON output too
+    HnzPivotObject compact("GTIM", "MvTyp", true, &fragments);
+    compact.setCause(1);
+    compact.setMagI(3);
+    compact.addQuality(0, false, false, false);
+    compact.addTmOrg(false);
+    compact.addTmValidity(false);
+    dp = compact.toDatapoint();
+    ASSERT_EQ(dp->getData().toStringValue(),
+              "{\"GTIM\":{\"Identifier\":\"ID\\\"1\",\"Cause\":{\"stVal\":1},\"MvTyp\":{\"mag\":{\"i\":3}}}}");
+    delete dp;
+}
+
+static std::string pivotJsonOf(Reading* reading)
+{
+    std::vector<Datapoint*>& datapoints = reading->getReadingData();
+    if ((datapoints.size() != 1) || (datapoints[0]->getName() != "PIVOT_JSON")) {
+        return "";
+    }
+    return datapoints[0]->getData().toStringValue();
+}
+
+using PivotHNZPluginJsonOutput = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginJsonOutput, FilterJsonFormat)
+{
+    m_config.setValue("output_format", "json");
+    HNZPivotFilter* filter = initFilter(4);
+    ASSERT_TRUE(filter->isJsonOutput());
+
+    const std::string tsJson = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":1,\"do_valid\":0,"
+                               "\"do_cg\":0,\"do_outdated\":0,\"do_ts\":1685019425432,\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+    const std::string tmJson = "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,\"do_value\":42,\"do_valid\":0,"
+                               "\"do_an\":\"TMA\",\"do_outdated\":0}}";
+    const std::string tcAckJson = "{\"data_object\":{\"do_type\":\"TC\",\"do_station\":12,\"do_addr\":2,\"do_valid\":0}}";
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P", {tsJson, tmJson, tcAckJson})));
+    ASSERT_EQ(m_outputReadings.size(), 3);
+    ASSERT_EQ(pivotJsonOf(m_outputReadings[0]),
+              "{\"GTIS\":{\"Identifier\":\"ID100000\",\"ComingFrom\":\"hnzip\",\"Cause\":{\"stVal\":3},"
+              "\"TmOrg\":{\"stVal\":\"genuine\"},\"TmValidity\":{\"stVal\":\"good\"},"
+              "\"SpsTyp\":{\"stVal\":1,\"q\":{\"Validity\":\"good\"},"
+              "\"t\":{\"SecondSinceEpoch\":1685019425,\"FractionOfSecond\":7247757}}}}") << m_outputReadings[0]->toJSON();
+    std::string pivotJson = pivotJsonOf(m_outputReadings[1]);
+    ASSERT_EQ(pivotJson.find("{\"GTIM\":{\"Identifier\":\"ID100001\","), 0) << pivotJson;
+    ASSERT_NE(pivotJson.find("\"MvTyp\":{\"mag\":{\"i\":42}"), std::string::npos) << pivotJson;
+    pivotJson = pivotJsonOf(m_outputReadings[2]);
+    ASSERT_EQ(pivotJson.find("{\"GTIC\":{\"Identifier\":\"ID100002\","), 0) << pivotJson;
+    ASSERT_NE(pivotJson.find("\"Confirmation\":{\"stVal\":0}"), std::string::npos) << pivotJson;
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    ASSERT_EQ(statistics.get(HnzPivotStatistics::DataType::TS, HnzPivotStatistics::Counter::CONVERTED), 1);
+
+    // Invalid format is ignored, back to the datapoint format
+    checkInvalidIgnored("output_format", "xml", [filter]() { return filter->isJsonOutput(); });
+    m_config.setValue("output_format", "datapoint");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(filter->isJsonOutput());
+    clearOutputs();
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P0", {tsJson})));
+    ASSERT_EQ(m_outputReadings.size(), 1);
+    ASSERT_EQ(m_outputReadings[0]->getReadingData()[0]->getName(), "PIVOT");
+}
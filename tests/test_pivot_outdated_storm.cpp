@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_outdated_storm.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+TEST(PivotHNZOutdatedStorm, DetectStorms)
+{
+    HNZPivotConfig config;
+    // P0 TS, P1 TM, P2 TC, P3 TVC, P4 TS, P5 TM, P6 TC, P7 TVC
+    config.importExchangeConfig(HnzTrafficGenerator::generateExchangedData(8));
+    HnzPivotOutdatedStorm outdatedStorm;
+    ASSERT_FALSE(outdatedStorm.isEnabled());
+    outdatedStorm.setRatio(75);
+    outdatedStorm.setConfig(config);
+    ASSERT_TRUE(outdatedStorm.isEnabled());
+    ASSERT_EQ(outdatedStorm.getMonitoringPointCount(12), 4);
+
+    auto point = [&config](unsigned int address, const std::string& typeId) {
+        size_t pointIndex = config.findPointIndex(config.findPivotId(0, typeId, address));
+        return HnzPivotOutdatedStorm::Point{nullptr, nullptr, config.getDataPoint(pointIndex), pointIndex};
+    };
+    // 3 of the 4 points of station 12, 2 of station 13, 3 of station 14 split by validity
+    outdatedStorm.addPoint(12, false, point(0, "TS"));
+    outdatedStorm.addPoint(12, false, point(1, "TM"));
+    outdatedStorm.addPoint(12, false, point(4, "TS"));
+    outdatedStorm.addPoint(13, false, point(0, "TS"));
+    outdatedStorm.addPoint(13, false, point(1, "TM"));
+    outdatedStorm.addPoint(14, false, point(0, "TS"));
+    outdatedStorm.addPoint(14, true, point(1, "TM"));
+    outdatedStorm.addPoint(14, true, point(4, "TS"));
+
+    std::vector<HnzPivotOutdatedStorm::Storm> storms;
+    outdatedStorm.takeStorms(storms);
+    ASSERT_EQ(storms.size(), 1);
+    ASSERT_EQ(storms[0].station, 12);
+    ASSERT_FALSE(storms[0].invalid);
+    ASSERT_EQ(storms[0].points.size(), 3);
+
+    Datapoint* dp = HnzPivotOutdatedStorm::toDatapoint(storms[0], 1685019425432);
+    std::string json = dp->toJSONProperty();
+    delete dp;
+    ASSERT_EQ(json, "\"station_quality\":{\"station\":12, \"q\":{\"Validity\":\"questionable\", \"DetailQuality\":{\"oldData\":1}}, "
+                    "\"t\":{\"SecondSinceEpoch\":1685019425, \"FractionOfSecond\":7247757}, "
+                    "\"points\":{\"ID100000\":\"SpsTyp\", \"ID100001\":\"MvTyp\", \"ID100004\":\"SpsTyp\"}}");
+
+    // Points are forgotten once the storms are taken
+    storms.clear();
+    outdatedStorm.takeStorms(storms);
+    ASSERT_TRUE(storms.empty());
+
+    // A single outdated point is never a storm
+    outdatedStorm.setRatio(1);
+    outdatedStorm.addPoint(12, false, point(0, "TS"));
+    outdatedStorm.takeStorms(storms);
+    ASSERT_TRUE(storms.empty());
+}
+
+static std::string outdatedJson(const std::string& type, int station, int address)
+{
+    return "{\"data_object\":{\"do_type\":\"" + type + "\",\"do_station\":" + std::to_string(station) +
+           ",\"do_addr\":" + std::to_string(address) + ",\"do_valid\":0,\"do_cg\":0,\"do_an\":\"TMA\",\"do_outdated\":1}}";
+}
+
+using PivotHNZPluginOutdatedStorm = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginOutdatedStorm, FilterCompressStorm)
+{
+    m_config.setValue("outdated_storm_ratio", "75");
+    HNZPivotFilter* filter = initFilter(8);
+    ASSERT_EQ(filter->getOutdatedStorm().getRatio(), 75);
+
+    std::vector<Reading*> readings;
+    // Value received before the link loss
+    readings.push_back(HnzTestReadings::createReading("P1", {"{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,"
+                                                            "\"do_value\":5,\"do_valid\":0,\"do_an\":\"TMA\",\"do_outdated\":0}}"}));
+    // Station 12 lost its link, only one point of station 13 is outdated
+    for (int address : {0, 1, 4, 5}) {
+        readings.push_back(HnzTestReadings::createReading("P", {outdatedJson(address % 4 == 0 ? "TS" : "TM", 12, address)}));
+    }
+    readings.push_back(HnzTestReadings::createReading("P0", {outdatedJson("TS", 13, 0)}));
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet(readings)));
+
+    // The station quality event takes the place of the storm, between the readings before and after it
+    ASSERT_EQ(m_outputReadings.size(), 3);
+    ASSERT_NE(m_outputReadings[0]->toJSON().find("\"GTIM\""), std::string::npos) << m_outputReadings[0]->toJSON();
+    ASSERT_EQ(m_outputReadings[1]->getAssetName(), STATION_QUALITY_ASSET_NAME);
+    ASSERT_NE(m_outputReadings[2]->toJSON().find("\"GTIS\""), std::string::npos) << m_outputReadings[2]->toJSON();
+    std::string stationJson = m_outputReadings[1]->toJSON();
+    ASSERT_NE(stationJson.find("\"station\":12, \"q\":{\"Validity\":\"questionable\", \"DetailQuality\":{\"oldData\":1}}"),
+              std::string::npos) << stationJson;
+    ASSERT_NE(stationJson.find("\"points\":{\"ID100000\":\"SpsTyp\", \"ID100001\":\"MvTyp\", \"ID100004\":\"SpsTyp\", \"ID100005\":\"MvTyp\"}"),
+              std::string::npos) << stationJson;
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    ASSERT_EQ(statistics.get(HnzPivotStatistics::DataType::TS, HnzPivotStatistics::Counter::CONVERTED), 3);
+    ASSERT_EQ(statistics.get(HnzPivotStatistics::DataType::TM, HnzPivotStatistics::Counter::CONVERTED), 3);
+
+    // Invalid ratio is ignored
+    checkInvalidIgnored("outdated_storm_ratio", "101", [filter]() { return filter->getOutdatedStorm().getRatio(); });
+    m_config.setValue("outdated_storm_ratio", "0");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(filter->getOutdatedStorm().isEnabled());
+    clearOutputs();
+    // Disabled, the outdated data_objects are all converted
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet({HnzTestReadings::createReading("P", {
+        outdatedJson("TS", 12, 0), outdatedJson("TM", 12, 1), outdatedJson("TS", 12, 4), outdatedJson("TM", 12, 5)
+    })})));
+    ASSERT_EQ(m_outputReadings.size(), 1);
+    ASSERT_EQ(m_outputReadings[0]->getReadingData().size(), 4);
+}
+
+TEST_F(PivotHNZPluginOutdatedStorm, FilterStormForgetsChatter)
+{
+    m_config.setValue("outdated_storm_ratio", "50");
+    m_config.setValue("chatter_max_transitions", "1");
+    m_config.setValue("chatter_window", "60000");
+    HNZPivotFilter* filter = initFilter(4);
+
+    std::vector<std::string> transitions;
+    for (int i = 0; i < 3; i++) {
+        transitions.push_back("{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":" +
+                              std::to_string(i % 2) + ",\"do_valid\":0,\"do_cg\":0,\"do_outdated\":0,\"do_ts\":" +
+                              std::to_string(1685019425432 + i) + ",\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}");
+    }
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P0", transitions)));
+    ASSERT_EQ(filter->getChatterFilter().getChatteringCount(), 1);
+
+    // Like the TM aggregates, the transition suppressed before the link loss is forgotten
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P", {outdatedJson("TS", 12, 0), outdatedJson("TM", 12, 1)})));
+    ASSERT_EQ(m_outputReadings.back()->getAssetName(), STATION_QUALITY_ASSET_NAME);
+    ASSERT_EQ(filter->getChatterFilter().getChatteringCount(), 0);
+}
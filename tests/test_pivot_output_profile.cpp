@@ -0,0 +1,73 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_object.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+TEST(PivotHNZOutputProfile, CompactObjectReadBack)
+{
+    HnzPivotObject compact("GTIC", "SpcTyp", true);
+    compact.setIdentifier("ID1");
+    compact.setCause(7);
+    compact.addQuality(0, false, false, false);
+    compact.addTimestamp(1685019425432, false);
+    compact.addTmOrg(false);
+    compact.addTmValidity(false);
+    Datapoint* dp = compact.toDatapoint();
+    ASSERT_EQ(dp->toJSONProperty(), "\"PIVOT\":{\"GTIC\":{\"SpcTyp\":{"
+                                    "\"t\":{\"SecondSinceEpoch\":1685019425, \"FractionOfSecond\":7247757}}, "
+                                    "\"Identifier\":\"ID1\", \"Cause\":{\"stVal\":7}}}");
+
+    // Omitted fields are read back with their default value
+    HnzPivotObject readBack(dp);
+    ASSERT_EQ(readBack.getIdentifier(), "ID1");
+    ASSERT_EQ(readBack.getValidity(), HnzPivotObject::HnzValidity::GOOD);
+    ASSERT_FALSE(readBack.OldData());
+    ASSERT_FALSE(readBack.IsTimestampSubstituted());
+    ASSERT_FALSE(readBack.IsTimestampInvalid());
+    delete dp;
+
+    // Fields differing from their default are kept
+    HnzPivotObject degraded("GTIM", "MvTyp", true);
+    degraded.addQuality(1, true, false, false);
+    degraded.addTmOrg(true);
+    degraded.addTmValidity(true);
+    dp = degraded.toDatapoint();
+    std::string json = dp->toJSONProperty();
+    delete dp;
+    ASSERT_NE(json.find("\"q\":{\"Validity\":\"invalid\", \"DetailQuality\":{\"oldData\":1}}"), std::string::npos) << json;
+    ASSERT_NE(json.find("\"TmOrg\":{\"stVal\":\"substituted\"}"), std::string::npos) << json;
+    ASSERT_NE(json.find("\"TmValidity\":{\"stVal\":\"invalid\"}"), std::string::npos) << json;
+    ASSERT_EQ(json.find("ComingFrom"), std::string::npos) << json;
+}
+
+using PivotHNZPluginOutputProfile = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginOutputProfile, FilterCompactProfile)
+{
+    m_config.setValue("output_profile", "compact");
+    HNZPivotFilter* filter = initFilter(4);
+    ASSERT_TRUE(filter->isCompactOutput());
+
+    const std::string tsJson = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":12,\"do_addr\":0,\"do_value\":1,\"do_valid\":0,"
+                               "\"do_cg\":0,\"do_outdated\":0,\"do_ts\":1685019425432,\"do_ts_iv\":0,\"do_ts_c\":0,\"do_ts_s\":0}}";
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P0", {tsJson})));
+    ASSERT_EQ(m_outputJsons.size(), 1);
+    ASSERT_NE(m_outputJsons[0].find("\"PIVOT\":{\"GTIS\":{\"SpsTyp\":{\"stVal\":1, \"t\":{\"SecondSinceEpoch\":1685019425, "
+                                  "\"FractionOfSecond\":7247757}}, \"Identifier\":\"ID100000\", \"Cause\":{\"stVal\":3}}}"),
+              std::string::npos) << m_outputJsons[0];
+
+    // Invalid profile is ignored, back to the full profile
+    checkInvalidIgnored("output_profile", "tiny", [filter]() { return filter->isCompactOutput(); });
+    m_config.setValue("output_profile", "full");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(filter->isCompactOutput());
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("P0", {tsJson})));
+    ASSERT_EQ(m_outputJsons.size(), 2);
+    ASSERT_NE(m_outputJsons[1].find("\"ComingFrom\":\"hnzip\""), std::string::npos) << m_outputJsons[1];
+    ASSERT_NE(m_outputJsons[1].find("\"TmOrg\":{\"stVal\":\"genuine\"}"), std::string::npos) << m_outputJsons[1];
+}
@@ -0,0 +1,104 @@
+#include <gtest/gtest.h>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_perfect_hash.hpp"
+#include "hnz_traffic_generator.hpp"
+
+static std::vector<std::string> generatePivotIds(size_t count)
+{
+    std::vector<std::string> pivotIds;
+    for (size_t i = 0; i < count; i++) {
+        pivotIds.push_back("ID" + std::to_string(100000 + i));
+    }
+    return pivotIds;
+}
+
+static std::vector<const std::string*> keysOf(const std::vector<std::string>& pivotIds)
+{
+    std::vector<const std::string*> keys;
+    for (const auto& pivotId : pivotIds) {
+        keys.push_back(&pivotId);
+    }
+    return keys;
+}
+
+TEST(PivotHNZPerfectHash, BuildAndFind)
+{
+    for (size_t count : {1, 2, 3, 10, 1000, 20000}) {
+        std::vector<std::string> pivotIds = generatePivotIds(count);
+        HnzPivotPerfectHash perfectHash;
+        ASSERT_TRUE(perfectHash.build(keysOf(pivotIds)));
+        ASSERT_EQ(perfectHash.size(), count);
+        std::set<size_t> slots;
+        for (const auto& pivotId : pivotIds) {
+            size_t slot = perfectHash.getSlot(pivotId);
+            ASSERT_LT(slot, count);
+            slots.insert(slot);
+        }
+        // Minimal: each slot is used by exactly one key
+        ASSERT_EQ(slots.size(), count);
+    }
+}
+
+TEST(PivotHNZPerfectHash, KeyLengths)
+{
+    // Keys shorter, equal and longer than a word, and keys that only differ by their last byte
+    std::vector<std::string> pivotIds = {"", "a", "ab", "ID1", "ID12345", "ID123456", "ID1234567",
+                                         "ID12345678901234", "ID12345678901235", "ID123456789012345"};
+    HnzPivotPerfectHash perfectHash;
+    ASSERT_TRUE(perfectHash.build(keysOf(pivotIds)));
+    std::set<size_t> slots;
+    for (const auto& pivotId : pivotIds) {
+        size_t slot = perfectHash.getSlot(pivotId);
+        ASSERT_LT(slot, pivotIds.size());
+        slots.insert(slot);
+    }
+    ASSERT_EQ(slots.size(), pivotIds.size());
+}
+
+TEST(PivotHNZPerfectHash, Empty)
+{
+    HnzPivotPerfectHash perfectHash;
+    ASSERT_EQ(perfectHash.getSlot("ID100000"), HnzPivotPerfectHash::NOT_FOUND);
+    ASSERT_TRUE(perfectHash.build({}));
+    ASSERT_EQ(perfectHash.size(), 0);
+    ASSERT_EQ(perfectHash.getSlot("ID100000"), HnzPivotPerfectHash::NOT_FOUND);
+}
+
+TEST(PivotHNZPerfectHash, DuplicatedKeys)
+{
+    HnzPivotPerfectHash perfectHash;
+    std::vector<std::string> pivotIds = generatePivotIds(100);
+    pivotIds.push_back("ID100042");
+    ASSERT_FALSE(perfectHash.build(keysOf(pivotIds)));
+    ASSERT_EQ(perfectHash.size(), 0);
+    ASSERT_EQ(perfectHash.getSlot("ID100042"), HnzPivotPerfectHash::NOT_FOUND);
+
+    // A failed build does not prevent the next one
+    pivotIds.pop_back();
+    ASSERT_TRUE(perfectHash.build(keysOf(pivotIds)));
+    ASSERT_LT(perfectHash.getSlot("ID100042"), pivotIds.size());
+}
+
+TEST(PivotHNZPerfectHash, ConfigPointIndex)
+{
+    HNZPivotConfig config;
+    config.importExchangeConfig(HnzTrafficGenerator::generateExchangedData(100));
+    const auto& exchangeData = config.getExchangeDefinitions();
+    ASSERT_EQ(config.getPointCount(), exchangeData.size());
+    std::set<size_t> indexes;
+    for (const auto& entry : exchangeData) {
+        size_t index = config.findPointIndex(entry.first);
+        ASSERT_LT(index, config.getPointCount());
+        indexes.insert(index);
+        ASSERT_EQ(config.getDataPoint(index), entry.second.get());
+    }
+    ASSERT_EQ(indexes.size(), exchangeData.size());
+    // Keys of the function are not stored, the configuration checks the pivotId of the datapoint of the slot
+    for (const auto& pivotId : {"unknown", "ID200000", "ID10000", "ID1", ""}) {
+        ASSERT_EQ(config.findPointIndex(pivotId), HnzPivotPerfectHash::NOT_FOUND) << pivotId;
+    }
+}
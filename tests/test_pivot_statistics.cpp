@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_pivot_statistics.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using DataType = HnzPivotStatistics::DataType;
+using Counter = HnzPivotStatistics::Counter;
+
+static std::string dataObjectJson(const std::string& type, int addr, long value, const std::string& an = "")
+{
+    std::string json = "{\"data_object\":{\"do_type\":\"" + type + "\",\"do_station\":12,\"do_addr\":" + std::to_string(addr) +
+                       ",\"do_value\":" + std::to_string(value) + ",\"do_valid\":0,\"do_cg\":1,\"do_outdated\":0";
+    if (!an.empty()) {
+        json += ",\"do_an\":\"" + an + "\"";
+    }
+    return json + "}}";
+}
+
+TEST(PivotHNZStatistics, Counters)
+{
+    HnzPivotStatistics statistics;
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::CONVERTED), 0);
+    statistics.increment(DataType::TS, Counter::CONVERTED);
+    statistics.increment(DataType::TS, Counter::CONVERTED);
+    statistics.increment(DataType::PIVOT, Counter::UNKNOWN_ADDRESS);
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::CONVERTED), 2);
+    ASSERT_EQ(statistics.get(DataType::PIVOT, Counter::UNKNOWN_ADDRESS), 1);
+    ASSERT_EQ(statistics.get(DataType::TM, Counter::CONVERTED), 0);
+
+    Datapoint* dp = statistics.toDatapoint("statistics");
+    ASSERT_EQ(dp->getData().getDpVec()->size(), HnzPivotStatistics::DATA_TYPE_COUNT);
+    std::string json = dp->toJSONProperty();
+    ASSERT_NE(json.find("\"TS\":{\"converted\":2"), std::string::npos) << json;
+    delete dp;
+
+    statistics.reset();
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::CONVERTED), 0);
+
+    ASSERT_EQ(HnzPivotStatistics::dataTypeFromTypeId("TVC"), DataType::TVC);
+    ASSERT_EQ(HnzPivotStatistics::dataTypeFromTypeId("XX"), DataType::OTHER);
+    for (int i = 0; i < HnzPivotStatistics::COUNTER_COUNT; i++) {
+        ASSERT_FALSE(HnzPivotStatistics::CounterStr(static_cast<Counter>(i)).empty());
+    }
+}
+
+using PivotHNZPluginStatistics = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginStatistics, IngestCountersAndReading)
+{
+    ASSERT_NO_THROW(m_handle = plugin_init(nullptr, this, outputStream));
+    auto filter = static_cast<HNZPivotFilter*>(m_handle);
+
+    std::string newConfig = QUOTE({
+        "enable": {
+            "value": "true"
+        },
+        "statistics_period": {
+            "value": "3600"
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(m_handle, newConfig));
+
+    std::string jsonSouthEvent = QUOTE({
+        "south_event": {
+            "connx_status": "started"
+        }
+    });
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS1", {
+        dataObjectJson("TS", 511, 1),       // converted
+        dataObjectJson("TS", 511, 3),       // converted, out of range
+        dataObjectJson("TS", 999, 1),       // unknown address
+        dataObjectJson("TM", 512, 200, "TMA"), // converted, out of range
+        dataObjectJson("TM", 512, 12),      // converted, missing do_an
+        jsonSouthEvent                      // passthrough
+    })));
+
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::CONVERTED), 2);
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::OUT_OF_RANGE), 1);
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::UNKNOWN_ADDRESS), 1);
+    ASSERT_EQ(statistics.get(DataType::TM, Counter::CONVERTED), 2);
+    ASSERT_EQ(statistics.get(DataType::TM, Counter::OUT_OF_RANGE), 1);
+    ASSERT_EQ(statistics.get(DataType::TM, Counter::MISSING_ATTRIBUTE), 1);
+    ASSERT_EQ(statistics.get(DataType::OTHER, Counter::PASSTHROUGH), 1);
+
+    // First statistics reading is sent with the first batch, next one only after the period elapsed
+    ASSERT_EQ(m_statisticsReadings, 1);
+    ASSERT_NE(m_lastStatisticsJson.find("\"TM\":{\"converted\":2"), std::string::npos) << m_lastStatisticsJson;
+
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TS1", {dataObjectJson("TS", 511, 0)})));
+    ASSERT_EQ(m_statisticsReadings, 1);
+    ASSERT_EQ(statistics.get(DataType::TS, Counter::CONVERTED), 3);
+}
+
+static std::string pivotCommandJson(const std::string& pivotId)
+{
+    return "{\"PIVOT\":{\"GTIC\":{\"SpcTyp\":{\"q\":{\"Source\":\"process\",\"Validity\":\"good\"},"
+           "\"t\":{\"FractionOfSecond\":9529458,\"SecondSinceEpoch\":1669714185},\"ctlVal\":1},"
+           "\"Identifier\":\"" + pivotId + "\"}}}";
+}
+
+TEST_F(PivotHNZPluginStatistics, CommandCounters)
+{
+    // P0 (TS, ID100000), P1 (TM, ID100001), P2 (TC, ID100002) and P3 (TVC, ID100003)
+    HNZPivotFilter* filter = initFilter(4);
+    ASSERT_EQ(filter->getExchangeConfig()->getCommandCount(), 2);
+
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("PivotCommand", {
+        pivotCommandJson("ID100002"),            // converted, TC
+        pivotCommandJson("ID100003"),            // converted, TVC
+        pivotCommandJson("ID100000"),            // not a TC or TVC
+        pivotCommandJson("ID999999"),            // unknown
+        pivotCommandJson(std::string(1000, 'X')) // unknown, long identifier
+    })));
+
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    ASSERT_EQ(statistics.get(DataType::PIVOT, Counter::CONVERTED), 2);
+    ASSERT_EQ(statistics.get(DataType::PIVOT, Counter::TYPE_MISMATCH), 1);
+    ASSERT_EQ(statistics.get(DataType::PIVOT, Counter::UNKNOWN_ADDRESS), 2);
+}
@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <chrono>
+#include <thread>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_tm_aggregator.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_perfect_hash.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using Mode = HnzPivotTmAggregator::Mode;
+
+static std::vector<long> aggregateSamples(Mode mode, const std::vector<std::pair<uint64_t, long>>& samples)
+{
+    HnzPivotTmAggregator aggregator;
+    aggregator.setWindow(mode, 1000);
+    aggregator.reset(1);
+    std::vector<long> forwarded;
+    for (const auto& sample : samples) {
+        long aggregate = 0;
+        if (aggregator.addSample(0, sample.second, sample.first, aggregate)) {
+            forwarded.push_back(aggregate);
+        }
+    }
+    return forwarded;
+}
+
+TEST(PivotHNZTmAggregator, Modes)
+{
+    const std::vector<std::pair<uint64_t, long>> samples = {
+        {0, 10}, {200, 40}, {400, -5}, {1000, 20}, // first sample forwarded, window closed by the sample at 1000
+        {1100, 7}, {1500, 8}, {2100, 9}            // second window started at 1000
+    };
+    ASSERT_EQ(aggregateSamples(Mode::NONE, samples), std::vector<long>({10, 40, -5, 20, 7, 8, 9}));
+    ASSERT_EQ(aggregateSamples(Mode::LAST, samples), std::vector<long>({10, 20, 9}));
+    ASSERT_EQ(aggregateSamples(Mode::MEAN, samples), std::vector<long>({10, 18, 8}));
+    ASSERT_EQ(aggregateSamples(Mode::MIN, samples), std::vector<long>({10, -5, 7}));
+    ASSERT_EQ(aggregateSamples(Mode::MAX, samples), std::vector<long>({10, 40, 9}));
+}
+
+TEST(PivotHNZTmAggregator, FirstSample)
+{
+    HnzPivotTmAggregator aggregator;
+    aggregator.setWindow(Mode::MEAN, 1000);
+    aggregator.reset(1);
+    long aggregate = 0;
+    // The first sample after a reset is forwarded immediately
+    ASSERT_TRUE(aggregator.addSample(0, 42, 5000, aggregate));
+    ASSERT_EQ(aggregate, 42);
+    ASSERT_FALSE(aggregator.addSample(0, 43, 5100, aggregate));
+
+    // A window without sample makes the point idle again
+    std::vector<HnzPivotTmAggregator::Aggregate> aggregates;
+    aggregator.reset(1);
+    ASSERT_TRUE(aggregator.addSample(0, 1, 0, aggregate));
+    aggregator.flush(1000, aggregates);
+    ASSERT_TRUE(aggregates.empty());
+    ASSERT_TRUE(aggregator.addSample(0, 2, 1200, aggregate));
+    ASSERT_EQ(aggregate, 2);
+}
+
+TEST(PivotHNZTmAggregator, QuietPoint)
+{
+    HnzPivotTmAggregator aggregator;
+    aggregator.setWindow(Mode::MAX, 1000);
+    aggregator.reset(2);
+    long aggregate = 0;
+    ASSERT_TRUE(aggregator.addSample(0, 10, 0, aggregate));
+    ASSERT_FALSE(aggregator.addSample(0, 30, 100, aggregate));
+    ASSERT_FALSE(aggregator.addSample(0, 20, 200, aggregate));
+    ASSERT_TRUE(aggregator.addSample(1, 5, 500, aggregate));
+
+    std::vector<HnzPivotTmAggregator::Aggregate> aggregates;
+    aggregator.flush(999, aggregates);
+    ASSERT_TRUE(aggregates.empty());
+    // The pending samples of the quiet point are forwarded once its window is over
+    aggregator.flush(1000, aggregates);
+    ASSERT_EQ(aggregates.size(), 1);
+    ASSERT_EQ(aggregates[0].pointIndex, 0);
+    ASSERT_EQ(aggregates[0].value, 30);
+    // A new window starts with the flush
+    aggregates.clear();
+    ASSERT_FALSE(aggregator.addSample(0, 7, 1500, aggregate));
+    aggregator.flush(2000, aggregates);
+    ASSERT_EQ(aggregates.size(), 1);
+    ASSERT_EQ(aggregates[0].value, 7);
+    aggregates.clear();
+    aggregator.flush(3000, aggregates);
+    ASSERT_TRUE(aggregates.empty());
+}
+
+TEST(PivotHNZTmAggregator, DiscardAndReset)
+{
+    HnzPivotTmAggregator aggregator;
+    aggregator.setWindow(Mode::MAX, 1000);
+    aggregator.reset(2);
+    ASSERT_TRUE(aggregator.isEnabled());
+    long aggregate = 0;
+    ASSERT_TRUE(aggregator.addSample(0, 100, 0, aggregate));
+    ASSERT_FALSE(aggregator.addSample(0, 200, 100, aggregate));
+    ASSERT_TRUE(aggregator.addSample(1, 100, 0, aggregate));
+    ASSERT_FALSE(aggregator.addSample(1, 50, 100, aggregate));
+    // Samples before the discard are not part of the window anymore, the next one is forwarded immediately
+    aggregator.discard(0);
+    ASSERT_TRUE(aggregator.addSample(0, 1, 500, aggregate));
+    ASSERT_EQ(aggregate, 1);
+    ASSERT_TRUE(aggregator.addSample(0, 2, 1500, aggregate));
+    ASSERT_EQ(aggregate, 2);
+    ASSERT_TRUE(aggregator.addSample(1, 3, 1500, aggregate));
+    ASSERT_EQ(aggregate, 50);
+
+    // Changing the settings drops the current windows
+    ASSERT_FALSE(aggregator.addSample(0, 100, 2000, aggregate));
+    aggregator.setWindow(Mode::MIN, 1000);
+    std::vector<HnzPivotTmAggregator::Aggregate> aggregates;
+    aggregator.flush(5000, aggregates);
+    ASSERT_TRUE(aggregates.empty());
+    ASSERT_TRUE(aggregator.addSample(0, 5, 5000, aggregate));
+    ASSERT_FALSE(aggregator.addSample(0, 6, 5500, aggregate));
+    ASSERT_TRUE(aggregator.addSample(0, 8, 6000, aggregate));
+    ASSERT_EQ(aggregate, 6);
+
+    // Out of range index
+    ASSERT_TRUE(aggregator.addSample(2, 42, 0, aggregate));
+    ASSERT_EQ(aggregate, 42);
+
+    // Windows open follow their point to its new index, the ones of the points removed are dropped
+    ASSERT_TRUE(aggregator.addSample(1, 9, 6000, aggregate));
+    ASSERT_FALSE(aggregator.addSample(1, 4, 6100, aggregate));
+    aggregator.remap({HnzPivotPerfectHash::NOT_FOUND, 0}, 1);
+    aggregates.clear();
+    aggregator.flush(7000, aggregates);
+    ASSERT_EQ(aggregates.size(), 1);
+    ASSERT_EQ(aggregates[0].pointIndex, 0);
+    ASSERT_EQ(aggregates[0].value, 4);
+}
+
+TEST(PivotHNZTmAggregator, ModeStr)
+{
+    for (Mode mode : {Mode::NONE, Mode::LAST, Mode::MEAN, Mode::MIN, Mode::MAX}) {
+        Mode parsed = Mode::NONE;
+        ASSERT_TRUE(HnzPivotTmAggregator::modeFromStr(HnzPivotTmAggregator::ModeStr(mode), parsed));
+        ASSERT_EQ(parsed, mode);
+    }
+    Mode parsed = Mode::LAST;
+    ASSERT_FALSE(HnzPivotTmAggregator::modeFromStr("median", parsed));
+    ASSERT_EQ(parsed, Mode::LAST);
+}
+
+static std::string tmJson(int value, int valid)
+{
+    return "{\"data_object\":{\"do_type\":\"TM\",\"do_station\":12,\"do_addr\":1,\"do_value\":" + std::to_string(value) +
+           ",\"do_valid\":" + std::to_string(valid) + ",\"do_an\":\"TMA\",\"do_outdated\":0}}";
+}
+
+using PivotHNZPluginTmAggregator = HnzFilterFixture;
+
+TEST_F(PivotHNZPluginTmAggregator, FilterAggregateTM)
+{
+    m_config.setValue("tm_aggregation", "max");
+    m_config.setValue("tm_aggregation_window", "60000");
+    // P1 (TM, address 1, any station)
+    HNZPivotFilter* filter = initFilter(4);
+    const HnzPivotTmAggregator& aggregator = filter->getTmAggregator();
+    ASSERT_EQ(aggregator.getMode(), Mode::MAX);
+    ASSERT_EQ(aggregator.getWindowMs(), 60000);
+
+    // The first sample is forwarded, the next ones of the window are not
+    for (int value : {10, 30, 20}) {
+        ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TM", {tmJson(value, 0)})));
+    }
+    ASSERT_EQ(m_outputJsons.size(), 1);
+    ASSERT_NE(m_outputJsons.back().find("\"mag\":{\"i\":10}"), std::string::npos) << m_outputJsons.back();
+    ASSERT_EQ(filter->getStatistics().get(HnzPivotStatistics::DataType::TM, HnzPivotStatistics::Counter::SUPPRESSED), 2);
+
+    // Invalid samples are forwarded immediately
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TM", {tmJson(50, 1)})));
+    ASSERT_EQ(m_outputJsons.size(), 2);
+    ASSERT_NE(m_outputJsons.back().find("\"mag\":{\"i\":50}"), std::string::npos) << m_outputJsons.back();
+
+    // With a shorter window, the aggregate of a quiet point is forwarded with the next reading set received
+    m_config.setValue("tm_aggregation_window", "200");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_EQ(aggregator.getWindowMs(), 200);
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TM", {tmJson(40, 0), tmJson(45, 0), tmJson(41, 0)})));
+    ASSERT_EQ(m_outputJsons.size(), 3);
+    ASSERT_NE(m_outputJsons.back().find("\"mag\":{\"i\":40}"), std::string::npos) << m_outputJsons.back();
+    std::this_thread::sleep_for(std::chrono::milliseconds(250));
+    ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("R", {QUOTE({"south_event":{"connx_status":"started"}})})));
+    ASSERT_EQ(m_outputJsons.size(), 5);
+    ASSERT_NE(m_outputJsons[3].find("\"asset_code\":\"P1\""), std::string::npos) << m_outputJsons[3];
+    ASSERT_NE(m_outputJsons[3].find("\"mag\":{\"i\":45}"), std::string::npos) << m_outputJsons[3];
+    ASSERT_NE(m_outputJsons[4].find("south_event"), std::string::npos) << m_outputJsons[4];
+
+    // Invalid settings are ignored
+    checkInvalidIgnored("tm_aggregation", "median", [&aggregator]() { return aggregator.getMode(); });
+    checkInvalidIgnored("tm_aggregation_window", "-1", [&aggregator]() { return aggregator.getWindowMs(); });
+
+    // Disabled, every sample is forwarded
+    m_config.setValue("tm_aggregation", "none");
+    ASSERT_NO_THROW(reconfigure());
+    ASSERT_FALSE(aggregator.isEnabled());
+    for (int value : {10, 30, 20}) {
+        ASSERT_NO_THROW(plugin_ingest(m_handle, HnzTestReadings::createReadingSet("TM", {tmJson(value, 0)})));
+    }
+    ASSERT_EQ(m_outputJsons.size(), 8);
+}
@@ -7,6 +7,7 @@
 #include "hnz_pivot_filter.hpp"
 #include "hnz_pivot_utility.hpp"
 #include "hnz_pivot_object.hpp"
+#include "hnz_test_readings.hpp"
 
 using namespace rapidjson;
 
@@ -208,9 +209,8 @@ static const std::string test_config = QUOTE({
 
 static int outputHandlerCalled = 0;
 static std::shared_ptr<Reading> lastReading = nullptr;
-// Dummy object used to be able to call parseJson() freely
-static DatapointValue dummyValue("");
-static Datapoint dummyDataPoint({}, dummyValue);
+// Asset names of the readings of each reading set received by the output stream
+static std::vector<std::vector<std::string>> outputAssetNames;
 
 static const std::vector<std::string> allCommandAttributeNames = {
     "co_type", "co_addr", "co_value"
@@ -242,20 +242,9 @@ static const std::vector<std::string> allSouthEventAttributeNames = {
 
 static void createReadingSet(ReadingSet*& outReadingSet, const std::string& assetName, const std::vector<std::string>& jsons)
 {
-    std::vector<Datapoint*> *allPoints = new std::vector<Datapoint*>();
-    for(const std::string& json: jsons) {
-        // Create Reading
-        std::vector<Datapoint*> *p = nullptr;
-        ASSERT_NO_THROW(p = dummyDataPoint.parseJson(json));
-        ASSERT_NE(p, nullptr);
-        allPoints->insert(std::end(*allPoints), std::begin(*p), std::end(*p));
-        delete p;
-    }
-    Reading *reading = new Reading(assetName, *allPoints);
-    std::vector<Reading*> *readings = new std::vector<Reading*>();
-    readings->push_back(reading);
-    // Create ReadingSet
-    outReadingSet = new ReadingSet(readings);
+    Reading *reading = nullptr;
+    ASSERT_NO_THROW(reading = HnzTestReadings::createReading(assetName, jsons));
+    outReadingSet = HnzTestReadings::createReadingSet(std::vector<Reading*>{reading});
 }
 
 static void createReadingSet(ReadingSet*& outReadingSet, const std::string& assetName, const std::string& json)
@@ -265,12 +254,7 @@ static void createReadingSet(ReadingSet*& outReadingSet, const std::string& asse
 
 static void createEmptyReadingSet(ReadingSet*& outReadingSet, const std::string& assetName)
 {
-    std::vector<Datapoint*> *allPoints = new std::vector<Datapoint*>();
-    Reading *reading = new Reading(assetName, *allPoints);
-    std::vector<Reading*> *readings = new std::vector<Reading*>();
-    readings->push_back(reading);
-    // Create ReadingSet
-    outReadingSet = new ReadingSet(readings);
+    outReadingSet = HnzTestReadings::createReadingSet(std::vector<Reading*>{HnzTestReadings::createReading(assetName, {})});
 }
 
 static bool hasChild(Datapoint& dp, const std::string& childLabel) {
@@ -356,10 +340,13 @@ static Datapoint* getObject(const Reading& reading, const std::string& label) {
 
 static void testOutputStream(OUTPUT_HANDLE * handle, READINGSET* readingSet)
 {
+    (void)handle; /* ignore parameter */
     const std::vector<Reading*>& readings = readingSet->getAllReadings();
 
+    outputAssetNames.emplace_back();
     for (Reading* reading : readings) {
         printf("output: Reading: %s\n", reading->getAssetName().c_str());
+        outputAssetNames.back().push_back(reading->getAssetName());
 
         const std::vector<Datapoint*>& datapoints = reading->getReadingData();
 
@@ -495,6 +482,7 @@ protected:
 
         outputHandlerCalled = 0;
         lastReading = nullptr;
+        outputAssetNames.clear();
     }
 
     // TearDown is ran for every tests, so each variable are destroyed again
@@ -1631,6 +1619,72 @@ TEST_F(PivotHNZPluginIngest, PivotToTVC)
     if(HasFatalFailure()) return;
 }
 
+TEST_F(PivotHNZPluginIngest, PivotCommandForwardedFirst)
+{
+    std::string jsonMessageTSCE = QUOTE({
+        "data_object":{
+            "do_type":"TS",
+            "do_station":12,
+            "do_addr":511,
+            "do_value":1,
+            "do_valid":0,
+            "do_cg":0,
+            "do_outdated":0,
+            "do_ts": 1685019425432,
+            "do_ts_iv":0,
+            "do_ts_c":0,
+            "do_ts_s":0
+        }
+    });
+    std::string jsonMessagePivotTVC = QUOTE({
+        "PIVOT": {
+            "GTIC": {
+                "IncTyp": {
+                    "q": {
+                        "Source": "process",
+                        "Validity": "good"
+                    },
+                    "t": {
+                        "FractionOfSecond": 9529458,
+                        "SecondSinceEpoch": 1669714185
+                    },
+                    "ctlVal": 42
+                },
+                "Identifier": "ID333111"
+            }
+        }
+    });
+    // Command received in the middle of monitoring data: forwarded alone, before the monitoring data
+    ReadingSet* readingSet = HnzTestReadings::createReadingSet({
+        HnzTestReadings::createReading("TS1", {jsonMessageTSCE}),
+        HnzTestReadings::createReading("PivotCommand", {jsonMessagePivotTVC}),
+        HnzTestReadings::createReading("TS1", {jsonMessageTSCE}),
+    });
+    ASSERT_NO_THROW(plugin_ingest(filter, static_cast<READINGSET*>(readingSet)));
+    ASSERT_EQ(outputHandlerCalled, 2);
+    ASSERT_EQ(outputAssetNames, std::vector<std::vector<std::string>>({{"HNZCommand"}, {"TS1", "TS1"}}));
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::COMMAND).count, 1);
+
+    // Only commands: the reading set received is forwarded
+    outputAssetNames.clear();
+    readingSet = HnzTestReadings::createReadingSet({
+        HnzTestReadings::createReading("PivotCommand", {jsonMessagePivotTVC}),
+        HnzTestReadings::createReading("PivotCommand", {jsonMessagePivotTVC}),
+    });
+    ASSERT_NO_THROW(plugin_ingest(filter, static_cast<READINGSET*>(readingSet)));
+    ASSERT_EQ(resultReading, readingSet);
+    ASSERT_EQ(outputAssetNames, std::vector<std::vector<std::string>>({{"HNZCommand", "HNZCommand"}}));
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::COMMAND).count, 2);
+
+    // No command: nothing recorded
+    outputAssetNames.clear();
+    createReadingSet(readingSet, "TS1", jsonMessageTSCE);
+    if(HasFatalFailure()) return;
+    ASSERT_NO_THROW(plugin_ingest(filter, static_cast<READINGSET*>(readingSet)));
+    ASSERT_EQ(outputAssetNames, std::vector<std::vector<std::string>>({{"TS1"}}));
+    ASSERT_EQ(filter->getLatencySnapshot(HNZPivotFilter::LatencyStage::COMMAND).count, 2);
+}
+
 TEST_F(PivotHNZPluginIngest, SouthEvent)
 {
     std::string jsonMessageSouthEvent = QUOTE({
@@ -1643,6 +1697,7 @@ TEST_F(PivotHNZPluginIngest, SouthEvent)
     createReadingSet(readingSet, "CONNECTION-1", jsonMessageSouthEvent);
     if(HasFatalFailure()) return;
     ASSERT_NE(readingSet, nullptr);
+    const Datapoint* southEvent = readingSet->getAllReadings()[0]->getReadingData()[0];
 
     ASSERT_NO_THROW(plugin_ingest(filter, static_cast<READINGSET*>(readingSet)));
     ASSERT_EQ(outputHandlerCalled, 1);
@@ -1651,6 +1706,8 @@ TEST_F(PivotHNZPluginIngest, SouthEvent)
         {"gi_status", {"string", "idle"}},
     });
     if(HasFatalFailure()) return;
+    // Datapoints that are not converted are forwarded without being copied
+    ASSERT_EQ(resultReading->getAllReadings()[0]->getReadingData()[0], southEvent);
 }
 
 TEST_F(PivotHNZPluginIngest, InvalidMessages)
@@ -2340,4 +2397,83 @@ TEST_F(PivotHNZPluginIngest, InvalidMessages)
         {"co_value", {"int64_t", "42"}},
     });
     if(HasFatalFailure()) return;
-}
\ No newline at end of file
+}
+TEST_F(PivotHNZPluginIngest, TSToPivotStation)
+{
+    static const std::string stationConfig = QUOTE({
+        "exchanged_data": {
+            "value": {
+                "exchanged_data": {
+                    "name": "SAMPLE",
+                    "version": "1.0",
+                    "datapoints": [
+                        {
+                            "label": "TS1",
+                            "pivot_id": "ID114561",
+                            "pivot_type": "SpsTyp",
+                            "protocols": [
+                                {
+                                    "name": "hnzip",
+                                    "station": "12",
+                                    "address": "511",
+                                    "typeid": "TS"
+                                }
+                            ]
+                        },
+                        {
+                            "label": "TS1",
+                            "pivot_id": "ID114562",
+                            "pivot_type": "SpsTyp",
+                            "protocols": [
+                                {
+                                    "name": "hnzip",
+                                    "station": "13",
+                                    "address": "511",
+                                    "typeid": "TS"
+                                }
+                            ]
+                        },
+                        {
+                            "label": "TS1",
+                            "pivot_id": "ID114563",
+                            "pivot_type": "SpsTyp",
+                            "protocols": [
+                                {
+                                    "name": "hnzip",
+                                    "address": "511",
+                                    "typeid": "TS"
+                                }
+                            ]
+                        }
+                    ]
+                }
+            }
+        }
+    });
+    ASSERT_NO_THROW(plugin_reconfigure(reinterpret_cast<PLUGIN_HANDLE*>(filter), stationConfig));
+
+    // The point of the station is used, the one configured without station for the other stations
+    std::map<unsigned int, std::string> expectedPivotIds = {{12, "ID114561"}, {13, "ID114562"}, {14, "ID114563"}};
+    for (const auto& expectedPivotId : expectedPivotIds) {
+        std::string jsonMessageTSCG = "{\"data_object\":{\"do_type\":\"TS\",\"do_station\":" + std::to_string(expectedPivotId.first) +
+                                      ",\"do_addr\":511,\"do_value\":1,\"do_valid\":0,\"do_cg\":1,\"do_outdated\":0}}";
+        ReadingSet* readingSet = nullptr;
+        createReadingSet(readingSet, "TS1", jsonMessageTSCG);
+        if(HasFatalFailure()) return;
+
+        outputHandlerCalled = 0;
+        ASSERT_NO_THROW(plugin_ingest(filter, static_cast<READINGSET*>(readingSet)));
+        ASSERT_EQ(outputHandlerCalled, 1);
+        validateReading(lastReading, "TS1", "PIVOT", allPivotAttributeNames, {
+            {"GTIS.ComingFrom", {"string", "hnzip"}},
+            {"GTIS.Identifier", {"string", expectedPivotId.second}},
+            {"GTIS.Cause.stVal", {"int64_t", "20"}},
+            {"GTIS.TmOrg.stVal", {"string", "substituted"}},
+            {"GTIS.SpsTyp.stVal", {"int64_t", "1"}},
+            {"GTIS.SpsTyp.q.Validity", {"string", "good"}},
+            {"GTIS.SpsTyp.t.SecondSinceEpoch", {"int64_t_range", "0;" + std::to_string(std::numeric_limits<int64_t>::max())}},
+            {"GTIS.SpsTyp.t.FractionOfSecond", {"int64_t_range", "0;99999999"}},
+        });
+        if(HasFatalFailure()) return;
+    }
+}
@@ -1,6 +1,11 @@
 #include <gtest/gtest.h>
 
 #include "hnz_pivot_filter.hpp"
+#include "hnz_test_readings.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using DataType = HnzPivotStatistics::DataType;
+using Counter = HnzPivotStatistics::Counter;
 
 
 static std::string reconfigure = QUOTE({
@@ -36,4 +41,47 @@ TEST(PivotHNZPluginReconfigure, Reconfigure)
     ASSERT_EQ(filter->isEnabled(), false);
 
     ASSERT_NO_THROW(plugin_shutdown(static_cast<PLUGIN_HANDLE*>(handle)));
-}
\ No newline at end of file
+}
+
+static void deleteOutputStream(OUTPUT_HANDLE * handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    delete readingSet;
+}
+
+TEST(PivotHNZPluginReconfigure, ReconfigureExchangedData)
+{
+    ConfigCategory config("hnztopivot", plugin_info()->config);
+    config.setItemsValueFromDefault();
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(4));
+    PLUGIN_HANDLE handle = plugin_init(&config, nullptr, deleteOutputStream);
+    HNZPivotFilter* filter = static_cast<HNZPivotFilter*>(handle);
+
+    // Point P4 (TS, address 4) is not in the configuration yet
+    std::string tsAddress4 = QUOTE({
+        "data_object":{
+            "do_type":"TS",
+            "do_station":12,
+            "do_addr":4,
+            "do_value":1,
+            "do_valid":0,
+            "do_cg":1,
+            "do_outdated":0
+        }
+    });
+    filter->ingest(HnzTestReadings::createReadingSet("P4", {tsAddress4}));
+    ASSERT_EQ(filter->getStatistics().get(DataType::TS, Counter::UNKNOWN_ADDRESS), 1);
+
+    config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(5));
+    ASSERT_NO_THROW(plugin_reconfigure(static_cast<PLUGIN_HANDLE*>(handle), config.toJSON()));
+    filter->ingest(HnzTestReadings::createReadingSet("P4", {tsAddress4}));
+    ASSERT_EQ(filter->getStatistics().get(DataType::TS, Counter::CONVERTED), 1);
+
+    // Reconfigure with the same exchanged_data
+    config.setValue("statistics_period", "0");
+    ASSERT_NO_THROW(plugin_reconfigure(static_cast<PLUGIN_HANDLE*>(handle), config.toJSON()));
+    filter->ingest(HnzTestReadings::createReadingSet("P4", {tsAddress4}));
+    ASSERT_EQ(filter->getStatistics().get(DataType::TS, Counter::CONVERTED), 2);
+
+    ASSERT_NO_THROW(plugin_shutdown(static_cast<PLUGIN_HANDLE*>(handle)));
+}
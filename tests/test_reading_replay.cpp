@@ -0,0 +1,110 @@
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <config_category.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_reading_replay.hpp"
+#include "hnz_traffic_generator.hpp"
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+};
+
+class PivotHNZPluginReplay : public testing::Test
+{
+protected:
+    std::string exchangedData = HnzTrafficGenerator::generateExchangedData(100);
+    std::vector<std::string> capture;
+    // Readings with an unknown address are dropped by the filter
+    size_t expectedOutputSize = 0;
+
+    // Capture 200 generated readings, timestamped 1 ms apart
+    void SetUp() override
+    {
+        HnzTrafficProfile profile;
+        profile.tcWeight = 1;
+        profile.tvcWeight = 1;
+        profile.cgRatio = 0.5;
+        profile.unknownAddressRate = 0.05;
+        profile.batchSize = 200;
+        HnzTrafficGenerator generator(exchangedData, profile);
+        ReadingSet* readingSet = generator.nextBatch();
+        expectedOutputSize = 200 - generator.getCounters().unknownAddress;
+        struct timeval tv = {1685019425, 0};
+        for (Reading* reading : readingSet->getAllReadings()) {
+            reading->setUserTimestamp(tv);
+            tv.tv_usec += 1000;
+        }
+        HnzReadingReplay::record(*readingSet, capture);
+        delete readingSet;
+    }
+
+    ConfigCategory createConfig()
+    {
+        ConfigCategory config("hnztopivot", plugin_info()->config);
+        config.setItemsValueFromDefault();
+        config.setValue("enable", "true");
+        config.setValue("exchanged_data", exchangedData);
+        return config;
+    }
+};
+
+TEST_F(PivotHNZPluginReplay, MaxSpeedAndGoldenDiff)
+{
+    HnzReadingReplay replay(capture);
+    ASSERT_EQ(replay.size(), 200);
+
+    ConfigCategory config = createConfig();
+    HnzReplayOptions options;
+    options.batchSize = 10;
+    HnzReplayReport report = replay.run(&config, options);
+    printf("%s\n", report.toString().c_str());
+    ASSERT_EQ(report.readings, 200);
+    ASSERT_EQ(report.batches, 20);
+    ASSERT_EQ(report.latency.count, 20);
+    ASSERT_GT(report.throughput(), 0);
+    ASSERT_EQ(report.output.size(), expectedOutputSize);
+    ASSERT_NE(report.output.front().find("\"PIVOT\""), std::string::npos) << report.output.front();
+
+    // Golden file round trip, the output does not depend on batching
+    const std::string goldenPath = "replay_golden.jsonl";
+    HnzReadingReplay::saveLines(goldenPath, report.output);
+    std::vector<std::string> golden = HnzReadingReplay::loadLines(goldenPath);
+    std::remove(goldenPath.c_str());
+    options.batchSize = 1;
+    HnzReplayReport secondReport = replay.run(&config, options);
+    ASSERT_EQ(secondReport.batches, 200);
+    ASSERT_TRUE(HnzReadingReplay::diff(golden, secondReport.output).empty());
+
+    golden[3] = "{}";
+    golden.pop_back();
+    std::vector<std::string> differences = HnzReadingReplay::diff(golden, secondReport.output);
+    ASSERT_EQ(differences.size(), 2);
+    ASSERT_EQ(differences[0].find("line 4: expected: {}"), 0) << differences[0];
+    ASSERT_EQ(differences[1].find("line " + std::to_string(expectedOutputSize) + ": unexpected output"), 0) << differences[1];
+}
+
+TEST_F(PivotHNZPluginReplay, Paced)
+{
+    HnzReadingReplay replay(capture);
+    ConfigCategory config = createConfig();
+    HnzReplayOptions options;
+    options.paced = true;
+    options.speed = 2.0;
+    options.batchSize = 20;
+    HnzReplayReport report = replay.run(&config, options);
+    // Last batch is captured 180 ms after the first one
+    ASSERT_GE(report.elapsedSeconds, 0.09);
+    ASSERT_EQ(report.output.size(), expectedOutputSize);
+}
+
+TEST_F(PivotHNZPluginReplay, InvalidCapture)
+{
+    ASSERT_THROW(HnzReadingReplay({"not a json"}), std::invalid_argument);
+    ASSERT_THROW(HnzReadingReplay({"{\"reading\":{}}"}), std::invalid_argument);
+    ASSERT_THROW(HnzReadingReplay::loadLines("/nonexistent/capture.jsonl"), std::runtime_error);
+    HnzReadingReplay emptyReplay({"", "  "});
+    ASSERT_EQ(emptyReplay.size(), 0);
+}
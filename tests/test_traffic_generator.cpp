@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_pivot_filter.hpp"
+#include "hnz_traffic_generator.hpp"
+
+using Kind = HnzTrafficGenerator::Kind;
+using DataType = HnzPivotStatistics::DataType;
+using Counter = HnzPivotStatistics::Counter;
+
+extern "C" {
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_reconfigure(PLUGIN_HANDLE handle, const std::string& newConfig);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+static int pivotReadingsReceived = 0;
+
+static void countingOutputStream(OUTPUT_HANDLE * handle, READINGSET* readingSet)
+{
+    (void)handle; /* ignore parameter */
+    for (Reading* reading : readingSet->getAllReadings()) {
+        for (Datapoint* dp : reading->getReadingData()) {
+            if (dp->getName() == "PIVOT") {
+                pivotReadingsReceived++;
+            }
+        }
+    }
+    delete readingSet;
+}
+
+TEST(PivotHNZPluginTrafficGenerator, Composition)
+{
+    HnzTrafficProfile profile;
+    profile.tsWeight = 1;
+    profile.tmWeight = 1;
+    profile.tcWeight = 1;
+    profile.tvcWeight = 1;
+    profile.cgRatio = 0.5;
+    profile.unknownAddressRate = 0.1;
+    profile.batchSize = 1000;
+    HnzTrafficGenerator generator(HnzTrafficGenerator::generateExchangedData(100), profile);
+    for (int i = 0; i < HnzTrafficGenerator::KIND_COUNT; i++) {
+        ASSERT_EQ(generator.getPointCount(static_cast<Kind>(i)), 25);
+    }
+
+    ReadingSet* readingSet = generator.nextBatch();
+    ASSERT_EQ(readingSet->getAllReadings().size(), 1000);
+    delete readingSet;
+
+    const HnzTrafficGenerator::Counters& counters = generator.getCounters();
+    ASSERT_EQ(counters.total, 1000);
+    for (int i = 0; i < HnzTrafficGenerator::KIND_COUNT; i++) {
+        ASSERT_NEAR(counters.byKind[i], 250, 75);
+    }
+    ASSERT_NEAR(counters.cg, counters.byKind[static_cast<int>(Kind::TS)] / 2, 60);
+    ASSERT_NEAR(counters.unknownAddress, 100, 40);
+    ASSERT_EQ(counters.invalid, 0);
+    ASSERT_EQ(counters.outdated, 0);
+
+    // No TC point defined while TC readings are requested
+    ASSERT_THROW(HnzTrafficGenerator(HnzTrafficGenerator::generateExchangedData(2), profile), std::invalid_argument);
+}
+
+TEST(PivotHNZPluginTrafficGenerator, IngestGeneratedTraffic)
+{
+    PLUGIN_HANDLE handle = nullptr;
+    ASSERT_NO_THROW(handle = plugin_init(nullptr, nullptr, countingOutputStream));
+    auto filter = static_cast<HNZPivotFilter*>(handle);
+    pivotReadingsReceived = 0;
+
+    std::string exchangedData = HnzTrafficGenerator::generateExchangedData(1000);
+    std::string reconfigure = "{\"enable\":{\"value\":\"true\"},\"exchanged_data\":{\"value\":" + exchangedData + "}}";
+    ASSERT_NO_THROW(plugin_reconfigure(handle, reconfigure));
+
+    HnzTrafficProfile profile;
+    profile.tcWeight = 0.5;
+    profile.tvcWeight = 0.5;
+    profile.cgRatio = 0.3;
+    profile.invalidRate = 0.1;
+    profile.outdatedRate = 0.1;
+    profile.tsCRate = 0.1;
+    profile.tsSRate = 0.1;
+    profile.unknownAddressRate = 0.05;
+    profile.batchSize = 200;
+    HnzTrafficGenerator generator(exchangedData, profile);
+    for (int i = 0; i < 10; i++) {
+        ASSERT_NO_THROW(plugin_ingest(handle, generator.nextBatch()));
+    }
+
+    // Every reading with a known address is converted
+    const HnzTrafficGenerator::Counters& counters = generator.getCounters();
+    const HnzPivotStatistics& statistics = filter->getStatistics();
+    uint64_t converted = 0;
+    uint64_t unknownAddress = 0;
+    for (DataType type : {DataType::TS, DataType::TM, DataType::TC, DataType::TVC}) {
+        converted += statistics.get(type, Counter::CONVERTED);
+        unknownAddress += statistics.get(type, Counter::UNKNOWN_ADDRESS);
+    }
+    ASSERT_EQ(counters.total, 2000);
+    ASSERT_EQ(unknownAddress, counters.unknownAddress);
+    ASSERT_EQ(converted, counters.total - counters.unknownAddress);
+    ASSERT_EQ(pivotReadingsReceived, converted);
+
+    ASSERT_NO_THROW(plugin_shutdown(handle));
+}
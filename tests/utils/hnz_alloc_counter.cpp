@@ -0,0 +1,138 @@
+#include <cstdlib>
+#include <new>
+
+#include "hnz_alloc_counter.hpp"
+
+/*
+ * Counters are thread local so that allocations made by other threads (e.g. the test framework)
+ * are not counted. They are plain integers as they are only accessed by their own thread.
+ */
+static thread_local bool counting = false;
+static thread_local HnzAllocStats stats;
+// Heap memory allocated since start() and not freed yet, may be negative if memory allocated before is freed
+static thread_local int64_t liveBytes = 0;
+
+void HnzAllocCounter::start()
+{
+    stats = HnzAllocStats();
+    liveBytes = 0;
+    counting = true;
+}
+
+HnzAllocStats HnzAllocCounter::stop()
+{
+    counting = false;
+    return stats;
+}
+
+#ifdef __GLIBC__
+#include <malloc.h>
+
+extern "C" {
+    void* __libc_malloc(size_t size);
+    void* __libc_calloc(size_t count, size_t size);
+    void* __libc_realloc(void* ptr, size_t size);
+    void __libc_free(void* ptr);
+
+    static void countAllocated(void* ptr)
+    {
+        stats.mallocs++;
+        if (ptr != nullptr) {
+            liveBytes += malloc_usable_size(ptr);
+            if (liveBytes > stats.peakBytes) {
+                stats.peakBytes = liveBytes;
+            }
+        }
+    }
+
+    void* malloc(size_t size)
+    {
+        void* ptr = __libc_malloc(size);
+        if (counting) {
+            countAllocated(ptr);
+        }
+        return ptr;
+    }
+
+    void* calloc(size_t count, size_t size)
+    {
+        void* ptr = __libc_calloc(count, size);
+        if (counting) {
+            countAllocated(ptr);
+        }
+        return ptr;
+    }
+
+    void* realloc(void* ptr, size_t size)
+    {
+        if (counting && ptr != nullptr) {
+            liveBytes -= malloc_usable_size(ptr);
+        }
+        void* newPtr = __libc_realloc(ptr, size);
+        if (counting) {
+            countAllocated(newPtr);
+        }
+        return newPtr;
+    }
+
+    void free(void* ptr)
+    {
+        if (counting && ptr != nullptr) {
+            stats.frees++;
+            liveBytes -= malloc_usable_size(ptr);
+        }
+        __libc_free(ptr);
+    }
+};
+#endif
+
+static void* countedNew(std::size_t size)
+{
+    if (counting) {
+        stats.news++;
+        stats.newBytes += size;
+    }
+    void* ptr = std::malloc(size == 0 ? 1 : size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+static void countedDelete(void* ptr)
+{
+    if (counting && ptr != nullptr) {
+        stats.deletes++;
+    }
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size)
+{
+    return countedNew(size);
+}
+
+void* operator new[](std::size_t size)
+{
+    return countedNew(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    countedDelete(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    countedDelete(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    countedDelete(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    countedDelete(ptr);
+}
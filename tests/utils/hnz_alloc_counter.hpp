@@ -0,0 +1,40 @@
+#ifndef _HNZ_ALLOC_COUNTER_H
+#define _HNZ_ALLOC_COUNTER_H
+
+#include <cstdint>
+
+/**
+ * Heap activity measured between HnzAllocCounter::start() and HnzAllocCounter::stop()
+ */
+struct HnzAllocStats
+{
+    // Calls to global operator new / new[] and their total size
+    uint64_t news = 0;
+    uint64_t newBytes = 0;
+    // Calls to global operator delete / delete[] on a non null pointer
+    uint64_t deletes = 0;
+    // Calls to malloc, calloc and realloc, including the ones made by operator new,
+    // only available with glibc (always 0 otherwise)
+    uint64_t mallocs = 0;
+    uint64_t frees = 0;
+    // Highest amount of heap memory allocated since start() and not freed yet, only available with glibc
+    int64_t peakBytes = 0;
+};
+
+/*
+ * Count heap allocations made by the calling thread. The global operator new/delete are replaced
+ * and, with glibc, malloc/free are interposed, as soon as this file is linked in an executable.
+ */
+namespace HnzAllocCounter {
+    /**
+     * Reset the counters and start counting the allocations made by the calling thread
+    */
+    void start();
+    /**
+     * Stop counting
+     * @return Allocations made by the calling thread since start()
+    */
+    HnzAllocStats stop();
+};
+
+#endif /* _HNZ_ALLOC_COUNTER_H */
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_filter_fixture.hpp"
+#include "hnz_pivot_filter.hpp"
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_traffic_generator.hpp"
+
+HnzFilterFixture::HnzFilterFixture():
+    m_config("hnztopivot", plugin_info()->config)
+{
+    m_config.setItemsValueFromDefault();
+}
+
+HnzFilterFixture::~HnzFilterFixture()
+{
+    clearOutputs();
+}
+
+void HnzFilterFixture::TearDown()
+{
+    shutdownFilter();
+}
+
+HNZPivotFilter* HnzFilterFixture::initFilter(int pointCount)
+{
+    if (pointCount > 0) {
+        m_config.setValue("exchanged_data", HnzTrafficGenerator::generateExchangedData(pointCount));
+    }
+    m_handle = plugin_init(&m_config, this, outputStream);
+    m_filter = static_cast<HNZPivotFilter*>(m_handle);
+    return m_filter;
+}
+
+void HnzFilterFixture::reconfigure()
+{
+    plugin_reconfigure(m_handle, m_config.toJSON());
+}
+
+void HnzFilterFixture::shutdownFilter()
+{
+    if (m_handle != nullptr) {
+        plugin_shutdown(m_handle);
+        m_handle = nullptr;
+        m_filter = nullptr;
+    }
+}
+
+void HnzFilterFixture::clearOutputs()
+{
+    std::lock_guard<std::mutex> guard(m_outputMutex);
+    for (Reading* reading : m_outputReadings) {
+        delete reading;
+    }
+    m_outputReadings.clear();
+    m_outputJsons.clear();
+    m_outputThreads.clear();
+    m_lastStatisticsJson.clear();
+    m_statisticsReadings = 0;
+}
+
+size_t HnzFilterFixture::countOutputs(const std::string& pattern) const
+{
+    return static_cast<size_t>(std::count_if(m_outputJsons.begin(), m_outputJsons.end(), [&pattern](const std::string& json) {
+        return json.find(pattern) != std::string::npos;
+    }));
+}
+
+std::vector<std::string> HnzFilterFixture::getOutputAssets()
+{
+    std::lock_guard<std::mutex> guard(m_outputMutex);
+    std::vector<std::string> assets;
+    for (Reading* reading : m_outputReadings) {
+        assets.push_back(reading->getAssetName());
+    }
+    return assets;
+}
+
+void HnzFilterFixture::outputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    auto fixture = static_cast<HnzFilterFixture*>(handle);
+    std::lock_guard<std::mutex> guard(fixture->m_outputMutex);
+    for (Reading* reading : readingSet->getAllReadings()) {
+        if (reading->getAssetName() == STATISTICS_ASSET_NAME) {
+            fixture->m_lastStatisticsJson = reading->toJSON();
+            fixture->m_statisticsReadings++;
+        }
+        else {
+            fixture->m_outputJsons.push_back(reading->toJSON());
+            fixture->m_outputReadings.push_back(new Reading(*reading));
+        }
+    }
+    fixture->m_outputThreads.push_back(std::this_thread::get_id());
+    delete readingSet;
+}
@@ -0,0 +1,99 @@
+#ifndef _HNZ_FILTER_FIXTURE_H
+#define _HNZ_FILTER_FIXTURE_H
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <gtest/gtest.h>
+#include <plugin_api.h>
+#include <config_category.h>
+#include <filter.h>
+
+class HNZPivotFilter;
+class Reading;
+
+extern "C" {
+    PLUGIN_INFORMATION *plugin_info();
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_reconfigure(PLUGIN_HANDLE handle, const std::string& newConfig);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+/*
+ * Fixture of the unit tests running readings through a filter instance created with the plugin API.
+ * The fixture is the output handle of the filter: the readings forwarded are recorded, the statistics
+ * readings apart from the others.
+ */
+class HnzFilterFixture : public testing::Test
+{
+protected:
+    HnzFilterFixture();
+    ~HnzFilterFixture() override;
+
+    void TearDown() override;
+
+    /**
+     * Create the filter with m_config, all items not set by the test have their default value
+     * @param pointCount : Number of points of the exchanged data generated by HnzTrafficGenerator,
+     * 0 to keep the exchanged_data of m_config
+     * @return The filter created
+    */
+    HNZPivotFilter* initFilter(int pointCount = 4);
+    /**
+     * Reconfigure the filter with m_config
+    */
+    void reconfigure();
+    /**
+     * Reconfigure the filter with an invalid value of an item and check that it is ignored, the previous
+     * value of the item is then restored in m_config
+     * @param item : Name of the configuration item
+     * @param invalidValue : Value to reject
+     * @param getter : Returns the setting of the filter, which must not change
+    */
+    template <class Getter>
+    void checkInvalidIgnored(const std::string& item, const std::string& invalidValue, Getter getter) {
+        auto before = getter();
+        std::string value = m_config.getValue(item);
+        m_config.setValue(item, invalidValue);
+        ASSERT_NO_THROW(reconfigure());
+        ASSERT_EQ(getter(), before) << item << ": " << invalidValue;
+        m_config.setValue(item, value);
+    }
+    /**
+     * Shutdown the filter before the end of the test, otherwise it is shutdown after the test
+    */
+    void shutdownFilter();
+
+    void clearOutputs();
+    /**
+     * @param pattern : String to search
+     * @return Number of JSON of the readings forwarded containing the string
+    */
+    size_t countOutputs(const std::string& pattern) const;
+    /**
+     * @return Asset names of the readings forwarded, in order
+    */
+    std::vector<std::string> getOutputAssets();
+
+    static void outputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet);
+
+    ConfigCategory m_config;
+    PLUGIN_HANDLE m_handle = nullptr;
+    HNZPivotFilter* m_filter = nullptr;
+
+    /* Readings forwarded by the filter, statistics readings excluded, as JSON and as copies */
+    std::vector<std::string> m_outputJsons;
+    std::vector<Reading*> m_outputReadings;
+    /* Thread of each call of the output stream */
+    std::vector<std::thread::id> m_outputThreads;
+    std::string m_lastStatisticsJson;
+    int m_statisticsReadings = 0;
+    /* Taken by the output stream, for the tests converting the readings in the thread of the ingest queue */
+    std::mutex m_outputMutex;
+};
+
+#endif /* _HNZ_FILTER_FIXTURE_H */
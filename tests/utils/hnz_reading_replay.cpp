@@ -0,0 +1,182 @@
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <plugin_api.h>
+#include <reading.h>
+#include <reading_set.h>
+#include <filter.h>
+
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_reading_replay.hpp"
+#include "hnz_test_readings.hpp"
+
+extern "C" {
+    PLUGIN_HANDLE plugin_init(ConfigCategory* config,
+                          OUTPUT_HANDLE *outHandle,
+                          OUTPUT_STREAM output);
+    void plugin_shutdown(PLUGIN_HANDLE handle);
+    void plugin_ingest(PLUGIN_HANDLE handle, READINGSET *readingSet);
+};
+
+static void recordOutputStream(OUTPUT_HANDLE* handle, READINGSET* readingSet)
+{
+    auto output = static_cast<std::vector<std::string>*>(handle);
+    for (Reading* reading : readingSet->getAllReadings()) {
+        // Statistics readings are timestamped at the time of the replay, they cannot be compared
+        if (reading->getAssetName() != STATISTICS_ASSET_NAME) {
+            output->push_back(reading->toJSON(true));
+        }
+    }
+    delete readingSet;
+}
+
+static int64_t userTimestampUs(const Reading& reading)
+{
+    struct timeval tv;
+    reading.getUserTimestamp(&tv);
+    return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+}
+
+std::string HnzReplayReport::toString() const
+{
+    std::ostringstream os;
+    os << readings << " readings in " << batches << " batches, " << elapsedSeconds << " s, "
+       << throughput() << " readings/s" << std::endl;
+    os << "plugin_ingest latency (ns): mean=" << latency.mean() << " min=" << latency.min
+       << " p50=" << latency.percentile(50) << " p90=" << latency.percentile(90)
+       << " p99=" << latency.percentile(99) << " p99.9=" << latency.percentile(99.9)
+       << " max=" << latency.max;
+    return os.str();
+}
+
+HnzReadingReplay::HnzReadingReplay(const std::vector<std::string>& captureLines)
+{
+    for (const std::string& line : captureLines) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        m_readings.emplace_back(HnzTestReadings::readingFromJSON(line));
+    }
+}
+
+HnzReplayReport HnzReadingReplay::run(ConfigCategory* config, const HnzReplayOptions& options) const
+{
+    HnzReplayReport report;
+    unsigned int batchSize = options.batchSize > 0 ? options.batchSize : 1;
+    double speed = options.speed > 0 ? options.speed : 1.0;
+
+    // Build all reading sets beforehand so that only plugin_ingest and pacing are part of the replay time
+    std::vector<ReadingSet*> batches;
+    std::vector<int64_t> batchOffsetsUs;
+    int64_t firstTimestampUs = m_readings.empty() ? 0 : userTimestampUs(*m_readings.front());
+    for (size_t i = 0; i < m_readings.size(); i += batchSize) {
+        std::vector<Reading*> readings;
+        for (size_t j = i; j < m_readings.size() && j < i + batchSize; j++) {
+            readings.push_back(new Reading(*m_readings[j]));
+        }
+        batches.push_back(HnzTestReadings::createReadingSet(readings));
+        batchOffsetsUs.push_back(userTimestampUs(*m_readings[i]) - firstTimestampUs);
+    }
+
+    PLUGIN_HANDLE handle = plugin_init(config, static_cast<OUTPUT_HANDLE*>(&report.output), recordOutputStream);
+
+    HnzPivotHistogram latency;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < batches.size(); i++) {
+        if (options.paced && batchOffsetsUs[i] > 0) {
+            auto offset = std::chrono::microseconds(static_cast<int64_t>(batchOffsetsUs[i] / speed));
+            std::this_thread::sleep_until(start + offset);
+        }
+        report.readings += batches[i]->getCount();
+        auto ingestStart = std::chrono::steady_clock::now();
+        plugin_ingest(handle, batches[i]);
+        auto ingestEnd = std::chrono::steady_clock::now();
+        latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(ingestEnd - ingestStart).count());
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    plugin_shutdown(handle);
+
+    report.batches = batches.size();
+    report.elapsedSeconds = std::chrono::duration<double>(end - start).count();
+    report.latency = latency.snapshot();
+    return report;
+}
+
+/*
+ * Replace the numeric value of the given keys by a placeholder
+ */
+static std::string maskValues(const std::string& json, const std::vector<std::string>& keys)
+{
+    std::string masked(json);
+    for (const std::string& key : keys) {
+        const std::string pattern = "\"" + key + "\":";
+        size_t pos = 0;
+        while ((pos = masked.find(pattern, pos)) != std::string::npos) {
+            size_t valueStart = pos + pattern.size();
+            size_t valueEnd = masked.find_first_not_of("-0123456789.eE ", valueStart);
+            if (valueEnd == std::string::npos) {
+                valueEnd = masked.size();
+            }
+            masked.replace(valueStart, valueEnd - valueStart, "#");
+            pos = valueStart;
+        }
+    }
+    return masked;
+}
+
+std::vector<std::string> HnzReadingReplay::diff(const std::vector<std::string>& expected, const std::vector<std::string>& actual,
+                                                const std::vector<std::string>& ignoredKeys)
+{
+    std::vector<std::string> differences;
+    size_t lineCount = std::max(expected.size(), actual.size());
+    for (size_t i = 0; i < lineCount; i++) {
+        if (i >= expected.size()) {
+            differences.push_back("line " + std::to_string(i + 1) + ": unexpected output: " + actual[i]);
+        }
+        else if (i >= actual.size()) {
+            differences.push_back("line " + std::to_string(i + 1) + ": missing output: " + expected[i]);
+        }
+        else if (maskValues(expected[i], ignoredKeys) != maskValues(actual[i], ignoredKeys)) {
+            differences.push_back("line " + std::to_string(i + 1) + ": expected: " + expected[i] + " actual: " + actual[i]);
+        }
+    }
+    return differences;
+}
+
+void HnzReadingReplay::record(const ReadingSet& readingSet, std::vector<std::string>& captureLines)
+{
+    for (const Reading* reading : readingSet.getAllReadings()) {
+        captureLines.push_back(reading->toJSON());
+    }
+}
+
+std::vector<std::string> HnzReadingReplay::loadLines(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot open " + path);
+    }
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.find_first_not_of(" \t\r") != std::string::npos) {
+            lines.push_back(line);
+        }
+    }
+    return lines;
+}
+
+void HnzReadingReplay::saveLines(const std::string& path, const std::vector<std::string>& lines)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Cannot write " + path);
+    }
+    for (const std::string& line : lines) {
+        file << line << "\n";
+    }
+}
@@ -0,0 +1,102 @@
+#ifndef _HNZ_READING_REPLAY_H
+#define _HNZ_READING_REPLAY_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "hnz_pivot_histogram.hpp"
+
+class ConfigCategory;
+class Reading;
+class ReadingSet;
+
+/**
+ * Options of a replay
+ */
+struct HnzReplayOptions
+{
+    // Replay at the original pacing given by the readings user timestamps, else at maximum speed
+    bool paced = false;
+    // Speed factor applied to the original pacing
+    double speed = 1.0;
+    // Number of consecutive captured readings sent in each call to plugin_ingest
+    unsigned int batchSize = 1;
+};
+
+/**
+ * Result of a replay
+ */
+struct HnzReplayReport
+{
+    uint64_t readings = 0;
+    uint64_t batches = 0;
+    double elapsedSeconds = 0.0;
+    // Time spent in plugin_ingest for each batch, in nanoseconds
+    HnzPivotHistogram::Snapshot latency;
+    // Output readings, as produced by Reading::toJSON(true)
+    std::vector<std::string> output;
+
+    double throughput() const {return elapsedSeconds > 0 ? readings / elapsedSeconds : 0.0;}
+    std::string toString() const;
+};
+
+/**
+ * Replay of captured south readings through the filter plugin.
+ * A capture is a JSON-lines file holding one reading per line, as produced by Reading::toJSON().
+ */
+class HnzReadingReplay
+{
+public:
+    /**
+     * @param captureLines : Captured readings, one JSON per line, empty lines are ignored
+     * @throw std::invalid_argument if a line is not a valid reading
+     */
+    explicit HnzReadingReplay(const std::vector<std::string>& captureLines);
+
+    size_t size() const {return m_readings.size();}
+
+    /**
+     * Create a filter instance with plugin_init, replay all captured readings through plugin_ingest,
+     * then shut the filter down
+     * @param config : Configuration given to plugin_init
+     * @param options : Pacing and batching of the replay
+     * @return Replay report, with the filter output
+     */
+    HnzReplayReport run(ConfigCategory* config, const HnzReplayOptions& options) const;
+
+    /**
+     * Compare an output to the expected one, line by line. Values of the ignored keys are not compared:
+     * by default the pivot timestamps, as the filter timestamps TM and TS CG at the time of the conversion.
+     * @param expected : Expected output, e.g. loaded from a golden file
+     * @param actual : Output of the replay
+     * @param ignoredKeys : Keys with a numeric value that must not be compared
+     * @return Description of each difference found, empty if outputs are identical
+     */
+    static std::vector<std::string> diff(const std::vector<std::string>& expected, const std::vector<std::string>& actual,
+                                         const std::vector<std::string>& ignoredKeys = {"SecondSinceEpoch", "FractionOfSecond"});
+
+    /**
+     * Append the readings of a reading set to a capture, one JSON per line
+     * @param readingSet : Readings to record
+     * @param captureLines : Capture to append the readings to
+     */
+    static void record(const ReadingSet& readingSet, std::vector<std::string>& captureLines);
+
+    /**
+     * Load a JSON-lines file, skipping empty lines
+     * @throw std::runtime_error if the file cannot be read
+     */
+    static std::vector<std::string> loadLines(const std::string& path);
+    /**
+     * Save a JSON-lines file
+     * @throw std::runtime_error if the file cannot be written
+     */
+    static void saveLines(const std::string& path, const std::vector<std::string>& lines);
+
+private:
+    std::vector<std::shared_ptr<Reading>> m_readings;
+};
+
+#endif /* _HNZ_READING_REPLAY_H */
@@ -0,0 +1,72 @@
+#include <stdexcept>
+#include <reading.h>
+#include <reading_set.h>
+#include <rapidjson/document.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include "hnz_test_readings.hpp"
+
+std::vector<Datapoint*> HnzTestReadings::parseDatapoints(const std::string& json)
+{
+    // Dummy object used to be able to call parseJson()
+    DatapointValue dummyValue("");
+    Datapoint dummyDataPoint({}, dummyValue);
+    std::vector<Datapoint*>* p = dummyDataPoint.parseJson(json);
+    if (p == nullptr) {
+        throw std::invalid_argument("Invalid datapoints JSON: " + json);
+    }
+    std::vector<Datapoint*> datapoints(*p);
+    delete p;
+    return datapoints;
+}
+
+Reading* HnzTestReadings::createReading(const std::string& assetName, const std::vector<std::string>& jsons)
+{
+    std::vector<Datapoint*> allPoints;
+    for (const std::string& json : jsons) {
+        std::vector<Datapoint*> datapoints = parseDatapoints(json);
+        allPoints.insert(allPoints.end(), datapoints.begin(), datapoints.end());
+    }
+    return new Reading(assetName, allPoints);
+}
+
+ReadingSet* HnzTestReadings::createReadingSet(const std::string& assetName, const std::vector<std::string>& jsons)
+{
+    std::vector<Reading*> readings;
+    for (const std::string& json : jsons) {
+        readings.push_back(createReading(assetName, {json}));
+    }
+    return createReadingSet(readings);
+}
+
+ReadingSet* HnzTestReadings::createReadingSet(const std::vector<Reading*>& readings)
+{
+    return new ReadingSet(&readings);
+}
+
+Reading* HnzTestReadings::readingFromJSON(const std::string& json)
+{
+    rapidjson::Document document;
+    if (document.Parse(json.c_str()).HasParseError() || !document.IsObject()) {
+        throw std::invalid_argument("Invalid reading JSON: " + json);
+    }
+    if (!document.HasMember("asset_code") || !document["asset_code"].IsString()) {
+        throw std::invalid_argument("Missing asset_code in reading JSON: " + json);
+    }
+    if (!document.HasMember("reading") || !document["reading"].IsObject()) {
+        throw std::invalid_argument("Missing reading in reading JSON: " + json);
+    }
+
+    // Datapoints are parsed by Fledge from the serialized "reading" object
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    document["reading"].Accept(writer);
+    std::vector<Datapoint*> datapoints = parseDatapoints(buffer.GetString());
+
+    std::string assetName = document["asset_code"].GetString();
+    if (document.HasMember("user_ts") && document["user_ts"].IsString()) {
+        return new Reading(assetName, datapoints, document["user_ts"].GetString());
+    }
+    return new Reading(assetName, datapoints);
+}
@@ -0,0 +1,50 @@
+#ifndef _HNZ_TEST_READINGS_H
+#define _HNZ_TEST_READINGS_H
+
+#include <string>
+#include <vector>
+
+class Datapoint;
+class Reading;
+class ReadingSet;
+
+/*
+ * Helpers building readings from JSON, shared by the unit tests, the benchmarks and the replay harness
+ */
+namespace HnzTestReadings {
+    /**
+     * Parse a JSON object into a list of datapoints, one per member
+     * @param json : JSON object, e.g. {"data_object":{...}}
+     * @return List of newly allocated datapoints
+    */
+    std::vector<Datapoint*> parseDatapoints(const std::string& json);
+    /**
+     * Create a single reading holding the datapoints of all the JSON objects given
+     * @param assetName : Asset name of the reading
+     * @param jsons : JSON objects to parse
+     * @return Newly allocated reading
+    */
+    Reading* createReading(const std::string& assetName, const std::vector<std::string>& jsons);
+    /**
+     * Create a reading set with one reading per JSON object given
+     * @param assetName : Asset name of all readings
+     * @param jsons : JSON objects to parse
+     * @return Newly allocated reading set
+    */
+    ReadingSet* createReadingSet(const std::string& assetName, const std::vector<std::string>& jsons);
+    /**
+     * Create a reading set taking ownership of the given readings
+     * @param readings : Readings to put in the set
+     * @return Newly allocated reading set
+    */
+    ReadingSet* createReadingSet(const std::vector<Reading*>& readings);
+    /**
+     * Rebuild a reading from its JSON representation, as produced by Reading::toJSON()
+     * @param json : JSON representation of the reading
+     * @return Newly allocated reading, with the asset name, user timestamp and datapoints from the JSON
+     * @throw std::invalid_argument if the JSON is not a valid reading
+    */
+    Reading* readingFromJSON(const std::string& json);
+};
+
+#endif /* _HNZ_TEST_READINGS_H */
@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <stdexcept>
+#include <reading.h>
+#include <reading_set.h>
+
+#include "hnz_pivot_filter_config.hpp"
+#include "hnz_traffic_generator.hpp"
+
+constexpr int HnzTrafficGenerator::KIND_COUNT;
+
+static Datapoint* createDp(const std::string& name)
+{
+    auto datapoints = new std::vector<Datapoint*>;
+
+    DatapointValue dpv(datapoints, true);
+
+    return new Datapoint(name, dpv);
+}
+
+static void addElementWithValue(Datapoint* dp, const std::string& name, long value)
+{
+    DatapointValue dpv(value);
+
+    dp->getData().getDpVec()->push_back(new Datapoint(name, dpv));
+}
+
+static void addElementWithValue(Datapoint* dp, const std::string& name, const std::string& value)
+{
+    DatapointValue dpv(value);
+
+    dp->getData().getDpVec()->push_back(new Datapoint(name, dpv));
+}
+
+HnzTrafficGenerator::HnzTrafficGenerator(const std::string& exchangedData, const HnzTrafficProfile& profile):
+    m_profile(profile),
+    m_random(profile.seed),
+    m_kindDistribution({profile.tsWeight, profile.tmWeight, profile.tcWeight, profile.tvcWeight})
+{
+    HNZPivotConfig config;
+    config.importExchangeConfig(exchangedData);
+    for (const auto& it : config.getExchangeDefinitions()) {
+        const std::shared_ptr<HNZPivotDataPoint>& dp = it.second;
+        for (int i = 0; i < KIND_COUNT; i++) {
+            if (dp->getTypeId() == KindStr(static_cast<Kind>(i))) {
+                m_addresses[i].push_back(dp->getAddress());
+                m_labels[std::make_pair(static_cast<Kind>(i), dp->getAddress())] = dp->getLabel();
+            }
+        }
+        m_unknownAddress = std::max(m_unknownAddress, dp->getAddress() + 1);
+    }
+
+    const double weights[KIND_COUNT] = {profile.tsWeight, profile.tmWeight, profile.tcWeight, profile.tvcWeight};
+    for (int i = 0; i < KIND_COUNT; i++) {
+        if (weights[i] > 0 && m_addresses[i].empty()) {
+            throw std::invalid_argument("No " + KindStr(static_cast<Kind>(i)) + " point defined in exchanged_data");
+        }
+        std::sort(m_addresses[i].begin(), m_addresses[i].end());
+    }
+}
+
+bool HnzTrafficGenerator::m_draw(double rate)
+{
+    return rate > 0 && m_rateDistribution(m_random) < rate;
+}
+
+HnzTrafficGenerator::Kind HnzTrafficGenerator::m_drawKind()
+{
+    return static_cast<Kind>(m_kindDistribution(m_random));
+}
+
+Reading* HnzTrafficGenerator::nextReading()
+{
+    Kind kind = m_drawKind();
+    const std::vector<unsigned int>& addresses = m_addresses[static_cast<int>(kind)];
+    bool unknownAddress = m_draw(m_profile.unknownAddressRate);
+    unsigned int address = unknownAddress ? m_unknownAddress : addresses[m_random() % addresses.size()];
+    bool invalid = m_draw(m_profile.invalidRate);
+
+    Datapoint* dataObject = createDp("data_object");
+    addElementWithValue(dataObject, "do_type", KindStr(kind));
+    addElementWithValue(dataObject, "do_station", 12L);
+    addElementWithValue(dataObject, "do_addr", static_cast<long>(address));
+    addElementWithValue(dataObject, "do_valid", invalid ? 1L : 0L);
+
+    m_counters.byKind[static_cast<int>(kind)]++;
+    m_counters.total++;
+    if (unknownAddress) {
+        m_counters.unknownAddress++;
+    }
+    if (invalid) {
+        m_counters.invalid++;
+    }
+
+    if (kind == Kind::TS || kind == Kind::TM) {
+        // Outdated values are sent without do_value by the HNZ south plugin
+        bool outdated = m_draw(m_profile.outdatedRate);
+        addElementWithValue(dataObject, "do_outdated", outdated ? 1L : 0L);
+        if (outdated) {
+            m_counters.outdated++;
+        }
+
+        if (kind == Kind::TS) {
+            if (!outdated) {
+                addElementWithValue(dataObject, "do_value", static_cast<long>(m_random() % 2));
+            }
+            bool cg = m_draw(m_profile.cgRatio);
+            addElementWithValue(dataObject, "do_cg", cg ? 1L : 0L);
+            if (cg) {
+                m_counters.cg++;
+            }
+            else {
+                m_timestamp += 10;
+                addElementWithValue(dataObject, "do_ts", m_timestamp);
+                addElementWithValue(dataObject, "do_ts_iv", 0L);
+                addElementWithValue(dataObject, "do_ts_c", m_draw(m_profile.tsCRate) ? 1L : 0L);
+                addElementWithValue(dataObject, "do_ts_s", m_draw(m_profile.tsSRate) ? 1L : 0L);
+            }
+        }
+        else {
+            static const char* analogTypes[] = {"TMA", "TM8", "TM16"};
+            static const long minValues[] = {-127, 0, -32768};
+            static const long maxValues[] = {127, 255, 32767};
+            int analogType = static_cast<int>(m_random() % 3);
+            addElementWithValue(dataObject, "do_an", std::string(analogTypes[analogType]));
+            if (!outdated) {
+                long range = maxValues[analogType] - minValues[analogType] + 1;
+                addElementWithValue(dataObject, "do_value", minValues[analogType] + static_cast<long>(m_random() % range));
+            }
+        }
+    }
+
+    // The south plugin uses the label of the point as asset name
+    std::string assetName = unknownAddress ? KindStr(kind) + std::to_string(address) : m_labels[std::make_pair(kind, address)];
+    return new Reading(assetName, dataObject);
+}
+
+ReadingSet* HnzTrafficGenerator::nextBatch()
+{
+    auto readings = new std::vector<Reading*>();
+    readings->reserve(m_profile.batchSize);
+    for (unsigned int i = 0; i < m_profile.batchSize; i++) {
+        readings->push_back(nextReading());
+    }
+    auto readingSet = new ReadingSet(readings);
+    delete readings;
+    return readingSet;
+}
+
+std::string HnzTrafficGenerator::KindStr(Kind kind)
+{
+    switch (kind) {
+        case Kind::TS:
+            return "TS";
+        case Kind::TM:
+            return "TM";
+        case Kind::TC:
+            return "TC";
+        case Kind::TVC:
+            return "TVC";
+    }
+    return "";
+}
+
+std::string HnzTrafficGenerator::generateExchangedData(int pointCount)
+{
+    static const char* pivotTypes[KIND_COUNT] = {"SpsTyp", "MvTyp", "SpcTyp", "IncTyp"};
+    std::string json = "{\"exchanged_data\":{\"name\":\"SYNTHETIC\",\"version\":\"1.0\",\"datapoints\":[";
+    for (int i = 0; i < pointCount; i++) {
+        if (i > 0) {
+            json += ",";
+        }
+        int kind = i % KIND_COUNT;
+        json += "{\"label\":\"P" + std::to_string(i) + "\",\"pivot_id\":\"ID" + std::to_string(100000 + i) +
+                "\",\"pivot_type\":\"" + pivotTypes[kind] + "\",\"protocols\":[{\"name\":\"hnzip\",\"address\":\"" +
+                std::to_string(i) + "\",\"typeid\":\"" + KindStr(static_cast<Kind>(kind)) + "\"}]}";
+    }
+    return json + "]}}";
+}
@@ -0,0 +1,112 @@
+#ifndef _HNZ_TRAFFIC_GENERATOR_H
+#define _HNZ_TRAFFIC_GENERATOR_H
+
+#include <array>
+#include <cstdint>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+class Reading;
+class ReadingSet;
+
+/**
+ * Composition of the traffic produced by HnzTrafficGenerator.
+ * Weights are relative to each other, rates are probabilities in [0..1].
+ */
+struct HnzTrafficProfile
+{
+    double tsWeight = 1.0;
+    double tmWeight = 1.0;
+    double tcWeight = 0.0;
+    double tvcWeight = 0.0;
+    // Share of TS sent as general interrogation (CG) instead of event (CE)
+    double cgRatio = 0.0;
+    // Quality flags rates
+    double invalidRate = 0.0;
+    double outdatedRate = 0.0;
+    double tsCRate = 0.0;
+    double tsSRate = 0.0;
+    // Share of readings using an address absent from exchanged_data
+    double unknownAddressRate = 0.0;
+    // Number of readings in each generated ReadingSet
+    unsigned int batchSize = 100;
+    unsigned int seed = 42;
+};
+
+/**
+ * Generator of synthetic data_object readings, as sent by the HNZ south plugin,
+ * for the points defined in an exchanged_data configuration.
+ */
+class HnzTrafficGenerator
+{
+public:
+    enum class Kind {
+        TS,
+        TM,
+        TC,
+        TVC
+    };
+    static constexpr int KIND_COUNT = 4;
+
+    /*
+     * Count of generated readings, by category
+     */
+    struct Counters {
+        std::array<uint64_t, KIND_COUNT> byKind{};
+        uint64_t cg = 0;
+        uint64_t invalid = 0;
+        uint64_t outdated = 0;
+        uint64_t unknownAddress = 0;
+        uint64_t total = 0;
+    };
+
+    /**
+     * @param exchangedData : exchanged_data JSON, as given in the filter configuration
+     * @param profile : Composition of the traffic to generate
+     * @throw std::invalid_argument if no point of a kind with a non zero weight is defined in exchangedData
+     */
+    HnzTrafficGenerator(const std::string& exchangedData, const HnzTrafficProfile& profile);
+
+    /**
+     * Generate the next reading
+     * @return Newly allocated reading
+     */
+    Reading* nextReading();
+
+    /**
+     * Generate the next batch of profile.batchSize readings
+     * @return Newly allocated reading set
+     */
+    ReadingSet* nextBatch();
+
+    const Counters& getCounters() const {return m_counters;}
+    size_t getPointCount(Kind kind) const {return m_addresses[static_cast<int>(kind)].size();}
+
+    static std::string KindStr(Kind kind);
+
+    /**
+     * Build an exchanged_data JSON defining pointCount points, alternating TS, TM, TC and TVC,
+     * the point of index i having the address i and the pivot id "ID" + (100000 + i)
+     * @param pointCount : Number of points to define
+     * @return exchanged_data JSON
+     */
+    static std::string generateExchangedData(int pointCount);
+
+private:
+    Kind m_drawKind();
+    bool m_draw(double rate);
+
+    HnzTrafficProfile m_profile;
+    std::array<std::vector<unsigned int>, KIND_COUNT> m_addresses;
+    std::map<std::pair<Kind, unsigned int>, std::string> m_labels;
+    unsigned int m_unknownAddress = 0;
+    std::mt19937 m_random;
+    std::discrete_distribution<int> m_kindDistribution;
+    std::uniform_real_distribution<double> m_rateDistribution{0.0, 1.0};
+    Counters m_counters;
+    long m_timestamp = 1685019425432;
+};
+
+#endif /* _HNZ_TRAFFIC_GENERATOR_H */